@@ -0,0 +1,1447 @@
+#ifndef BENCH_INL
+#define BENCH_INL
+
+// Benchmarks and checks behind `atlas --bench` (run_benchmarks), with the
+// reference implementations they measure the runtime paths against. They
+// need no window or GL context. Included at the end of main.cpp, after every
+// definition it tests, so the build stays the one main.cpp translation unit.
+
+// ----------------- Reference implementations -----------------
+// The per-face mesh normals and plain eased vertices chunks were built from
+// before analytic gradients; bench_analytic_normals compares against them.
+static std::vector<float> generate_normals(const std::vector<int> &indices, const std::vector<float> &vertices) {
+    int nVerts = (int)vertices.size() / 3;
+    std::vector<glm::vec3> acc(nVerts, glm::vec3(0.0f));
+    std::vector<float> normals(vertices.size(), 0.0f);
+
+    for (int i = 0; i < (int)indices.size(); i += 3) {
+        int i0 = indices[i], i1 = indices[i+1], i2 = indices[i+2];
+
+        glm::vec3 v0(vertices[i0*3+0], vertices[i0*3+1], vertices[i0*3+2]);
+        glm::vec3 v1(vertices[i1*3+0], vertices[i1*3+1], vertices[i1*3+2]);
+        glm::vec3 v2(vertices[i2*3+0], vertices[i2*3+1], vertices[i2*3+2]);
+
+        glm::vec3 n = glm::normalize(glm::cross(v1 - v0, v2 - v0));
+        acc[i0] += n; acc[i1] += n; acc[i2] += n;
+    }
+
+    for (int v = 0; v < nVerts; v++) {
+        glm::vec3 n = glm::normalize(acc[v]);
+        normals[v*3+0] = n.x;
+        normals[v*3+1] = n.y;
+        normals[v*3+2] = n.z;
+    }
+    return normals;
+}
+
+static std::vector<float> generate_vertices(const std::vector<float> &noise_map) {
+    std::vector<float> v;
+
+    for (int y = 0; y < chunkHeight; y++) {
+        for (int x = 0; x < chunkWidth; x++) {
+            v.push_back((float)x);
+            float e = noise_map[x + y * chunkWidth] * 1.1f;
+            float easedNoise = e * e * e;
+            v.push_back(std::fmax(easedNoise * meshHeight, WATER_HEIGHT * 0.5f * meshHeight));
+            v.push_back((float)y);
+        }
+    }
+    return v;
+}
+
+// Copy of the original per-sample generate_noise_map loop (double-precision
+// perlin_noise, one call per sample and octave). The benchmarks time the
+// current paths against it and check they stay within NOISE_BATCH_TOLERANCE.
+static std::vector<float> generate_noise_map_reference(int offsetX, int offsetY) {
+    std::vector<float> noiseValues;
+    const uint8_t *p = g_noiseContext->perm;
+
+    float maxPossibleHeight = 0.0f;
+    float amp = 1.0f;
+    for (int i = 0; i < octaves; i++) {
+        maxPossibleHeight += amp;
+        amp *= persistence;
+    }
+
+    for (int y = 0; y < chunkHeight; y++) {
+        for (int x = 0; x < chunkWidth; x++) {
+            amp = 1.0f;
+            float freq = 1.0f;
+            float noiseHeight = 0.0f;
+            for (int i = 0; i < octaves; i++) {
+                float xSample = (x + offsetX * (chunkWidth - 1)) / noiseScale * freq;
+                float ySample = (y + offsetY * (chunkHeight - 1)) / noiseScale * freq;
+                noiseHeight += (float)perlin_noise(xSample, ySample, p) * amp;
+                amp *= persistence;
+                freq *= lacunarity;
+            }
+            noiseValues.push_back((noiseHeight + 1.0f) / maxPossibleHeight);
+        }
+    }
+    return noiseValues;
+}
+
+// The previous batched path: one perlin_noise_row call per row and octave,
+// with amp / freq / maxPossibleHeight tracked at runtime and a separate
+// normalization pass. Kept to measure the fused fBm kernel against.
+static std::vector<float> generate_noise_map_octave_rows(int offsetX, int offsetY, SimdLevel level) {
+    std::vector<float> noiseValues(chunkWidth * chunkHeight, 0.0f);
+    std::vector<float> normalizedNoiseValues;
+    const uint8_t *p = g_noiseContext->perm;
+
+    // one row of sample coordinates / noise values, evaluated per octave in a single batch call
+    std::vector<float> xSamples(chunkWidth);
+    std::vector<float> rowNoise(chunkWidth);
+
+    float amp = 1.0f;
+    float freq = 1.0f;
+    float maxPossibleHeight = 0.0f;
+
+    for (int i = 0; i < octaves; i++) {
+        maxPossibleHeight += amp;
+        amp *= persistence;
+    }
+
+    for (int y = 0; y < chunkHeight; y++) {
+        float *noiseHeight = &noiseValues[y * chunkWidth];
+        amp = 1.0f;
+        freq = 1.0f;
+        for (int i = 0; i < octaves; i++) {
+            for (int x = 0; x < chunkWidth; x++)
+                xSamples[x] = (x + offsetX * (chunkWidth - 1)) / noiseScale * freq;
+            float ySample = (y + offsetY * (chunkHeight - 1)) / noiseScale * freq;
+
+            perlin_noise_row(xSamples.data(), ySample, rowNoise.data(), chunkWidth, p, level);
+            for (int x = 0; x < chunkWidth; x++)
+                noiseHeight[x] += rowNoise[x] * amp;
+
+            amp *= persistence;
+            freq *= lacunarity;
+        }
+    }
+
+    for (int y = 0; y < chunkHeight; y++) {
+        for (int x = 0; x < chunkWidth; x++) {
+            normalizedNoiseValues.push_back((noiseValues[x + y * chunkWidth] + 1.0f) / maxPossibleHeight);
+        }
+    }
+
+    return normalizedNoiseValues;
+}
+
+// ----------------- Benchmarks -----------------
+// Heap allocations so far; the benchmarks diff it around a call to count what that call allocates.
+// Only operator new is replaced: it takes its memory from malloc like the library's own, which the
+// library's operator delete frees. Kept out of line so the compiler does not pair its malloc with
+// those deletes.
+static std::atomic<size_t> g_allocCount(0);
+
+__attribute__((noinline)) void *operator new(std::size_t size) {
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *mem = std::malloc(size ? size : 1)) return mem;
+    throw std::bad_alloc();
+}
+
+static volatile float g_benchSink = 0.0f;
+
+template <typename Fn>
+static double bench_ms(int reps, Fn &&fn) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; r++) fn();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(t1 - t0).count() / reps;
+}
+
+static float max_abs_diff(const std::vector<float> &a, const std::vector<float> &b) {
+    float m = (a.size() == b.size()) ? 0.0f : INFINITY;
+    for (size_t i = 0; i < a.size() && i < b.size(); i++) m = std::max(m, std::fabs(a[i] - b[i]));
+    return m;
+}
+
+static bool bench_perlin_batch() {
+    const SimdLevel levels[] = { SimdLevel::SCALAR, SimdLevel::SSE41, SimdLevel::AVX2 };
+    const SimdLevel savedLevel = noiseSimdLevel;
+    bool ok = true;
+
+    const uint8_t *p = g_noiseContext->perm;
+    const int nSamples = chunkWidth * chunkHeight * octaves;
+
+    printf("\n== perlin batch: %d samples (one chunk, %d octaves) ==\n", nSamples, octaves);
+    printf("%-16s %12s %14s %9s\n", "path", "ms/chunk", "Msamples/s", "speedup");
+
+    double refMs = bench_ms(20, [&] {
+        float acc = 0.0f;
+        for (int i = 0, freq = 1; i < octaves; i++, freq *= 2)
+            for (int y = 0; y < chunkHeight; y++)
+                for (int x = 0; x < chunkWidth; x++)
+                    acc += (float)perlin_noise(x / noiseScale * freq, y / noiseScale * freq, p);
+        g_benchSink = acc;
+    });
+    printf("%-16s %12.3f %14.2f %8.2fx\n", "perlin_noise", refMs, nSamples / refMs / 1e3, 1.0);
+
+    std::vector<float> xs(chunkWidth), out(chunkWidth);
+    for (SimdLevel level : levels) {
+        if (clamp_simd_level(level) != level) continue;
+        double ms = bench_ms(100, [&] {
+            float acc = 0.0f;
+            for (int i = 0, freq = 1; i < octaves; i++, freq *= 2)
+                for (int y = 0; y < chunkHeight; y++) {
+                    for (int x = 0; x < chunkWidth; x++) xs[x] = x / noiseScale * freq;
+                    perlin_noise_row(xs.data(), y / noiseScale * freq, out.data(), chunkWidth, p, level);
+                    acc += out[y % chunkWidth];
+                }
+            g_benchSink = acc;
+        });
+        printf("%-16s %12.3f %14.2f %8.2fx\n",
+               (std::string("row/") + simd_level_name(level)).c_str(), ms, nSamples / ms / 1e3, refMs / ms);
+    }
+
+    printf("\n== generate_noise_map per chunk ==\n");
+    printf("%-16s %12s %9s %12s\n", "path", "ms/chunk", "speedup", "max |err|");
+    double refChunkMs = bench_ms(10, [&] { g_benchSink = generate_noise_map_reference(3, 4)[0]; });
+    printf("%-16s %12.3f %8.2fx %12s\n", "reference", refChunkMs, 1.0, "-");
+
+    std::vector<float> ref = generate_noise_map_reference(3, 4);
+    for (SimdLevel level : levels) {
+        if (clamp_simd_level(level) != level) continue;
+        noiseSimdLevel = level;
+        double ms = bench_ms(50, [&] { g_benchSink = generate_noise_map(3, 4)[0]; });
+        float err = max_abs_diff(ref, generate_noise_map(3, 4));
+        ok = ok && err <= NOISE_BATCH_TOLERANCE;
+        printf("%-16s %12.3f %8.2fx %12.2e%s\n", simd_level_name(level), ms, refChunkMs / ms, err,
+               err <= NOISE_BATCH_TOLERANCE ? "" : "  FAIL");
+    }
+    noiseSimdLevel = savedLevel;
+    return ok;
+}
+
+static bool bench_fbm() {
+    const int savedOctaves = octaves;
+    const SimdLevel level = clamp_simd_level(SimdLevel::AVX2);
+    const uint8_t *p = g_noiseContext->perm;
+    bool ok = true;
+
+    // generate_noise_map body with the weights type pinned, so the runtime-table kernel can be timed too
+    std::vector<float> xs(chunkWidth), chunk(chunkWidth * chunkHeight);
+    auto fbm_chunk = [&](auto weights) {
+        for (int x = 0; x < chunkWidth; x++) xs[x] = (x + 3 * (chunkWidth - 1)) / noiseScale;
+        for (int y = 0; y < chunkHeight; y++)
+            fbm_noise_row<decltype(weights)>(xs.data(), (y + 4 * (chunkHeight - 1)) / noiseScale,
+                                             &chunk[y * chunkWidth], chunkWidth, p, octaves, weights, level);
+        return chunk;
+    };
+    const FbmRuntimeWeights runtimeWeights(0.5f, 2.0f);
+    const FbmStaticWeights<FbmClassicParams> staticWeights;
+
+    printf("\n== fBm per chunk (%s) ==\n", simd_level_name(level));
+    printf("%-8s %-16s %12s %9s %12s\n", "octaves", "path", "ms/chunk", "speedup", "max |err|");
+    for (int o : { 5, FBM_MAX_OCTAVES }) {
+        octaves = o;
+        std::vector<float> ref = generate_noise_map_reference(3, 4);
+        double baseMs = bench_ms(50, [&] { g_benchSink = generate_noise_map_octave_rows(3, 4, level)[0]; });
+        printf("%-8d %-16s %12.3f %8.2fx %12.2e\n", o, "octave rows", baseMs, 1.0,
+               max_abs_diff(ref, generate_noise_map_octave_rows(3, 4, level)));
+
+        double runtimeMs = bench_ms(50, [&] { g_benchSink = fbm_chunk(runtimeWeights)[0]; });
+        float runtimeErr = max_abs_diff(ref, fbm_chunk(runtimeWeights));
+        double staticMs = bench_ms(50, [&] { g_benchSink = fbm_chunk(staticWeights)[0]; });
+        float staticErr = max_abs_diff(ref, fbm_chunk(staticWeights));
+        ok = ok && runtimeErr <= NOISE_BATCH_TOLERANCE && staticErr <= NOISE_BATCH_TOLERANCE;
+
+        printf("%-8d %-16s %12.3f %8.2fx %12.2e%s\n", o, "fbm<N> runtime", runtimeMs, baseMs / runtimeMs,
+               runtimeErr, runtimeErr <= NOISE_BATCH_TOLERANCE ? "" : "  FAIL");
+        printf("%-8d %-16s %12.3f %8.2fx %12.2e%s\n", o, "fbm<N> constexpr", staticMs, baseMs / staticMs,
+               staticErr, staticErr <= NOISE_BATCH_TOLERANCE ? "" : "  FAIL");
+    }
+    octaves = savedOctaves;
+    return ok;
+}
+
+static bool bench_analytic_normals() {
+    const uint8_t *p = g_noiseContext->perm;
+    bool ok = true;
+
+    // perlin_noise_d against central differences of perlin_noise
+    double maxDerivErr = 0.0;
+    const double h = 1e-3;
+    for (int i = 0; i < 4096; i++) {
+        float x = (i % 64) * 0.173f + 0.01f, y = (i / 64) * 0.131f + 0.01f;
+        double dx, dy;
+        perlin_noise_d(x, y, p, dx, dy);
+        double fdx = (perlin_noise(x + (float)h, y, p) - perlin_noise(x - (float)h, y, p)) / (2 * h);
+        double fdy = (perlin_noise(x, y + (float)h, p) - perlin_noise(x, y - (float)h, p)) / (2 * h);
+        maxDerivErr = std::max(maxDerivErr, std::max(std::fabs(dx - fdx), std::fabs(dy - fdy)));
+    }
+    ok = ok && maxDerivErr < 1e-2;
+
+    // reference normals: double-precision perlin_noise_d per sample, same chain rule
+    const int nSamples = chunkWidth * chunkHeight;
+    float maxPossibleHeight = 0.0f;
+    for (int i = 0; i < octaves; i++) maxPossibleHeight += std::pow(persistence, (float)i);
+    std::vector<glm::vec3> refNormals(nSamples);
+    for (int y = 0; y < chunkHeight; y++) {
+        for (int x = 0; x < chunkWidth; x++) {
+            float amp = 1.0f, freq = 1.0f;
+            double n = 0.0, dndx = 0.0, dndz = 0.0;
+            for (int i = 0; i < octaves; i++) {
+                double dx, dy;
+                float xSample = (x + 3 * (chunkWidth - 1)) / noiseScale * freq;
+                float ySample = (y + 4 * (chunkHeight - 1)) / noiseScale * freq;
+                n += perlin_noise_d(xSample, ySample, p, dx, dy) * amp;
+                dndx += dx * amp * freq;
+                dndz += dy * amp * freq;
+                amp *= persistence;
+                freq *= lacunarity;
+            }
+            eased_vertex((float)((n + 1.0) / maxPossibleHeight),
+                         (float)(dndx / maxPossibleHeight / noiseScale),
+                         (float)(dndz / maxPossibleHeight / noiseScale), refNormals[x + y * chunkWidth]);
+        }
+    }
+
+    std::vector<int> indices = generate_indices(IndexOrder::ROW_MAJOR);
+    double meshMs = bench_ms(20, [&] {
+        std::vector<float> verts = generate_vertices(generate_noise_map(3, 4));
+        g_benchSink = generate_normals(indices, verts)[1];
+    });
+    std::vector<float> gradients, normals;
+    double analyticMs = bench_ms(20, [&] {
+        std::vector<float> heights = generate_height_map(3, 4, gradients);
+        g_benchSink = generate_vertices(heights, gradients, normals)[1];
+    });
+
+    std::vector<float> meshNormals = generate_normals(indices, generate_vertices(generate_noise_map(3, 4)));
+    double maxRefDeg = 0.0, meanMeshDeg = 0.0;
+    for (int i = 0; i < nSamples; i++) {
+        glm::vec3 a(normals[i*3+0], normals[i*3+1], normals[i*3+2]);
+        // mesh normals come out of the triangle winding pointing down; compare against their flip
+        glm::vec3 m(-meshNormals[i*3+0], -meshNormals[i*3+1], -meshNormals[i*3+2]);
+        maxRefDeg = std::max(maxRefDeg, (double)glm::degrees(std::acos(std::fmin(1.0f, glm::dot(a, refNormals[i])))));
+        meanMeshDeg += glm::degrees(std::acos(std::fmin(1.0f, glm::dot(a, m)))) / nSamples;
+    }
+    ok = ok && maxRefDeg < 0.1;
+
+    printf("\n== analytic normals ==\n");
+    printf("perlin_noise_d vs central difference: max |err| %.2e%s\n", maxDerivErr, maxDerivErr < 1e-2 ? "" : "  FAIL");
+    printf("%-28s %12.3f ms/chunk\n", "noise + vertices + normals", meshMs);
+    printf("%-28s %12.3f ms/chunk (%.2fx)\n", "noise_d + vertices", analyticMs, meshMs / analyticMs);
+    printf("max angle vs double reference: %.4f deg%s, mean angle vs mesh normals: %.2f deg\n",
+           maxRefDeg, maxRefDeg < 0.1 ? "" : "  FAIL", meanMeshDeg);
+    return ok;
+}
+
+static bool bench_index_buffer() {
+    const int chunkN = xMapChunks * yMapChunks;
+    double buildMs = bench_ms(50, [&] { g_benchSink = (float)generate_indices(IndexOrder::ROW_MAJOR).size(); });
+    std::vector<int> indices = generate_indices(IndexOrder::ROW_MAJOR);
+    std::vector<uint16_t> narrow(indices.begin(), indices.end());
+    bool fits = std::equal(indices.begin(), indices.end(), narrow.begin());
+    size_t perChunk = indices.size() * sizeof(int), shared = narrow.size() * sizeof(uint16_t);
+
+    printf("\n== terrain index buffer ==\n");
+    printf("per chunk: %.3f ms to build, %zu bytes uploaded (%d chunks: %.1f MB)\n",
+           buildMs, perChunk, chunkN, perChunk * chunkN / 1e6);
+    printf("shared: built once, %zu bytes (%.0fx less index memory), fits 16 bits: %s\n",
+           shared, (double)perChunk * chunkN / shared, fits ? "yes" : "NO");
+    return fits;
+}
+
+// Vertex shader runs for an index stream through a FIFO post-transform cache
+// of cacheSize entries; restart markers only end a strip.
+static size_t simulate_vertex_cache(const std::vector<int> &indices, int cacheSize) {
+    std::vector<int> fifo(cacheSize, -1);
+    size_t misses = 0;
+    int head = 0;
+    for (int v : indices) {
+        if (v == PRIMITIVE_RESTART || std::find(fifo.begin(), fifo.end(), v) != fifo.end()) continue;
+        fifo[head] = v;
+        head = (head + 1) % cacheSize;
+        misses++;
+    }
+    return misses;
+}
+
+// Triangles of an index stream, each rotated to start at its smallest index
+// (so winding is kept), sorted: two streams drawing the same mesh compare equal.
+static std::vector<std::array<int, 3>> canonical_triangles(const std::vector<int> &indices, bool strip) {
+    std::vector<std::array<int, 3>> tris;
+    auto add = [&](int a, int b, int c) {
+        if (b < a && b < c) tris.push_back({ b, c, a });
+        else if (c < a && c < b) tris.push_back({ c, a, b });
+        else tris.push_back({ a, b, c });
+    };
+    if (!strip) {
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) add(indices[i], indices[i + 1], indices[i + 2]);
+    } else {
+        size_t start = 0;
+        for (size_t i = 0; i <= indices.size(); i++) {
+            if (i < indices.size() && indices[i] != PRIMITIVE_RESTART) continue;
+            for (size_t k = start; k + 2 < i; k++) {
+                if ((k - start) % 2 == 0) add(indices[k], indices[k + 1], indices[k + 2]);
+                else                      add(indices[k + 1], indices[k], indices[k + 2]);
+            }
+            start = i + 1;
+        }
+    }
+    std::sort(tris.begin(), tris.end());
+    return tris;
+}
+
+static bool bench_index_order() {
+    const size_t nTriangles = 2 * (size_t)(chunkWidth - 1) * (chunkHeight - 1);
+    const size_t nVertices = (size_t)chunkWidth * chunkHeight;
+    const std::vector<std::array<int, 3>> reference = canonical_triangles(generate_indices(IndexOrder::ROW_MAJOR), false);
+    double rowAcmr = 0.0, blockedAcmr = 0.0;
+    bool sameMesh = true;
+
+    printf("\n== grid index order (FIFO post-transform cache) ==\n");
+    printf("%-8s %8s %8s %14s %14s %9s\n", "order", "indices", "bytes", "ACMR/ATVR @16", "ACMR/ATVR @32", "build ms");
+    for (int o = 0; o < INDEX_ORDER_COUNT; o++) {
+        IndexOrder order = (IndexOrder)o;
+        double buildMs = bench_ms(20, [&] { g_benchSink = (float)generate_indices(order).size(); });
+        std::vector<int> indices = generate_indices(order);
+        size_t m16 = simulate_vertex_cache(indices, 16), m32 = simulate_vertex_cache(indices, 32);
+        printf("%-8s %8zu %8zu %7.3f/%5.2f %7.3f/%5.2f %9.3f\n", index_order_name(order), indices.size(),
+               indices.size() * sizeof(uint16_t), (double)m16 / nTriangles, (double)m16 / nVertices,
+               (double)m32 / nTriangles, (double)m32 / nVertices, buildMs);
+        if (order == IndexOrder::ROW_MAJOR) rowAcmr = (double)m32 / nTriangles;
+        if (order == IndexOrder::BLOCKED) blockedAcmr = (double)m32 / nTriangles;
+        sameMesh = canonical_triangles(indices, order == IndexOrder::STRIPS) == reference && sameMesh;
+    }
+    printf("vertex shader runs @32: %.0f%% fewer with blocked; all orders draw the same triangles: %s\n",
+           100.0 * (1.0 - blockedAcmr / rowAcmr), sameMesh ? "yes" : "NO");
+    return sameMesh && blockedAcmr < 0.6 * rowAcmr;
+}
+
+// objectShader.vert's CDLOD morph of grid vertex v drawn at step, in chunk coordinates.
+static glm::vec3 cdlod_morph_vertex(int v, int step, const glm::vec2 &range, const std::vector<float> &verts,
+                                    const glm::vec3 &camLocal) {
+    int x = v % chunkWidth, z = v / chunkWidth;
+    glm::vec3 pos = glm::make_vec3(&verts[3 * v]);
+    int dx = x % (2 * step) == step && x != chunkWidth - 1 ? step : 0;
+    int dz = z % (2 * step) == step && z != chunkHeight - 1 ? step : 0;
+    float k = glm::clamp((glm::distance(pos, camLocal) - range.x) / (range.y - range.x), 0.0f, 1.0f);
+    if (k == 0.0f || (dx == 0 && dz == 0)) return pos;
+    return glm::mix(pos, glm::make_vec3(&verts[3 * ((x - dx) + (z - dz) * chunkWidth)]), k);
+}
+
+// CDLOD at lod_render_distance against full detail at chunk_render_distance,
+// and a crack check: every triangle edge the morphed nodes leave unshared has
+// to lie on the outside of the drawn block of chunks.
+static bool bench_cdlod() {
+    const std::vector<int> nodeIndices = cdlod_indices();
+    const size_t fullTriangles = 2 * (size_t)(chunkWidth - 1) * (chunkHeight - 1);
+    std::vector<std::vector<float>> verts(xMapChunks * yMapChunks), bounds(xMapChunks * yMapChunks);
+    std::vector<plant> plants;
+    GridChunkBuffers buffers;
+    for (int y = 0; y < yMapChunks; y++)
+        for (int x = 0; x < xMapChunks; x++) {
+            build_grid_chunk(x, y, octaves, buffers, verts[x + y * xMapChunks], plants);
+            cdlod_node_bounds(verts[x + y * xMapChunks], bounds[x + y * xMapChunks]);
+        }
+    auto chunk_origin = [](int x, int y) {
+        return glm::vec3(-chunkWidth / 2.0f + (chunkWidth - 1) * x, 0.0f, -chunkHeight / 2.0f + (chunkHeight - 1) * y);
+    };
+    // the chunks render() draws around the camera chunk
+    auto drawn = [](int x, int y, int gx, int gy, int distance) {
+        return std::abs(gx - x) <= distance && (y - gy) <= distance;
+    };
+
+    const float originX = (chunkWidth * xMapChunks) / 2.0f - chunkWidth / 2.0f;
+    const float originZ = (chunkHeight * yMapChunks) / 2.0f - chunkHeight / 2.0f;
+    const glm::vec3 cameras[] = { { originX, 20.0f, originZ }, { originX + 61.3f, 35.0f, originZ - 17.8f },
+                                  { originX - 140.0f, 160.0f, originZ + 90.0f } };
+    printf("\n== CDLOD terrain ==\n");
+    printf("%d levels of %dx%d-quad nodes, node lists %zu indices, morph %.0f..%.0f at level 0\n", cdlod_levels(),
+           CDLOD_NODE_QUADS, CDLOD_NODE_QUADS, nodeIndices.size(), cdlod_morph_range(0).x, cdlod_morph_range(0).y);
+    printf("%-22s %8s %12s %12s %12s %10s %6s\n", "camera", "draws", "cdlod @9", "full @3", "full @9", "select us",
+           "cracks");
+    bool ok = true;
+    std::vector<CdlodDraw> draws;
+    for (const glm::vec3 &cam : cameras) {
+        int gx = (int)std::floor((cam.x - originX) / chunkWidth) + xMapChunks / 2;
+        int gy = (int)std::floor((cam.z - originZ) / chunkHeight) + yMapChunks / 2;
+        size_t lodTriangles = 0, nearChunks = 0, farChunks = 0, nDraws = 0;
+        std::vector<std::pair<uint64_t, uint64_t>> edges;
+        float minX = INFINITY, maxX = -INFINITY, minZ = INFINITY, maxZ = -INFINITY;
+        for (int y = 0; y < yMapChunks; y++) {
+            for (int x = 0; x < xMapChunks; x++) {
+                nearChunks += drawn(x, y, gx, gy, chunk_render_distance);
+                if (!drawn(x, y, gx, gy, lod_render_distance)) continue;
+                farChunks++;
+                const int idx = x + y * xMapChunks;
+                const glm::vec3 origin = chunk_origin(x, y), camLocal = cam - origin;
+                minX = std::min(minX, origin.x); maxX = std::max(maxX, origin.x + chunkWidth - 1);
+                minZ = std::min(minZ, origin.z); maxZ = std::max(maxZ, origin.z + chunkHeight - 1);
+                draws.clear();
+                cdlod_select(bounds[idx], camLocal, draws);
+                nDraws += draws.size();
+                for (const CdlodDraw &d : draws) {
+                    lodTriangles += d.count / 3;
+                    const glm::vec2 range = cdlod_morph_range(d.level);
+                    for (GLsizei i = d.first; i < d.first + d.count; i += 3) {
+                        uint64_t key[3];
+                        for (int c = 0; c < 3; c++) {
+                            glm::vec3 w = origin + cdlod_morph_vertex(nodeIndices[i + c], 1 << d.level, range,
+                                                                      verts[idx], camLocal);
+                            key[c] = (uint64_t)(std::llround(w.x * 1024.0) + (1 << 22)) << 32 |
+                                     (uint64_t)(std::llround(w.z * 1024.0) + (1 << 22));
+                        }
+                        // collapsed by the morph or the clamp; slivers stay, they still stitch the mesh
+                        if (key[0] == key[1] || key[1] == key[2] || key[0] == key[2]) continue;
+                        for (int c = 0; c < 3; c++)
+                            edges.push_back(std::minmax(key[c], key[(c + 1) % 3]));
+                    }
+                }
+            }
+        }
+        double selectMs = bench_ms(20, [&] {
+            size_t n = 0;
+            for (int y = 0; y < yMapChunks; y++)
+                for (int x = 0; x < xMapChunks; x++) {
+                    if (!drawn(x, y, gx, gy, lod_render_distance)) continue;
+                    draws.clear();
+                    cdlod_select(bounds[x + y * xMapChunks], cam - chunk_origin(x, y), draws);
+                    n += draws.size();
+                }
+            g_benchSink = (float)n;
+        });
+
+        // an edge used once is a crack unless it lies on the outside of the block
+        std::sort(edges.begin(), edges.end());
+        auto on_border = [&](uint64_t key) {
+            double x = ((double)(int64_t)(key >> 32) - (1 << 22)) / 1024.0;
+            double z = ((double)(int64_t)(key & 0xffffffffu) - (1 << 22)) / 1024.0;
+            return std::fabs(x - minX) < 1e-2 || std::fabs(x - maxX) < 1e-2 || std::fabs(z - minZ) < 1e-2 ||
+                   std::fabs(z - maxZ) < 1e-2;
+        };
+        size_t cracks = 0;
+        for (size_t i = 0; i < edges.size();) {
+            size_t j = i;
+            while (j < edges.size() && edges[j] == edges[i]) j++;
+            bool outside = on_border(edges[i].first) && on_border(edges[i].second);
+            cracks += (j - i == 1 && !outside) || j - i > 2;
+            i = j;
+        }
+        char label[32];
+        snprintf(label, sizeof(label), "(%.0f, %.0f, %.0f)", cam.x, cam.y, cam.z);
+        printf("%-22s %8zu %12zu %12zu %12zu %10.1f %6zu\n", label, nDraws, lodTriangles, nearChunks * fullTriangles,
+               farChunks * fullTriangles, selectMs * 1e3, cracks);
+        ok = ok && cracks == 0 && lodTriangles < nearChunks * fullTriangles;
+    }
+    return ok;
+}
+
+// Meshes the given chunks' volumes on `threads` throwaway threads (chunks are
+// handed out through an atomic counter), to time the meshing alone; the app
+// builds chunks on the worker pool.
+static std::vector<VolumeChunk> mesh_volume_chunks(const std::vector<glm::ivec2> &coords, unsigned threads) {
+    const int chunkN = (int)coords.size();
+    std::vector<VolumeChunk> chunks(chunkN);
+    std::atomic<int> next(0);
+    auto worker = [&] {
+        for (int i; (i = next++) < chunkN;)
+            generate_volume_chunk(coords[i].x, coords[i].y, chunks[i], noiseSimdLevel);
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < std::max(threads, 1u); t++) pool.emplace_back(worker);
+    worker();
+    for (std::thread &t : pool) t.join();
+    return chunks;
+}
+
+// RTIN index lists of the given grid chunks within maxError, meshed on
+// `threads` threads from g_chunkVertices like mesh_volume_chunks does.
+struct RtinChunk {
+    std::vector<int> indices;
+    double ms;
+};
+
+static std::vector<RtinChunk> mesh_rtin_chunks(const std::vector<int> &positions, float maxError, unsigned threads) {
+    if (g_rtinTile.gridSize != chunkWidth) rtin_build_tile(chunkWidth, g_rtinTile);
+    std::vector<RtinChunk> chunks(positions.size());
+    std::atomic<int> next(0);
+    auto worker = [&] {
+        std::vector<float> errors;
+        for (int i; (i = next++) < (int)positions.size();) {
+            auto t0 = std::chrono::steady_clock::now();
+            rtin_errors(g_rtinTile, g_chunkVertices[positions[i]].data() + 1, 3, true, errors);
+            rtin_mesh(g_rtinTile, errors, maxError, chunks[i].indices);
+            chunks[i].ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < std::max(threads, 1u); t++) pool.emplace_back(worker);
+    worker();
+    for (std::thread &t : pool) t.join();
+    return chunks;
+}
+
+// RTIN meshes of every chunk of the map at a few error bounds, checked
+// against the full grid: height error at every grid sample, winding, every
+// border vertex used, and no edge left unshared inside the chunk.
+static bool bench_rtin() {
+    const int chunkN = xMapChunks * yMapChunks;
+    const long fullTriangles = 2L * (chunkWidth - 1) * (chunkHeight - 1);
+    std::vector<plant> plants;
+    GridChunkBuffers buffers;
+    g_chunkVertices.resize(chunkN);
+    for (int pos = 0; pos < chunkN; pos++)
+        build_grid_chunk(pos % xMapChunks, pos / xMapChunks, octaves, buffers, g_chunkVertices[pos], plants);
+    std::vector<int> positions(chunkN);
+    for (int pos = 0; pos < chunkN; pos++) positions[pos] = pos;
+
+    // winding of the full grid's triangles, in x / z
+    auto cross_xz = [](int a, int b, int c) {
+        int ax = a % chunkWidth, az = a / chunkWidth;
+        return (b % chunkWidth - ax) * (c / chunkWidth - az) - (b / chunkWidth - az) * (c % chunkWidth - ax);
+    };
+    const std::vector<int> grid = generate_indices(IndexOrder::ROW_MAJOR);
+    const int gridWinding = cross_xz(grid[0], grid[1], grid[2]) < 0 ? -1 : 1;
+    auto on_border = [](int v) {
+        int x = v % chunkWidth, z = v / chunkWidth;
+        return x == 0 || z == 0 || x == chunkWidth - 1 || z == chunkHeight - 1;
+    };
+    auto border_edge = [](int a, int b) {
+        int ax = a % chunkWidth, az = a / chunkWidth, bx = b % chunkWidth, bz = b / chunkWidth;
+        return (ax == bx && (ax == 0 || ax == chunkWidth - 1)) || (az == bz && (az == 0 || az == chunkHeight - 1));
+    };
+
+    const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    printf("\n== RTIN chunk meshes (%dx%d grid, borders at full resolution) ==\n", chunkWidth, chunkHeight);
+    printf("%-8s %12s %9s %13s %11s %10s %10s %8s\n", "error", "triangles", "fewer", "best / worst", "max |err|",
+           "ms/chunk", "wall ms", "broken");
+    bool ok = rtin_grid_size_ok(chunkWidth) && chunkWidth == chunkHeight;
+    for (float maxError : { 0.0f, 0.1f, 0.5f, 2.0f }) {
+        double ms = bench_ms(1, [&] { g_benchSink = (float)mesh_rtin_chunks(positions, maxError, 1).size(); });
+        double wallMs = bench_ms(1, [&] { g_benchSink = (float)mesh_rtin_chunks(positions, maxError, threads).size(); });
+        std::vector<RtinChunk> meshes = mesh_rtin_chunks(positions, maxError, threads);
+
+        long triangles = 0, broken = 0;
+        double best = 0.0, worst = 100.0;
+        float maxErr = 0.0f;
+        for (int pos = 0; pos < chunkN; pos++) {
+            const std::vector<int> &indices = meshes[pos].indices;
+            const std::vector<float> &verts = g_chunkVertices[pos];
+            const long n = (long)indices.size() / 3;
+            triangles += n;
+            best = std::max(best, 100.0 - 100.0 * n / fullTriangles);
+            worst = std::min(worst, 100.0 - 100.0 * n / fullTriangles);
+
+            std::vector<char> used((size_t)chunkWidth * chunkHeight, 0);
+            std::vector<std::pair<int, int>> edges;
+            for (size_t t = 0; t < indices.size(); t += 3) {
+                const int *v = &indices[t];
+                broken += (cross_xz(v[0], v[1], v[2]) < 0 ? -1 : 1) != gridWinding;
+                for (int c = 0; c < 3; c++) {
+                    used[v[c]] = 1;
+                    edges.push_back(std::minmax(v[c], v[(c + 1) % 3]));
+                }
+                // every grid sample under the triangle, against the plane through its corners
+                int x[3], z[3];
+                for (int c = 0; c < 3; c++) { x[c] = v[c] % chunkWidth; z[c] = v[c] / chunkWidth; }
+                const float area = (float)cross_xz(v[0], v[1], v[2]);
+                for (int sz = std::min({ z[0], z[1], z[2] }); sz <= std::max({ z[0], z[1], z[2] }); sz++) {
+                    for (int sx = std::min({ x[0], x[1], x[2] }); sx <= std::max({ x[0], x[1], x[2] }); sx++) {
+                        float w[3];
+                        for (int c = 0; c < 3; c++) {
+                            int b = (c + 1) % 3, d = (c + 2) % 3;
+                            w[c] = (float)((x[d] - x[b]) * (sz - z[b]) - (z[d] - z[b]) * (sx - x[b])) / area;
+                        }
+                        if (w[0] < -1e-6f || w[1] < -1e-6f || w[2] < -1e-6f) continue;
+                        float h = 0.0f;
+                        for (int c = 0; c < 3; c++) h += w[c] * verts[3 * v[c] + 1];
+                        maxErr = std::max(maxErr, std::fabs(h - verts[3 * (sx + sz * chunkWidth) + 1]));
+                    }
+                }
+            }
+            for (int i = 0; i < chunkWidth * chunkHeight; i++) broken += on_border(i) && !used[i];
+            // an edge used once has to be a border edge, or there is a T-junction
+            std::sort(edges.begin(), edges.end());
+            for (size_t i = 0; i < edges.size();) {
+                size_t j = i;
+                while (j < edges.size() && edges[j] == edges[i]) j++;
+                broken += (j - i == 1 && !border_edge(edges[i].first, edges[i].second)) || j - i > 2;
+                i = j;
+            }
+        }
+        char bestWorst[32];
+        snprintf(bestWorst, sizeof(bestWorst), "%.0f%% / %.0f%%", best, worst);
+        printf("%-8.2f %12ld %8.1f%% %13s %11.4f %10.3f %10.1f %8ld\n", maxError, triangles,
+               100.0 - 100.0 * triangles / (fullTriangles * chunkN), bestWorst, maxErr, ms / chunkN, wallMs, broken);
+        ok = ok && broken == 0 && maxErr <= maxError + 1e-4f;
+    }
+    printf("(%u worker threads)\n", threads);
+    return ok;
+}
+
+// objectShader.vert's flat shading: the other two corners of the face grid
+// vertex v provokes at step on its high (or low) side, for pattern.
+static std::array<int, 2> flat_face_corners(int v, int step, int pattern, bool high) {
+    auto vertex = [](int x, int z) {
+        return glm::clamp(x, 0, chunkWidth - 1) + glm::clamp(z, 0, chunkHeight - 1) * chunkWidth;
+    };
+    int x = v % chunkWidth, z = v / chunkWidth;
+    if (!high) return { { vertex(x - step, z), vertex(x - step, z - step) } };
+    if (pattern == FLAT_LISTS) return { { vertex(x + step, z), vertex(x + step, z + step) } };
+    return { { vertex(x - step, z), vertex(x, z + step) } };
+}
+
+// Flat shading without duplicated vertices: in every grid index order and
+// CDLOD level, the face the shaders derive from each triangle's provoking
+// (last) vertex and the side the triangle lies on has to be that triangle.
+static bool bench_flat_shading() {
+    struct Stream { std::string name; std::vector<int> indices; bool strip; int step; };
+    std::vector<Stream> streams;
+    for (int i = 0; i < INDEX_ORDER_COUNT; i++)
+        streams.push_back({ index_order_name((IndexOrder)i), generate_indices((IndexOrder)i), i == (int)IndexOrder::STRIPS, 1 });
+    const std::vector<int> nodes = cdlod_indices();
+    const int levels = cdlod_levels();
+    size_t first = 0;
+    for (int level = levels - 1; level >= 0; level--) {
+        size_t count = (size_t)6 * CDLOD_NODE_QUADS * CDLOD_NODE_QUADS << (2 * (levels - 1 - level));
+        streams.push_back({ "cdlod " + std::to_string(level), std::vector<int>(nodes.begin() + first, nodes.begin() + first + count),
+                            false, 1 << level });
+        first += count;
+    }
+
+    printf("\n== flat shading (provoking vertex) ==\n");
+    printf("%-8s %10s %10s\n", "stream", "triangles", "wrong");
+    bool ok = first == nodes.size();
+    size_t gridTriangles = 0;
+    for (const Stream &stream : streams) {
+        const int pattern = stream.strip ? FLAT_STRIPS : FLAT_LISTS;
+        const std::vector<int> &idx = stream.indices;
+        size_t triangles = 0, wrong = 0;
+        auto check = [&](int a, int b, int provoking) {
+            int px = provoking % chunkWidth, pz = provoking / chunkWidth;
+            int dx = a % chunkWidth + b % chunkWidth - 2 * px, dz = a / chunkWidth + b / chunkWidth - 2 * pz;
+            std::array<int, 2> face = flat_face_corners(provoking, stream.step, pattern, (pattern == FLAT_LISTS ? dx + dz : dz) > 0);
+            bool same = (face[0] == a && face[1] == b) || (face[0] == b && face[1] == a);
+            triangles++;
+            wrong += !same;
+        };
+        if (!stream.strip) {
+            for (size_t i = 0; i + 2 < idx.size(); i += 3) check(idx[i], idx[i + 1], idx[i + 2]);
+        } else {
+            for (size_t i = 0; i + 2 < idx.size(); i++)
+                if (idx[i] != PRIMITIVE_RESTART && idx[i + 1] != PRIMITIVE_RESTART && idx[i + 2] != PRIMITIVE_RESTART)
+                    check(idx[i], idx[i + 1], idx[i + 2]);
+        }
+        printf("%-8s %10zu %10zu\n", stream.name.c_str(), triangles, wrong);
+        if (stream.step == 1 && !stream.strip) gridTriangles = triangles;
+        ok = ok && wrong == 0 && triangles > 0;
+    }
+    size_t vertices = (size_t)chunkWidth * chunkHeight;
+    printf("vertices per chunk: %zu (one per triangle corner: %zu, %.1fx)\n", vertices, 3 * gridTriangles,
+           3.0 * gridTriangles / vertices);
+    return ok;
+}
+
+// Every chunk size cuts the same world: the slot window, render reach and
+// grid geometry follow the size, get_terrain_height_at reads the grid back,
+// and the tuner's estimates (with DEFAULT_DRAW_CALL_US per draw) come out for
+// exactly the sizes that keep the reach, at that reach.
+static bool bench_chunk_size() {
+    printf("\n== chunk size (tuned with %.1f us per draw call, %d frames) ==\n", DEFAULT_DRAW_CALL_US,
+           chunkTuneFrames);
+    printf("%-6s %7s %6s %9s %11s %13s %8s %10s\n", "size", "chunks", "reach", "indices", "height err",
+           "generate ms", "draws", "total ms");
+    std::vector<ChunkSizeCost> costs = chunk_size_costs(DEFAULT_DRAW_CALL_US);
+    bool ok = chunkWidth == 129 && xMapChunks == 21 && chunk_render_distance == 3 && lod_render_distance == 9 &&
+              costs.size() == (size_t)std::count_if(CHUNK_SIZES, CHUNK_SIZES + CHUNK_SIZE_COUNT, chunk_size_keeps_reach);
+    GridChunkBuffers buffers;
+    std::vector<float> verts;
+    std::vector<plant> plants;
+    int best = -1;
+    for (int size : CHUNK_SIZES) {
+        auto it = std::find_if(costs.begin(), costs.end(), [&](const ChunkSizeCost &c) { return c.size == size; });
+        const bool tuned = it != costs.end();
+        ChunkSizeCost c = tuned ? *it : ChunkSizeCost{ size, 0, 0, 0.0, 0.0 };
+        set_chunk_size(size);
+        const int reach = chunk_render_distance * (chunkWidth - 1);
+        const size_t indices = generate_indices(IndexOrder::ROW_MAJOR).size();
+        build_grid_chunk(1, 1, octaves, buffers, verts, plants);
+        float heightErr = 0.0f;
+        for (int z = 0; z < chunkHeight - 1; z += 7)
+            for (int x = 0; x < chunkWidth - 1; x += 5)
+                heightErr = std::max(heightErr, std::fabs(get_terrain_height_at((float)x, (float)z, verts, chunkWidth, chunkHeight) -
+                                                          verts[3 * (x + z * chunkWidth) + 1]));
+        if (tuned)
+            printf("%-6d %7d %6d %9zu %11.2g %13.1f %8d %10.1f\n", size, c.chunks, reach, indices, heightErr,
+                   c.generateMs, c.draws, c.total());
+        else
+            printf("%-6d %7s %6d %9zu %11.2g %13s %8s %10s\n", size, "-", reach, indices, heightErr, "skipped", "-", "-");
+        const int distance = terrain_render_distance();
+        ok = ok && xMapChunks == stream_window(std::max(chunk_render_distance, lod_render_distance)) &&
+             indices == 6 * (size_t)(size - 1) * (size - 1) && heightErr < 1e-5f &&
+             tuned == chunk_size_keeps_reach(size);
+        if (tuned) {
+            ok = ok && reach == RENDER_QUADS && lod_render_distance * (size - 1) == LOD_RENDER_QUADS &&
+                 c.chunks == (2 * distance + 1) * (2 * distance + 1) && c.generateMs > 0.0 && c.draws > 0;
+            if (best < 0 || c.total() < costs[best].total()) best = (int)(it - costs.begin());
+        }
+    }
+    set_chunk_size(129);
+    printf("picked %d\n", best >= 0 ? costs[best].size : 0);
+    return ok && best >= 0;
+}
+
+static bool bench_vertex_format() {
+    std::vector<float> gradients, normals;
+    std::vector<float> heights = generate_height_map(3, 4, gradients);
+    std::vector<float> verts = generate_vertices(heights, gradients, normals);
+    const size_t nVertices = verts.size() / 3;
+    const glm::vec3 extent = terrain_pack_extent();
+
+    std::vector<PackedGridVertex> packed(nVertices);
+    double packMs = bench_ms(20, [&] {
+        for (size_t i = 0; i < nVertices; i++) {
+            packed[i].height = pack_unorm16(verts[3 * i + 1], extent.y);
+            oct_encode(glm::make_vec3(&normals[3 * i]), packed[i].normal);
+        }
+    });
+
+    // what objectShader.vert reconstructs
+    float heightErr = 0.0f, angleErr = 0.0f;
+    for (size_t i = 0; i < nVertices; i++) {
+        heightErr = std::max(heightErr, std::fabs(packed[i].height / 65535.0f * extent.y - verts[3 * i + 1]));
+        glm::vec3 n = oct_decode(glm::vec2(packed[i].normal[0], packed[i].normal[1]) / 127.0f);
+        float c = glm::clamp(glm::dot(n, glm::make_vec3(&normals[3 * i])), -1.0f, 1.0f);
+        angleErr = std::max(angleErr, glm::degrees(std::acos(c)));
+    }
+
+    const int chunkN = xMapChunks * yMapChunks;
+    const size_t before = 9 * sizeof(float), grid = sizeof(PackedGridVertex) + 4, volume = sizeof(PackedVolumeVertex) + 4;
+    printf("\n== packed terrain vertices ==\n");
+    printf("bytes/vertex: %zu -> %zu (grid), %zu (volume); %d chunks: %.1f MB -> %.1f MB of vertex data\n",
+           before, grid, volume, chunkN, before * nVertices * chunkN / 1e6, grid * nVertices * chunkN / 1e6);
+    printf("vertex fetch per drawn chunk: %.0f KB -> %.0f KB, packing %.3f ms/chunk\n",
+           before * nVertices / 1e3, grid * nVertices / 1e3, packMs);
+    printf("max height error %.4f units, max normal error %.2f deg\n", heightErr, angleErr);
+    return heightErr <= extent.y / 65535.0f && angleErr < 1.0f;
+}
+
+// build_grid_chunk against the passes it replaces, each rolling the chunk's own plant dice.
+static bool bench_fused_chunk() {
+    const int cx = 3, cy = 4;
+    std::vector<plant> plantsOld, plantsNew;
+    std::vector<float> vertsOld, vertsNew;
+    std::vector<PackedGridVertex> packedOld;
+    std::vector<uint8_t> colorsOld;
+    GridChunkBuffers buffers;
+
+    // the separate passes chunks were built from before, down to the packing in upload_map_chunk
+    auto separate = [&](int lod) {
+        std::vector<float> gradients, normals;
+        std::vector<float> heights = generate_height_map(cx, cy, gradients, lod);
+        std::vector<float> verts = generate_vertices(heights, gradients, normals);
+        std::vector<float> colors = generate_biome(verts, plantsOld, cx, cy, gSeason, gWeather, gHumidity);
+        vertsOld = verts;
+        std::vector<PackedGridVertex> packed(verts.size() / 3);
+        for (size_t i = 0; i < packed.size(); i++) {
+            packed[i].height = pack_unorm16(verts[3 * i + 1], terrain_pack_extent().y);
+            oct_encode(glm::make_vec3(&normals[3 * i]), packed[i].normal);
+        }
+        packedOld.swap(packed);
+        colorsOld = pack_colors(colors);
+    };
+    auto fused = [&](int lod) { build_grid_chunk(cx, cy, lod, buffers, vertsNew, plantsNew); };
+    auto allocations = [&](auto &&fn) {
+        size_t before = g_allocCount.load();
+        fn();
+        return g_allocCount.load() - before;
+    };
+
+    plantsOld.clear(); separate(octaves);
+    plantsNew.clear(); fused(octaves);
+    float vertDiff = max_abs_diff(vertsOld, vertsNew);
+    int packMismatch = 0, colorMismatch = 0;
+    for (size_t i = 0; i < packedOld.size() && i < buffers.vertices.size(); i++)
+        packMismatch += std::abs(packedOld[i].height - buffers.vertices[i].height) > 1 ||
+                        std::abs(packedOld[i].normal[0] - buffers.vertices[i].normal[0]) > 1 ||
+                        std::abs(packedOld[i].normal[1] - buffers.vertices[i].normal[1]) > 1;
+    for (size_t i = 0; i < colorsOld.size() && i < buffers.colors.size(); i++)
+        colorMismatch += std::abs(colorsOld[i] - buffers.colors[i]) > 1;
+    bool samePlants = plantsOld.size() == plantsNew.size();
+    for (size_t i = 0; samePlants && i < plantsOld.size(); i++)
+        samePlants = plantsOld[i].type == plantsNew[i].type && plantsOld[i].xpos == plantsNew[i].xpos &&
+                     std::fabs(plantsOld[i].ypos - plantsNew[i].ypos) < 1e-3f && plantsOld[i].zpos == plantsNew[i].zpos;
+    const size_t nPlants = plantsNew.size();
+
+    // octave-LOD chunk: the border is re-evaluated row-wise here, point-wise there
+    const int lod = std::max(1, octaves - 2);
+    separate(lod);
+    fused(lod);
+    float lodDiff = max_abs_diff(vertsOld, vertsNew);
+
+    double oldMs = bench_ms(10, [&] { plantsOld.clear(); separate(octaves); });
+    double newMs = bench_ms(10, [&] { plantsNew.clear(); fused(octaves); });
+    plantsOld.clear();
+    plantsNew.clear();
+    size_t oldAllocs = allocations([&] { separate(octaves); });
+    size_t newAllocs = allocations([&] { fused(octaves); });
+
+    printf("\n== fused chunk kernel ==\n");
+    printf("separate passes: %.3f ms/chunk, %zu allocations\n", oldMs, oldAllocs);
+    printf("fused: %.3f ms/chunk (%.2fx), %zu allocations\n", newMs, oldMs / newMs, newAllocs);
+    printf("max vertex diff %.6f (LOD chunk %.6f), packed/colour mismatches %d/%d, plants %zu %s\n",
+           vertDiff, lodDiff, packMismatch, colorMismatch, nPlants, samePlants ? "identical" : "DIFFER");
+    return newAllocs == 0 && vertDiff < 1e-4f && lodDiff < 1e-3f && packMismatch == 0 && colorMismatch == 0 &&
+           samePlants;
+}
+
+static bool bench_noise_backends() {
+    const SimdLevel levels[] = { SimdLevel::SCALAR, SimdLevel::SSE41, SimdLevel::AVX2 };
+    const NoiseBackend savedBackend = noiseBackend;
+    const uint8_t *p = g_noiseContext->perm;
+    const int nSamples = chunkWidth * chunkHeight * octaves;
+    bool ok = true;
+
+    printf("\n== noise backends: Msamples/s (one chunk, %d octaves) and ms per chunk (noise + gradient) ==\n", octaves);
+    printf("%-14s %10s %10s %10s %12s %11s %11s\n",
+           "backend", "scalar", "sse4.1", "avx2", "ms/chunk", "simd |err|", "d/dx |err|");
+
+    std::vector<float> xs(chunkWidth), out(chunkWidth), dx(chunkWidth), dy(chunkWidth), ref(chunkWidth);
+    for (int b = 0; b < NOISE_BACKEND_COUNT; b++) {
+        NoiseBackend backend = (NoiseBackend)b;
+        printf("%-14s", noise_backend_name(backend));
+
+        float simdErr = 0.0f;
+        for (SimdLevel level : levels) {
+            if (clamp_simd_level(level) != level) {
+                printf(" %10s", "-");
+                continue;
+            }
+            double ms = bench_ms(50, [&] {
+                float acc = 0.0f;
+                for (int i = 0, freq = 1; i < octaves; i++, freq *= 2)
+                    for (int y = 0; y < chunkHeight; y++) {
+                        for (int x = 0; x < chunkWidth; x++) xs[x] = x / noiseScale * freq;
+                        noise_row(backend, xs.data(), y / noiseScale * freq, out.data(), nullptr, nullptr,
+                                  chunkWidth, p, level);
+                        acc += out[y % chunkWidth];
+                    }
+                g_benchSink = acc;
+            });
+            printf(" %10.2f", nSamples / ms / 1e3);
+
+            // every lane width has to agree with the scalar lanes
+            for (int y = 0; y < chunkHeight; y += 7) {
+                for (int x = 0; x < chunkWidth; x++) xs[x] = (x + 0.37f * y) / noiseScale * 4.0f;
+                noise_row(backend, xs.data(), y / noiseScale * 4.0f, ref.data(), nullptr, nullptr, chunkWidth, p,
+                          SimdLevel::SCALAR);
+                noise_row(backend, xs.data(), y / noiseScale * 4.0f, out.data(), nullptr, nullptr, chunkWidth, p, level);
+                simdErr = std::max(simdErr, max_abs_diff(ref, out));
+            }
+        }
+
+        noiseBackend = backend;
+        std::vector<float> gradients;
+        double chunkMs = bench_ms(20, [&] { g_benchSink = generate_noise_map(3, 4, &gradients)[0]; });
+
+        // analytic derivative against central differences of the same backend
+        const float h = 1e-3f;
+        float derivErr = 0.0f;
+        for (int x = 0; x < chunkWidth; x++) xs[x] = x * 0.0731f + 0.013f;
+        noise_row(backend, xs.data(), 2.371f, out.data(), dx.data(), dy.data(), chunkWidth, p, SimdLevel::SCALAR);
+        for (int x = 0; x < chunkWidth; x++) {
+            float px[2] = { xs[x] + h, xs[x] - h }, fx[2], fy[2];
+            noise_row(backend, px, 2.371f, fx, nullptr, nullptr, 2, p, SimdLevel::SCALAR);
+            noise_row(backend, &xs[x], 2.371f + h, &fy[0], nullptr, nullptr, 1, p, SimdLevel::SCALAR);
+            noise_row(backend, &xs[x], 2.371f - h, &fy[1], nullptr, nullptr, 1, p, SimdLevel::SCALAR);
+            derivErr = std::max(derivErr, std::fabs(dx[x] - (fx[0] - fx[1]) / (2 * h)));
+            derivErr = std::max(derivErr, std::fabs(dy[x] - (fy[0] - fy[1]) / (2 * h)));
+        }
+
+        bool pass = simdErr <= NOISE_BATCH_TOLERANCE && derivErr < 2e-2f;
+        ok = ok && pass;
+        printf(" %12.3f %11.2e %11.2e%s\n", chunkMs, simdErr, derivErr, pass ? "" : "  FAIL");
+    }
+    noiseBackend = savedBackend;
+    return ok;
+}
+
+static bool bench_hash_noise() {
+    const int n = 512;
+    std::vector<float> xs(n), shifted(n), a(n), b(n);
+    for (int i = 0; i < n; i++) {
+        xs[i] = i * 0.193f + 0.37f;
+        shifted[i] = xs[i] + 256.0f;
+    }
+
+    // the default backend repeats every 256 lattice cells (16384 units at noiseScale 64); hash must not
+    const uint8_t *p = get_noise_context(0u)->perm;
+    printf("\n== table-free hash noise ==\n");
+    float tableRepeat = 0.0f, hashRepeat = 0.0f;
+    for (int backend = 0; backend < NOISE_BACKEND_COUNT; backend++) {
+        noise_row((NoiseBackend)backend, xs.data(), 5.3f, a.data(), nullptr, nullptr, n, p, noiseSimdLevel);
+        noise_row((NoiseBackend)backend, shifted.data(), 5.3f, b.data(), nullptr, nullptr, n, p, noiseSimdLevel);
+        float diff = max_abs_diff(a, b);
+        printf("%-14s max |n(x) - n(x + 256)| %.3f\n", noise_backend_name((NoiseBackend)backend), diff);
+        if ((NoiseBackend)backend == NoiseBackend::PERLIN3D) tableRepeat = diff;
+        if ((NoiseBackend)backend == NoiseBackend::HASH) hashRepeat = diff;
+    }
+
+    // far from the origin the field must still be noise: in range, varied and seed-dependent
+    float lo = INFINITY, hi = -INFINITY, seedDiff = 0.0f;
+    for (float far : { 1.0e4f, 1.0e5f, 2.5e5f }) {
+        for (int i = 0; i < n; i++) shifted[i] = xs[i] + far;
+        noise_row(NoiseBackend::HASH, shifted.data(), far + 5.3f, a.data(), nullptr, nullptr, n, p, noiseSimdLevel);
+        noise_row(NoiseBackend::HASH, shifted.data(), far + 5.3f, b.data(), nullptr, nullptr, n,
+                  get_noise_context(1u)->perm, noiseSimdLevel);
+        for (float v : a) { lo = std::min(lo, v); hi = std::max(hi, v); }
+        seedDiff = std::max(seedDiff, max_abs_diff(a, b));
+    }
+    printf("hash at 1e4 .. 2.5e5 noise units: range [%.3f, %.3f], seeds 0/1 differ by up to %.3f\n",
+           lo, hi, seedDiff);
+    return tableRepeat < 1e-3f && hashRepeat > 0.1f && lo > -1.5f && hi < 1.5f && hi - lo > 0.5f && seedDiff > 0.1f;
+}
+
+static bool bench_domain_warp() {
+    const float savedStrength = warpStrength;
+    const int savedStep = warpGridStep;
+    std::vector<float> gradients;
+
+    warpStrength = 0.0f;
+    double plainMs = bench_ms(20, [&] { g_benchSink = generate_noise_map(3, 4, &gradients)[0]; });
+
+    // step 1 evaluates the warp at every vertex and is the quality reference
+    warpStrength = 0.6f;
+    warpGridStep = 1;
+    std::vector<float> exact = generate_noise_map(3, 4);
+
+    printf("\n== domain warp (strength %.1f, %d warp octaves) ==\n", warpStrength, warpOctaves);
+    printf("%-18s %12s %13s %12s\n", "path", "ms/chunk", "vs plain fBm", "max |err|");
+    printf("%-18s %12.3f %12.2fx %12s\n", "plain fBm", plainMs, 1.0, "-");
+    bool ok = true;
+    for (int step : { 1, 4, 8, 16 }) {
+        warpGridStep = step;
+        double ms = bench_ms(20, [&] { g_benchSink = generate_noise_map(3, 4, &gradients)[0]; });
+        float err = max_abs_diff(exact, generate_noise_map(3, 4));
+        // heights are in [0, 1]; a coarse grid should stay visually identical
+        ok = ok && (step > 8 || err < 0.05f);
+        printf("%-18s %12.3f %12.2fx %12.2e\n", ("warp, step " + std::to_string(step)).c_str(), ms, ms / plainMs, err);
+    }
+
+    warpStrength = savedStrength;
+    warpGridStep = savedStep;
+    return ok;
+}
+
+static bool bench_multifractal() {
+    const FractalMode savedMode = fractalMode;
+    const int savedOctaves = octaves;
+    const float savedError = octaveHeightError;
+    std::vector<float> thresholds = biome_thresholds(gSeason);
+    auto band_of = [&](float n) {
+        float h = std::fmax(0.0f, std::fmin(eased_height(n), 1.5f));
+        return (int)(std::upper_bound(thresholds.begin(), thresholds.end(), h) - thresholds.begin());
+    };
+    bool ok = true;
+
+    printf("\n== multifractal early-out (height error %.3f) ==\n", savedError);
+    printf("%-8s %-8s %11s %11s %9s %9s %11s %7s\n",
+           "mode", "octaves", "full ms", "early ms", "speedup", "skipped", "max |dh|", "bands");
+    std::vector<float> gradients;
+    for (FractalMode mode : { FractalMode::RIDGED, FractalMode::HYBRID }) {
+        for (int o : { 5, 10 }) {
+            fractalMode = mode;
+            octaves = o;
+
+            octaveHeightError = -1.0f;   // never stop early
+            double fullMs = bench_ms(10, [&] { g_benchSink = generate_noise_map(3, 4, &gradients)[0]; });
+            std::vector<float> full = generate_noise_map(3, 4);
+
+            octaveHeightError = savedError;
+            double earlyMs = bench_ms(10, [&] { g_benchSink = generate_noise_map(3, 4, &gradients)[0]; });
+            std::vector<float> early = generate_noise_map(3, 4);
+            double skippedPct = 100.0 * g_lastOctavesSkipped / ((double)early.size() * o);
+
+            float maxDh = 0.0f;
+            int bandChanges = 0;
+            for (size_t i = 0; i < full.size(); i++) {
+                maxDh = std::max(maxDh, std::fabs(eased_height(full[i]) - eased_height(early[i])));
+                bandChanges += band_of(full[i]) != band_of(early[i]);
+            }
+            bool pass = maxDh <= octaveHeightError + 1e-5f && bandChanges == 0;
+            ok = ok && pass;
+            printf("%-8s %-8d %11.3f %11.3f %8.2fx %8.1f%% %11.2e %7d%s\n", fractal_mode_name(mode), o,
+                   fullMs, earlyMs, fullMs / earlyMs, skippedPct, maxDh, bandChanges, pass ? "" : "  FAIL");
+        }
+    }
+
+    fractalMode = savedMode;
+    octaves = savedOctaves;
+    octaveHeightError = savedError;
+    return ok;
+}
+
+static bool bench_noise_graph() {
+    const TerrainPreset savedPreset = terrainPreset;
+    const int nSamples = chunkWidth * chunkHeight;
+
+    // the staged pipeline: a full fBm buffer, then easing and the water clamp in a second pass
+    std::vector<float> staged, stagedGrad;
+    auto run_staged = [&] {
+        staged = generate_noise_map(3, 4, &stagedGrad);
+        for (int i = 0; i < nSamples; i++) {
+            float e = staged[i] * 1.1f;
+            float slope = e * e * e < WATER_HEIGHT * 0.5f ? 0.0f : 3.0f * e * e * 1.1f;
+            staged[i] = eased_height(staged[i]);
+            stagedGrad[i] *= slope;
+            stagedGrad[nSamples + i] *= slope;
+        }
+    };
+    double stagedMs = bench_ms(20, run_staged);
+
+    printf("\n== noise graph (fused height + slope per preset) ==\n");
+    printf("%-10s %12s %12s %12s\n", "preset", "ms/chunk", "vs staged", "max |err|");
+    printf("%-10s %12.3f %11.2fx %12s\n", "staged", stagedMs, 1.0, "-");
+    bool ok = true;
+    std::vector<float> gradients;
+    for (int i = 0; i < TERRAIN_PRESET_COUNT; i++) {
+        terrainPreset = (TerrainPreset)i;
+        double ms = bench_ms(20, [&] { g_benchSink = generate_height_map(3, 4, gradients)[0]; });
+        std::string err = "-";
+        if (terrainPreset == TerrainPreset::CLASSIC) {
+            // the classic graph must reproduce the staged pipeline, slopes included
+            std::vector<float> fused = generate_height_map(3, 4, gradients);
+            float e = std::max(max_abs_diff(staged, fused), max_abs_diff(stagedGrad, gradients));
+            ok = ok && e < 1e-4f;
+            char buf[32];
+            snprintf(buf, sizeof(buf), "%.2e%s", e, e < 1e-4f ? "" : " FAIL");
+            err = buf;
+        }
+        printf("%-10s %12.3f %11.2fx %12s\n", terrain_preset_name(terrainPreset), ms, stagedMs / ms, err.c_str());
+    }
+
+    terrainPreset = savedPreset;
+    return ok;
+}
+
+static bool bench_octave_lod() {
+    const int savedX = gridPosX, savedY = gridPosY;
+    gridPosX = xMapChunks / 2;
+    gridPosY = yMapChunks / 2;
+    std::vector<float> gradients;
+
+    // the whole startup grid, once at full detail and once with the camera in the middle
+    double fullMs = bench_ms(2, [&] {
+        for (int y = 0; y < yMapChunks; y++)
+            for (int x = 0; x < xMapChunks; x++) g_benchSink = generate_noise_map(x, y, &gradients)[0];
+    });
+    double lodMs = bench_ms(2, [&] {
+        for (int y = 0; y < yMapChunks; y++)
+            for (int x = 0; x < xMapChunks; x++)
+                g_benchSink = generate_noise_map(x, y, &gradients, chunk_lod_octaves(x, y))[0];
+    });
+
+    printf("\n== octave LOD (full detail within %d rings, at least %d octaves) ==\n",
+           octaveLodRadius, octaveLodMinOctaves);
+    printf("%-6s %8s %13s %13s\n", "ring", "octaves", "max |dh|", "border |dh|");
+    bool ok = true;
+    int maxRing = std::max(xMapChunks - 1 - gridPosX, yMapChunks - 1 - gridPosY);
+    for (int ring = 0; ring <= maxRing; ring++) {
+        int x = gridPosX + ring, y = gridPosY;
+        std::vector<float> fullG, lodG;
+        std::vector<float> full = generate_noise_map(x, y, &fullG);
+        std::vector<float> lod = generate_noise_map(x, y, &lodG, chunk_lod_octaves(x, y));
+
+        float maxDh = 0.0f, borderDh = 0.0f;
+        for (int j = 0; j < chunkHeight; j++) {
+            for (int i = 0; i < chunkWidth; i++) {
+                int k = i + j * chunkWidth;
+                float dh = std::fabs(eased_height(full[k]) - eased_height(lod[k]));
+                maxDh = std::max(maxDh, dh);
+                if (i == 0 || j == 0 || i == chunkWidth - 1 || j == chunkHeight - 1) {
+                    // seams must match bit for bit, normals included
+                    float dg = std::max(std::fabs(fullG[k] - lodG[k]),
+                                        std::fabs(fullG[k + full.size()] - lodG[k + full.size()]));
+                    borderDh = std::max(borderDh, std::max(dh, dg));
+                }
+            }
+        }
+        ok = ok && borderDh == 0.0f;
+        printf("%-6d %8d %13.2e %13.2e%s\n", ring, chunk_lod_octaves(x, y), maxDh, borderDh,
+               borderDh == 0.0f ? "" : "  FAIL");
+    }
+    printf("%d chunks: %.1f ms at full detail, %.1f ms with octave LOD (%.2fx)\n",
+           xMapChunks * yMapChunks, fullMs, lodMs, fullMs / lodMs);
+
+    gridPosX = savedX;
+    gridPosY = savedY;
+    return ok && lodMs < fullMs;
+}
+
+static bool bench_fixed_point() {
+    const bool savedFixed = fixedPointNoise;
+    const std::shared_ptr<const NoiseContext> savedContext = g_noiseContext;
+    g_noiseContext = get_noise_context(0u);
+    std::vector<float> gradients;
+
+    fixedPointNoise = false;
+    double floatMs = bench_ms(20, [&] { g_benchSink = generate_noise_map(3, 4, &gradients)[0]; });
+    std::vector<float> reference = generate_noise_map(3, 4);
+    fixedPointNoise = true;
+    double fixedMs = bench_ms(20, [&] { g_benchSink = generate_noise_map(3, 4, &gradients)[0]; });
+    std::vector<float> fixed = generate_noise_map(3, 4);
+
+    // neighbours must agree bit for bit on the shared row / column, slopes included
+    std::vector<float> gc, gr, gu;
+    std::vector<float> centre = generate_noise_map(3, 4, &gc);
+    std::vector<float> right = generate_noise_map(4, 4, &gr);
+    std::vector<float> up = generate_noise_map(3, 5, &gu);
+    const int nSamples = chunkWidth * chunkHeight;
+    int seamMismatches = 0;
+    for (int y = 0; y < chunkHeight; y++) {
+        int a = chunkWidth - 1 + y * chunkWidth, b = y * chunkWidth;
+        seamMismatches += centre[a] != right[b] || gc[a] != gr[b] || gc[nSamples + a] != gr[nSamples + b];
+    }
+    for (int x = 0; x < chunkWidth; x++) {
+        int a = x + (chunkHeight - 1) * chunkWidth, b = x;
+        seamMismatches += centre[a] != up[b] || gc[a] != gu[b] || gc[nSamples + a] != gu[nSamples + b];
+    }
+
+    // the hash of chunk (0, 0) of the default world; any x86-64 / ARM64 build must reproduce it
+    const uint64_t GOLDEN_HASH = 0x47aaabdd18d9f83dull;
+    generate_noise_map(0, 0);
+    bool defaults = octaves == 5 && persistence == 0.5f && lacunarity == 2.0f && noiseScale == 64.0f &&
+                    chunkWidth == 129 && chunkHeight == 129;
+    bool golden = !defaults || g_lastContentHash == GOLDEN_HASH;
+
+    printf("\n== fixed-point noise ==\n");
+    printf("float fBm %.3f ms/chunk, fixed point %.3f ms/chunk (%.2fx), max |float - fixed| %.2e\n",
+           floatMs, fixedMs, fixedMs / floatMs, max_abs_diff(reference, fixed));
+    printf("seam mismatches: %d, chunk (0,0) hash %016llx%s\n", seamMismatches,
+           (unsigned long long)g_lastContentHash, golden ? "" : "  FAIL (expected golden hash)");
+
+    fixedPointNoise = savedFixed;
+    g_noiseContext = savedContext;
+    return seamMismatches == 0 && golden && max_abs_diff(reference, fixed) < 1e-3f;
+}
+
+static bool bench_noise_context() {
+    const std::shared_ptr<const NoiseContext> saved = g_noiseContext;
+
+    double buildUs = bench_ms(1000, [&] { NoiseContext ctx(12345u); g_benchSink = ctx.perm[7]; }) * 1e3;
+    bool shared = get_noise_context(7u) == get_noise_context(7u);
+    bool aligned = ((uintptr_t)get_noise_context(7u)->perm % 64) == 0;
+
+    g_noiseContext = get_noise_context(1u);
+    std::vector<float> worldA = generate_noise_map(0, 0);
+    g_noiseContext = get_noise_context(2u);
+    std::vector<float> worldB = generate_noise_map(0, 0);
+    g_noiseContext = saved;
+
+    printf("\n== noise context ==\n");
+    printf("table: %d bytes, built once per seed in %.2f us (was rebuilt per chunk)\n", 512, buildUs);
+    printf("shared per seed: %s, 64-byte aligned: %s, seeds 1/2 differ by up to %.3f\n",
+           shared ? "yes" : "NO", aligned ? "yes" : "NO", max_abs_diff(worldA, worldB));
+    return shared && aligned && max_abs_diff(worldA, worldB) > 0.0f;
+}
+
+static bool bench_volume() {
+    const std::shared_ptr<const NoiseContext> saved = g_noiseContext;
+    g_noiseContext = get_noise_context(0u);
+    const uint8_t *p = g_noiseContext->perm;
+    const FbmRuntimeWeights weights(persistence, lacunarity);
+
+    // the reference 2D noise is Ken Perlin's 3D noise on z = 0, so the 3D kernel must reproduce it there
+    const int n = 256;
+    std::vector<float> xs(n), flat(n), slice(n);
+    for (int i = 0; i < n; i++) xs[i] = i * 0.173f - 7.0f;
+    fbm_noise_row(NoiseBackend::PERLIN3D, xs.data(), 2.37f, flat.data(), nullptr, nullptr, n, p, octaves, weights,
+                  noiseSimdLevel);
+    fbm3_noise_row(xs.data(), 2.37f, 0.0f, slice.data(), n, p, octaves, weights, noiseSimdLevel);
+    float sliceDiff = max_abs_diff(flat, slice);
+
+    std::vector<float> density, right;
+    int nx, ny, nz;
+    double densityMs = bench_ms(10, [&] { build_density_field(3, 4, density, nx, ny, nz, noiseSimdLevel); });
+    build_density_field(4, 4, right, nx, ny, nz, noiseSimdLevel);
+
+    // the last two sample planes of a chunk are the first two of its +x neighbour
+    int seamMismatches = 0;
+    for (int y = 0; y < ny; y++)
+        for (int z = 0; z < nz; z++)
+            for (int k = 0; k < 2; k++)
+                seamMismatches += density[nx - 2 + k + nx * (z + nz * y)] != right[k + nx * (z + nz * y)];
+
+    SurfaceMesh mesh, scalarMesh;
+    double meshMs = bench_ms(20, [&] { surface_nets(density.data(), nx, ny, nz, (float)volumeStep, mesh, noiseSimdLevel); });
+    double scalarMs = bench_ms(20, [&] {
+        surface_nets(density.data(), nx, ny, nz, (float)volumeStep, scalarMesh, SimdLevel::SCALAR);
+    });
+    bool identical = mesh.positions == scalarMesh.positions && mesh.indices == scalarMesh.indices;
+
+    // every surface cell, found the slow way, must have exactly one vertex
+    long surfaceCells = 0, cells = (long)(nx - 1) * (ny - 1) * (nz - 1);
+    for (int y = 0; y + 1 < ny; y++)
+        for (int z = 0; z + 1 < nz; z++)
+            for (int x = 0; x + 1 < nx; x++) {
+                int solid = 0;
+                for (int c = 0; c < 8; c++)
+                    solid += density[x + (c & 1) + nx * (z + ((c >> 2) & 1) + nz * (y + ((c >> 1) & 1)))] > 0.0f;
+                surfaceCells += solid != 0 && solid != 8;
+            }
+    long vertices = (long)mesh.positions.size() / 3, triangles = (long)mesh.indices.size() / 3;
+
+    // triangles must face the way the density gradient says is outside
+    long facingOut = 0;
+    for (size_t t = 0; t < mesh.indices.size(); t += 3) {
+        glm::vec3 v[3], nrm(0.0f);
+        for (int k = 0; k < 3; k++) {
+            v[k] = glm::make_vec3(&mesh.positions[3 * mesh.indices[t + k]]);
+            nrm += glm::make_vec3(&mesh.normals[3 * mesh.indices[t + k]]);
+        }
+        facingOut += glm::dot(glm::cross(v[1] - v[0], v[2] - v[0]), nrm) > 0.0f;
+    }
+
+    // the chunks volume terrain meshes at startup
+    const std::vector<glm::ivec2> startup = chunks_around_camera(chunk_render_distance);
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    double serialMs = bench_ms(1, [&] { g_benchSink = (float)mesh_volume_chunks(startup, 1).size(); });
+    double parallelMs = bench_ms(1, [&] { g_benchSink = (float)mesh_volume_chunks(startup, threads).size(); });
+
+    printf("\n== volume terrain (Surface Nets, %dx%dx%d samples, step %d) ==\n", nx, ny, nz, volumeStep);
+    printf("3D fBm on z = 0 vs 2D perlin3d: max diff %.2e\n", sliceDiff);
+    printf("density %.3f ms/chunk, mesh %.3f ms/chunk (scalar sign bits %.3f ms, %s mesh)\n",
+           densityMs, meshMs, scalarMs, identical ? "identical" : "DIFFERENT");
+    printf("surface cells %ld of %ld (%.1f%%), %ld vertices, %ld triangles, %.1f%% facing out\n",
+           surfaceCells, cells, 100.0 * surfaceCells / cells, vertices, triangles, 100.0 * facingOut / triangles);
+    printf("%d chunks: 1 thread %.1f ms, %u threads %.1f ms (%.2fx); seam mismatches: %d\n",
+           (int)startup.size(), serialMs, threads, parallelMs, serialMs / parallelMs, seamMismatches);
+
+    g_noiseContext = saved;
+    return sliceDiff < 1e-5f && seamMismatches == 0 && identical && vertices == surfaceCells && triangles > 0 &&
+           facingOut > triangles * 95 / 100;
+}
+
+// The BoundedQueue under contention, then the startup chunks built by the
+// worker pool against the same payloads built one after another.
+static bool bench_chunk_workers() {
+    const int producers = 4, consumers = 2, perProducer = 100000;
+    BoundedQueue<int> queue(256);
+    std::atomic<long long> popped(0), sum(0);
+    std::atomic<int> producersLeft(producers);
+    std::vector<std::thread> threads;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int t = 0; t < producers; t++)
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < perProducer; i++)
+                while (!queue.try_push(t * perProducer + i)) std::this_thread::yield();
+            producersLeft--;
+        });
+    for (int t = 0; t < consumers; t++)
+        threads.emplace_back([&] {
+            int v;
+            for (;;) {
+                if (queue.try_pop(v)) {
+                    popped++;
+                    sum += v;
+                } else if (producersLeft.load() == 0) {
+                    if (!queue.try_pop(v)) return;
+                    popped++;
+                    sum += v;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    for (std::thread &t : threads) t.join();
+    double queueMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    const long long n = (long long)producers * perProducer;
+    const bool queueOk = popped.load() == n && sum.load() == n * (n - 1) / 2;
+
+    const std::vector<glm::ivec2> startup = chunks_around_camera(chunk_render_distance);
+    auto job_for = [&](const glm::ivec2 &c) {
+        return ChunkJob{ c, chunk_lod_octaves(c.x, c.y), g_jobEpoch, false, 0.0f };
+    };
+    std::vector<ChunkPayload> serial(startup.size());
+    double serialMs = bench_ms(1, [&] {
+        for (size_t i = 0; i < startup.size(); i++) {
+            serial[i].job = job_for(startup[i]);
+            build_chunk_payload(serial[i]);
+        }
+    });
+
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    start_chunk_workers(cores);
+    std::vector<int> arrivals(startup.size(), 0);
+    int mismatches = 0;
+    size_t submitted = 0, received = 0;
+    double pollMs = 0.0;    // longest the "GL thread" spent in one submit/collect round
+    double poolMs = bench_ms(1, [&] {
+        while (received < startup.size()) {
+            auto r0 = std::chrono::steady_clock::now();
+            while (submitted < startup.size() && queue_chunk_job(job_for(startup[submitted]))) submitted++;
+            ChunkPayload *payload;
+            while (g_chunkWorkers.ready.try_pop(payload)) {
+                g_chunkWorkers.inFlight--;
+                size_t i = std::find(startup.begin(), startup.end(), payload->job.chunk) - startup.begin();
+                if (i == startup.size()) {
+                    mismatches++;
+                } else {
+                    arrivals[i]++;
+                    const ChunkPayload &ref = serial[i];
+                    bool same = payload->verts == ref.verts && payload->nodeBounds == ref.nodeBounds &&
+                                payload->plants.size() == ref.plants.size() &&
+                                payload->grid.colors == ref.grid.colors;
+                    for (size_t k = 0; same && k < ref.plants.size(); k++)
+                        same = payload->plants[k].type == ref.plants[k].type &&
+                               payload->plants[k].xpos == ref.plants[k].xpos &&
+                               payload->plants[k].ypos == ref.plants[k].ypos &&
+                               payload->plants[k].zpos == ref.plants[k].zpos;
+                    mismatches += !same;
+                }
+                received++;
+                if (!g_chunkWorkers.spare.try_push(payload)) delete payload;
+            }
+            pollMs = std::max(pollMs, std::chrono::duration<double, std::milli>(
+                                          std::chrono::steady_clock::now() - r0).count());
+            std::this_thread::yield();
+        }
+    });
+    stop_chunk_workers();
+    const bool onceEach = std::all_of(arrivals.begin(), arrivals.end(), [](int a) { return a == 1; });
+
+    printf("\n== chunk worker pool ==\n");
+    printf("queue: %d producers x %d, %d consumers: %.1f ms, %s\n", producers, perProducer, consumers, queueMs,
+           queueOk ? "every value once" : "LOST OR DUPLICATED VALUES");
+    printf("%d chunks: serial %.1f ms, %u workers %.1f ms (%.2fx), longest main-thread round %.3f ms\n",
+           (int)startup.size(), serialMs, cores, poolMs, serialMs / poolMs, pollMs);
+    printf("payload mismatches %d, %s\n", mismatches, onceEach ? "each chunk once" : "CHUNKS MISSING OR REPEATED");
+    return queueOk && mismatches == 0 && onceEach;
+}
+
+int run_benchmarks() {
+    printf("[BENCH] best SIMD level on this CPU: %s\n", simd_level_name(clamp_simd_level(SimdLevel::AVX2)));
+    bool ok = bench_perlin_batch();
+    ok = bench_fbm() && ok;
+    ok = bench_analytic_normals() && ok;
+    ok = bench_index_buffer() && ok;
+    ok = bench_index_order() && ok;
+    ok = bench_cdlod() && ok;
+    ok = bench_rtin() && ok;
+    ok = bench_flat_shading() && ok;
+    ok = bench_chunk_size() && ok;
+    ok = bench_vertex_format() && ok;
+    ok = bench_fused_chunk() && ok;
+    ok = bench_noise_backends() && ok;
+    ok = bench_hash_noise() && ok;
+    ok = bench_domain_warp() && ok;
+    ok = bench_multifractal() && ok;
+    ok = bench_noise_graph() && ok;
+    ok = bench_octave_lod() && ok;
+    ok = bench_fixed_point() && ok;
+    ok = bench_noise_context() && ok;
+    ok = bench_volume() && ok;
+    ok = bench_chunk_workers() && ok;
+    printf("\n[BENCH] %s\n", ok ? "all checks passed" : "CHECK FAILED");
+    return ok ? 0 : 1;
+}
+
+#endif
@@ -1,1644 +1,3330 @@
-#include <cmath>
-#include <string>
-#include <random>
-#include <iostream>
-#include <math.h>
-#include <cstdlib>
-#include <vector>
-#include <algorithm>
-#include <cstdio>
-
-#include "include/glad/glad.h"
-#include <GLFW/glfw3.h>
-#include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
-
-#define TINYOBJLOADER_IMPLEMENTATION
-#include "lib/tiny_obj_loader.h"
-#include "shader.h"
-#include "camera.h"
-#include "perlin.h"
-
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-
-const GLint WIDTH = 1920, HEIGHT = 1080;
-
-// ---- Text renderer globals ----
-GLuint g_textVAO = 0, g_textVBO = 0;
-GLuint g_fontTex = 0;
-Shader* g_textShader = nullptr;
-
-static const int FONT_ATLAS_W = 1024;
-static const int FONT_ATLAS_H = 1024;
-int g_fontW = 0;
-int g_fontH = 0;
-static const int FONT_GRID = 16;
-
-// ---- Environment params ----
-enum class Season { SPRING = 0, SUMMER = 1, AUTUMN = 2, WINTER = 3 };
-enum class Weather { CLEAR = 0, RAINY = 1, SNOWY = 2 };
-enum class TimeOfDay { DAY = 0, DUSK = 1, NIGHT = 2, DAWN = 3 };
-TimeOfDay gTimeOfDay = TimeOfDay::DAY;
-
-Season gSeason = Season::SUMMER;
-Weather gWeather = Weather::CLEAR;
-float gHumidity = 0.3f;
-
-std::vector<std::vector<float>> g_chunkVertices;
-
-// ----------------- Structs -----------------
-struct plant {
-    std::string type;
-    float xpos;
-    float ypos;
-    float zpos;
-    int xOffset;
-    int yOffset;
-
-    plant(std::string _type, float _xpos, float _ypos, float _zpos, int _xOffset, int _yOffset) {
-        type = _type;
-        xpos = _xpos;
-        ypos = _ypos;
-        zpos = _zpos;
-        xOffset = _xOffset;
-        yOffset = _yOffset;
-    }
-};
-
-// ---- UI stuff ----
-enum class UIButtonType {
-    SEASON_SPRING,
-    SEASON_SUMMER,
-    SEASON_AUTUMN,
-    SEASON_WINTER,
-    TIME_DAY,
-    TIME_DUSK,
-    TIME_NIGHT,
-    TIME_DAWN,
-    HUMIDITY_UP,
-    HUMIDITY_DOWN
-};
-
-struct UIButton {
-    UIButtonType type;
-    glm::vec2 center;
-    glm::vec2 halfSize;
-    glm::vec4 color;
-};
-
-GLuint g_uiVAO = 0, g_uiVBO = 0;
-std::vector<UIButton> g_buttons;
-bool g_uiMode = false;
-
-// ----------------- Global state -----------------
-GLFWwindow *window = nullptr;
-
-// Map params
-float WATER_HEIGHT = 0.1f;
-int chunk_render_distance = 3;
-int xMapChunks = 10;
-int yMapChunks = 10;
-int chunkWidth = 127;
-int chunkHeight = 127;
-int gridPosX = 0;
-int gridPosY = 0;
-float originX = (chunkWidth * xMapChunks) / 2 - chunkWidth / 2;
-float originY = (chunkHeight * yMapChunks) / 2 - chunkHeight / 2;
-
-// Noise params
-int octaves = 5;
-float meshHeight = 32.0f;
-float noiseScale = 64.0f;
-float persistence = 0.5f;
-float lacunarity = 2.0f;
-
-// Model params
-float MODEL_SCALE = 3.0f;
-float MODEL_BRIGHTNESS = 6.0f;
-
-// FPS
-double lastTime = 0.0;
-int nbFrames = 0;
-
-// ---- Model minY tracking ----
-float g_treeMinY = 0.0f;
-float g_flowerMinY = 0.0f;
-bool g_modelMinYInitialized = false; // kept for compatibility (no longer required)
-
-// ---- FIX: Per-chunk terrain GL buffers (for updating colors) ----
-std::vector<GLuint> g_mapPosVBO;
-std::vector<GLuint> g_mapNormalVBO;
-std::vector<GLuint> g_mapColorVBO;
-std::vector<GLuint> g_mapEBO;
-
-// ---- FIX: Per-chunk instancing buffers & counts ----
-std::vector<GLuint> g_treeInstanceVBO;
-std::vector<GLuint> g_flowerInstanceVBO;
-std::vector<GLsizei> g_treeInstanceCount;
-std::vector<GLsizei> g_flowerInstanceCount;
-
-// ---- FIX: Model vertex counts (avoid hard-coded 10192/1300) ----
-int g_treeVertexCount   = 0;
-int g_flowerVertexCount = 0;
-
-// ---- FIX: Model minY loaded flags ----
-bool g_treeMinYSet   = false;
-bool g_flowerMinYSet = false;
-
-// Camera
-Camera camera(glm::vec3(originX, 20.0f, originY));
-bool firstMouse = true;
-float lastX = WIDTH / 2;
-float lastY = HEIGHT / 2;
-
-// Timing
-float deltaTime = 0.0f;
-float lastFrame = 0.0f;
-float currentFrame = 0.0f;
-
-// Chunk & plant globals
-std::vector<GLuint> g_map_chunks;
-std::vector<GLuint> g_tree_chunks;
-std::vector<GLuint> g_flower_chunks;
-GLuint g_treeVAO = 0, g_flowerVAO = 0;
-std::vector<plant> g_plants;
-
-// ----------------- Forward declarations -----------------
-int init();
-void processInput(GLFWwindow *window, Shader &shader);
-void mouse_callback(GLFWwindow *window, double xpos, double ypos);
-void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
-void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
-
-void render(std::vector<GLuint> &map_chunks, Shader &shader,
-            glm::mat4 &view, glm::mat4 &model, glm::mat4 &projection,
-            int &nIndices, std::vector<GLuint> &tree_chunks,
-            std::vector<GLuint> &flower_chunks, Shader &uiShader);
-
-std::vector<int> generate_indices();
-std::vector<float> generate_noise_map(int xOffset, int yOffset);
-std::vector<float> generate_vertices(const std::vector<float> &noise_map);
-std::vector<float> generate_normals(const std::vector<int> &indices, const std::vector<float> &vertices);
-std::vector<float> generate_biome(
-    const std::vector<float> &vertices,
-    std::vector<plant> &plants,
-    int xOffset, int yOffset,
-    Season season,
-    Weather weather,
-    float humidity
-);
-void generate_map_chunk(GLuint &VAO, int xOffset, int yOffset, std::vector<plant> &plants);
-
-float get_terrain_height_at(float worldX, float worldZ,
-                            const std::vector<float>& vertices,
-                            int chunkWidth, int chunkHeight);
-
-float load_model(GLuint &VAO, std::string filename, int* outVertexCount);
-void setup_instancing(GLuint &VAO, std::vector<GLuint> &plant_chunk, std::string plant_type,
-                      std::vector<plant> &plants, std::string filename);
-
-void rebuild_world();
-void update_terrain_colors_only();
-
-// UI helpers
-void init_ui_geometry();
-void init_ui_buttons();
-void on_button_clicked(UIButtonType type);
-void handle_ui_click(double mouseX, double mouseY);
-void draw_ui(Shader &uiShader);
-
-// Text rendering helpers
-void init_text_renderer();
-void draw_text(Shader& sh, const std::string& text, float xNDC, float yNDC, float sizeNDC, glm::vec3 color);
-
-glm::vec3 gSky = {0.53f, 0.81f, 0.92f};
-Shader* gObjectShader = nullptr;
-
-// ============ applySeasonParams() ============
-void applySeasonParams(Shader& sh){
-    glm::vec3 sky, amb, dif, spc;
-    float fogStart, fogEnd;
-
-    switch (gSeason){
-    case Season::SPRING:
-        sky = {0.60f, 0.86f, 0.98f};
-        amb = {0.26f, 0.26f, 0.26f};
-        dif = {0.45f, 0.45f, 0.45f};
-        spc = {1.00f, 1.00f, 1.00f};
-        fogStart = 120.f; fogEnd = 260.f;
-        break;
-    case Season::SUMMER:
-        sky = {0.35f, 0.70f, 0.98f};
-        amb = {0.22f, 0.22f, 0.22f};
-        dif = {0.55f, 0.55f, 0.55f};
-        spc = {1.00f, 1.00f, 1.00f};
-        fogStart = 160.f; fogEnd = 340.f;
-        break;
-    case Season::AUTUMN:
-        sky = {0.55f, 0.70f, 0.82f};
-        amb = {0.18f, 0.16f, 0.14f};
-        dif = {0.35f, 0.30f, 0.26f};
-        spc = {0.90f, 0.85f, 0.80f};
-        fogStart = 90.f;  fogEnd = 200.f;
-        break;
-    case Season::WINTER:
-        sky = {0.65f, 0.78f, 0.88f};
-        amb = {0.24f, 0.26f, 0.30f};
-        dif = {0.45f, 0.48f, 0.55f};
-        spc = {1.10f, 1.10f, 1.10f};
-        fogStart = 70.f;  fogEnd = 170.f;
-        break;
-    }
-
-    switch (gTimeOfDay) {
-    case TimeOfDay::DAY:
-        break;
-    case TimeOfDay::DUSK:
-        sky = glm::vec3(0.8f, 0.5f, 0.3f) * 0.7f;
-        amb *= 0.5f;
-        dif *= 0.6f;
-        fogStart *= 0.7f;
-        fogEnd *= 0.7f;
-        break;
-    case TimeOfDay::NIGHT:
-        sky = glm::vec3(0.05f, 0.08f, 0.15f);
-        amb *= 0.15f;
-        dif *= 0.20f;
-        spc *= 0.8f;
-        fogStart *= 0.5f;
-        fogEnd *= 0.5f;
-        break;
-    case TimeOfDay::DAWN:
-        sky = glm::vec3(0.7f, 0.5f, 0.7f) * 0.6f;
-        amb *= 0.6f;
-        dif *= 0.7f;
-        fogStart *= 0.8f;
-        fogEnd *= 0.8f;
-        break;
-    }
-
-    gSky = sky;
-
-    sh.use();
-    sh.setInt("u_season", (int)gSeason);
-    sh.setInt("u_timeOfDay", (int)gTimeOfDay);
-    sh.setFloat("u_humidity", gHumidity);
-    sh.setVec3("u_skyColor", gSky);
-    sh.setFloat("u_meshHeight", meshHeight);
-    sh.setFloat("u_fogStart", fogStart);
-    sh.setFloat("u_fogEnd", fogEnd);
-
-    sh.setVec3("light.ambient",  amb.x, amb.y, amb.z);
-    sh.setVec3("light.diffuse",  dif.x, dif.y, dif.z);
-    sh.setVec3("light.specular", spc.x, spc.y, spc.z);
-}
-
-// ----------------- Text rendering implementation -----------------
-void init_text_renderer() {
-    if (g_textVAO != 0) return;
-
-    glGenVertexArrays(1, &g_textVAO);
-    glGenBuffers(1, &g_textVBO);
-
-    glBindVertexArray(g_textVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, g_textVBO);
-
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4 * 1024, nullptr, GL_DYNAMIC_DRAW);
-
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-}
-
-static inline void push_quad(std::vector<float>& v,
-                             float x0, float y0, float x1, float y1,
-                             float u0, float v0, float u1, float v1)
-{
-    v.insert(v.end(), { x0,y0,u0,v0, x1,y0,u1,v0, x1,y1,u1,v1 });
-    v.insert(v.end(), { x0,y0,u0,v0, x1,y1,u1,v1, x0,y1,u0,v1 });
-}
-
-float measure_text_width_ndc(const std::string& text, float sizeNDC) {
-    int currentWidth, currentHeight;
-    glfwGetFramebufferSize(window, &currentWidth, &currentHeight);
-    float aspectFix = float(currentHeight) / float(currentWidth);
-
-    float glyphW = sizeNDC * aspectFix;
-    float advance = glyphW * 0.70f;
-
-    int n = 0;
-    for (unsigned char c : text) {
-        if (c == '\n') break;
-        n++;
-    }
-    if (n <= 0) return 0.0f;
-    return (n - 1) * advance + glyphW;
-}
-
-void draw_text_centered_in_button(const UIButton& btn,
-                                  const std::string& label,
-                                  float sizeNDC,
-                                  glm::vec3 color)
-{
-    float w = measure_text_width_ndc(label, sizeNDC);
-    float x = btn.center.x - 0.5f * w;
-    float y = btn.center.y - 0.5f * sizeNDC;
-    draw_text(*g_textShader, label, x, y, sizeNDC, color);
-}
-
-void draw_text(Shader& sh, const std::string& text, float xNDC, float yNDC, float sizeNDC, glm::vec3 color)
-{
-    if (g_textVAO == 0 || g_fontTex == 0) return;
-
-    int currentWidth, currentHeight;
-    glfwGetFramebufferSize(window, &currentWidth, &currentHeight);
-    float aspectFix = float(currentHeight) / float(currentWidth);
-
-    float glyphH = sizeNDC;
-    float glyphW = sizeNDC * aspectFix;
-    float advance = glyphW * 0.70f;
-
-    float epsU = 0.5f / float(g_fontW > 0 ? g_fontW : 1024);
-    float epsV = 0.5f / float(g_fontH > 0 ? g_fontH : 1024);
-
-    std::vector<float> verts;
-    verts.reserve(text.size() * 6 * 4);
-
-    float penX = xNDC;
-    float penY = yNDC;
-
-    for (unsigned char c : text) {
-        if (c == '\n') { penX = xNDC; penY -= glyphH * 1.2f; continue; }
-        if (c == ' ') { penX += advance; continue; }
-
-        unsigned char uc = (unsigned char)c;
-        int col = uc & 15;
-        int row = uc >> 4;
-
-        float u0 = (col + 0.0f) / float(FONT_GRID) + epsU;
-        float u1 = (col + 1.0f) / float(FONT_GRID) - epsU;
-
-        float vTop = 1.0f - (row + 0.0f) / float(FONT_GRID);
-        float vBottom = 1.0f - (row + 1.0f) / float(FONT_GRID);
-        float v0 = vBottom + epsV;
-        float v1 = vTop - epsV;
-
-        float x0 = penX;
-        float y0 = penY;
-        float x1 = penX + glyphW;
-        float y1 = penY + glyphH;
-
-        push_quad(verts, x0, y0, x1, y1, u0, v0, u1, v1);
-        penX += advance;
-    }
-
-    sh.use();
-    sh.setVec3("textColor", color);
-    sh.setInt("uFont", 0);
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, g_fontTex);
-
-    glBindVertexArray(g_textVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, g_textVBO);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, verts.size() * sizeof(float), verts.data());
-    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(verts.size() / 4));
-    glBindVertexArray(0);
-}
-
-// load texture 2d
-GLuint load_texture_2d(const char* path) {
-    int w, h, n;
-    stbi_set_flip_vertically_on_load(true);
-    unsigned char* data = stbi_load(path, &w, &h, &n, 4);
-    if (!data) {
-        std::cout << "Failed to load texture: " << path << "\n";
-        return 0;
-    }
-    g_fontW = w;
-    g_fontH = h;
-    GLuint tex;
-    glGenTextures(1, &tex);
-    glBindTexture(GL_TEXTURE_2D, tex);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    glBindTexture(GL_TEXTURE_2D, 0);
-    stbi_image_free(data);
-    return tex;
-}
-
-// ----------------- UI implementation -----------------
-void init_ui_geometry() {
-    if (g_uiVAO != 0) return;
-
-    float quadVertices[] = {
-        -1.0f, -1.0f,
-         1.0f, -1.0f,
-         1.0f,  1.0f,
-        -1.0f, -1.0f,
-         1.0f,  1.0f,
-        -1.0f,  1.0f
-    };
-
-    glGenVertexArrays(1, &g_uiVAO);
-    glGenBuffers(1, &g_uiVBO);
-
-    glBindVertexArray(g_uiVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, g_uiVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-}
-
-void init_ui_buttons() {
-    g_buttons.clear();
-
-    float btnHalfH = 0.04f;
-    float btnHalfW = 0.09f;
-    float gap = 0.02f;
-
-    auto addBtn = [&](UIButtonType type, float x, float y, glm::vec4 color) {
-        UIButton b;
-        b.type = type;
-        b.center = glm::vec2(x, y);
-        b.halfSize = glm::vec2(btnHalfW, btnHalfH);
-        b.color = color;
-        g_buttons.push_back(b);
-    };
-
-    float topY = 0.85f;
-    float startX = -0.9f;
-
-    addBtn(UIButtonType::SEASON_SPRING, startX + btnHalfW, topY, glm::vec4(0.7f, 1.0f, 0.7f, 0.6f));
-    startX += btnHalfW * 2.0f + gap;
-    addBtn(UIButtonType::SEASON_SUMMER, startX + btnHalfW, topY, glm::vec4(0.3f, 0.8f, 0.3f, 0.6f));
-    startX += btnHalfW * 2.0f + gap;
-    addBtn(UIButtonType::SEASON_AUTUMN, startX + btnHalfW, topY, glm::vec4(0.9f, 0.6f, 0.2f, 0.6f));
-    startX += btnHalfW * 2.0f + gap;
-    addBtn(UIButtonType::SEASON_WINTER, startX + btnHalfW, topY, glm::vec4(0.7f, 0.8f, 1.0f, 0.6f));
-
-    float timeY = 0.75f;
-    startX = -0.9f;
-
-    addBtn(UIButtonType::TIME_DAY, startX + btnHalfW, timeY, glm::vec4(1.0f, 1.0f, 0.5f, 0.6f));
-    startX += btnHalfW * 2.0f + gap;
-    addBtn(UIButtonType::TIME_DUSK, startX + btnHalfW, timeY, glm::vec4(1.0f, 0.6f, 0.3f, 0.6f));
-    startX += btnHalfW * 2.0f + gap;
-    addBtn(UIButtonType::TIME_NIGHT, startX + btnHalfW, timeY, glm::vec4(0.2f, 0.2f, 0.5f, 0.6f));
-    startX += btnHalfW * 2.0f + gap;
-    addBtn(UIButtonType::TIME_DAWN, startX + btnHalfW, timeY, glm::vec4(0.8f, 0.5f, 0.8f, 0.6f));
-
-    float humidityBtnHalfW = 0.05f;
-    float humidityBtnHalfH = 0.04f;
-    float humidityGap = 0.03f;
-
-    UIButton down, up;
-
-    down.type = UIButtonType::HUMIDITY_DOWN;
-    down.center = glm::vec2(0.72f, 0.85f);
-    down.halfSize = glm::vec2(humidityBtnHalfW, humidityBtnHalfH);
-    down.color = glm::vec4(1.0f, 0.5f, 0.3f, 0.6f);
-    g_buttons.push_back(down);
-
-    up.type = UIButtonType::HUMIDITY_UP;
-    up.center = glm::vec2(0.72f + humidityBtnHalfW * 2.0f + humidityGap, 0.85f);
-    up.halfSize = glm::vec2(humidityBtnHalfW, humidityBtnHalfH);
-    up.color = glm::vec4(0.2f, 0.8f, 1.0f, 0.6f);
-    g_buttons.push_back(up);
-
-    std::cout << "[DEBUG] Button layout:" << std::endl;
-    for (size_t i = 0; i < g_buttons.size(); i++) {
-        std::cout << "  [" << i << "] type=" << (int)g_buttons[i].type
-                  << " center=(" << g_buttons[i].center.x << ", " << g_buttons[i].center.y << ")"
-                  << " bounds=[" << (g_buttons[i].center.x - g_buttons[i].halfSize.x) << " to "
-                  << (g_buttons[i].center.x + g_buttons[i].halfSize.x) << "]" << std::endl;
-    }
-}
-
-// ----------------- FIX: terrain chunk destroy helper -----------------
-static inline void destroy_map_chunk(int pos) {
-    if (pos < 0 || pos >= (int)g_map_chunks.size()) return;
-
-    if (g_map_chunks[pos]) glDeleteVertexArrays(1, &g_map_chunks[pos]);
-    if (!g_mapPosVBO.empty() && g_mapPosVBO[pos]) glDeleteBuffers(1, &g_mapPosVBO[pos]);
-    if (!g_mapNormalVBO.empty() && g_mapNormalVBO[pos]) glDeleteBuffers(1, &g_mapNormalVBO[pos]);
-    if (!g_mapColorVBO.empty() && g_mapColorVBO[pos]) glDeleteBuffers(1, &g_mapColorVBO[pos]);
-    if (!g_mapEBO.empty() && g_mapEBO[pos]) glDeleteBuffers(1, &g_mapEBO[pos]);
-
-    g_map_chunks[pos] = 0;
-    if (!g_mapPosVBO.empty()) g_mapPosVBO[pos] = 0;
-    if (!g_mapNormalVBO.empty()) g_mapNormalVBO[pos] = 0;
-    if (!g_mapColorVBO.empty()) g_mapColorVBO[pos] = 0;
-    if (!g_mapEBO.empty()) g_mapEBO[pos] = 0;
-}
-
-// ----------------- FIX: only update terrain colors -----------------
-void update_terrain_colors_only() {
-    for (int y = 0; y < yMapChunks; y++) {
-        for (int x = 0; x < xMapChunks; x++) {
-            int pos = x + y * xMapChunks;
-            if (pos < 0 || pos >= (int)g_map_chunks.size()) continue;
-            if (g_map_chunks[pos] == 0) continue;
-            if (pos >= (int)g_chunkVertices.size()) continue;
-
-            const std::vector<float>& verts = g_chunkVertices[pos];
-            if (verts.empty()) continue;
-
-            std::vector<plant> dummy_plants;
-            std::vector<float> colors = generate_biome(verts, dummy_plants, x, y, gSeason, gWeather, gHumidity);
-
-            if (pos < (int)g_mapColorVBO.size() && g_mapColorVBO[pos] != 0) {
-                glBindBuffer(GL_ARRAY_BUFFER, g_mapColorVBO[pos]);
-                glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(float), colors.data(), GL_STATIC_DRAW);
-                glBindBuffer(GL_ARRAY_BUFFER, 0);
-            }
-        }
-    }
-}
-
-// ----------------- FIX: on_button_clicked -----------------
-void on_button_clicked(UIButtonType type) {
-    enum class UpdateKind { NONE, COLORS_ONLY, FULL_REBUILD };
-    UpdateKind upd = UpdateKind::NONE;
-
-    std::cout << "[DEBUG] Button clicked, type = " << (int)type << std::endl;
-
-    switch (type) {
-    case UIButtonType::SEASON_SPRING:
-        if (gSeason != Season::SPRING) { gSeason = Season::SPRING; upd = UpdateKind::FULL_REBUILD; }
-        break;
-    case UIButtonType::SEASON_SUMMER:
-        if (gSeason != Season::SUMMER) { gSeason = Season::SUMMER; upd = UpdateKind::FULL_REBUILD; }
-        break;
-    case UIButtonType::SEASON_AUTUMN:
-        if (gSeason != Season::AUTUMN) { gSeason = Season::AUTUMN; upd = UpdateKind::FULL_REBUILD; }
-        break;
-    case UIButtonType::SEASON_WINTER:
-        if (gSeason != Season::WINTER) { gSeason = Season::WINTER; upd = UpdateKind::FULL_REBUILD; }
-        break;
-
-    case UIButtonType::HUMIDITY_UP:
-        gHumidity = std::min(1.0f, gHumidity + 0.1f);
-        upd = UpdateKind::COLORS_ONLY;
-        break;
-    case UIButtonType::HUMIDITY_DOWN:
-        gHumidity = std::max(0.0f, gHumidity - 0.1f);
-        upd = UpdateKind::COLORS_ONLY;
-        break;
-
-    case UIButtonType::TIME_DAY:   gTimeOfDay = TimeOfDay::DAY;   upd = UpdateKind::NONE; break;
-    case UIButtonType::TIME_DUSK:  gTimeOfDay = TimeOfDay::DUSK;  upd = UpdateKind::NONE; break;
-    case UIButtonType::TIME_NIGHT: gTimeOfDay = TimeOfDay::NIGHT; upd = UpdateKind::NONE; break;
-    case UIButtonType::TIME_DAWN:  gTimeOfDay = TimeOfDay::DAWN;  upd = UpdateKind::NONE; break;
-    }
-
-    std::cout << "[UI] Final state - Season=" << (int)gSeason
-              << " Humidity=" << gHumidity
-              << " Time=" << (int)gTimeOfDay << std::endl;
-
-    if (gObjectShader) applySeasonParams(*gObjectShader);
-
-    if (upd == UpdateKind::FULL_REBUILD) rebuild_world();
-    else if (upd == UpdateKind::COLORS_ONLY) update_terrain_colors_only();
-}
-
-void handle_ui_click(double mouseX, double mouseY) {
-    if (!g_uiMode) return;
-
-    int currentWidth, currentHeight;
-    glfwGetFramebufferSize(window, &currentWidth, &currentHeight);
-
-    float ndcX = 2.0f * float(mouseX) / float(currentWidth) - 1.0f;
-    float ndcY = -2.0f * float(mouseY) / float(currentHeight) + 1.0f;
-
-    std::cout << "[CLICK] Window size: " << currentWidth << "x" << currentHeight
-              << " | Mouse: (" << mouseX << ", " << mouseY << ") -> NDC: ("
-              << ndcX << ", " << ndcY << ")" << std::endl;
-
-    for (int i = 0; i < (int)g_buttons.size(); i++) {
-        const auto& btn = g_buttons[i];
-        glm::vec2 min = btn.center - btn.halfSize;
-        glm::vec2 max = btn.center + btn.halfSize;
-
-        if (ndcX >= min.x && ndcX <= max.x &&
-            ndcY >= min.y && ndcY <= max.y) {
-            std::cout << "  Button[" << i << "] type=" << (int)btn.type << " HIT!" << std::endl;
-            on_button_clicked(btn.type);
-            return;
-        }
-    }
-
-    std::cout << "[CLICK] No button hit" << std::endl;
-}
-
-void mouse_button_callback(GLFWwindow* window_, int button, int action, int mods) {
-    (void)window_; (void)mods;
-    if (!g_uiMode) return;
-
-    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
-        double mx, my;
-        glfwGetCursorPos(window, &mx, &my);
-        handle_ui_click(mx, my);
-    }
-}
-
-void draw_ui(Shader &uiShader) {
-    glDisable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    uiShader.use();
-    glBindVertexArray(g_uiVAO);
-
-    for (auto &btn : g_buttons) {
-        uiShader.setVec4("uColor", btn.color);
-        uiShader.setVec2("uPos", btn.center);
-        uiShader.setVec2("uSize", btn.halfSize);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-    }
-
-    glBindVertexArray(0);
-    glDisable(GL_BLEND);
-    glEnable(GL_DEPTH_TEST);
-}
-
-// ----------------- World generation helpers -----------------
-void rebuild_world() {
-    g_plants.clear();
-
-    for (int y = 0; y < yMapChunks; y++) {
-        for (int x = 0; x < xMapChunks; x++) {
-            int pos = x + y * xMapChunks;
-            generate_map_chunk(g_map_chunks[pos], x, y, g_plants);
-        }
-    }
-
-    setup_instancing(g_treeVAO, g_tree_chunks, "tree", g_plants, "obj/CommonTree_1.obj");
-    setup_instancing(g_flowerVAO, g_flower_chunks, "flower", g_plants, "obj/Flowers.obj");
-}
-
-// ----------------- main -----------------
-int main() {
-    glm::mat4 view;
-    glm::mat4 model;
-    glm::mat4 projection;
-
-    if (init() != 0)
-        return -1;
-
-    Shader objectShader("shaders/objectShader.vert", "shaders/objectShader.frag");
-    Shader uiShader("shaders/uiShader.vert", "shaders/uiShader.frag");
-
-    objectShader.use();
-    objectShader.setBool("isFlat", true);
-
-    objectShader.setVec3("light.ambient", 0.2f, 0.2f, 0.2f);
-    objectShader.setVec3("light.diffuse", 0.3f, 0.3f, 0.3f);
-    objectShader.setVec3("light.specular", 1.0f, 1.0f, 1.0f);
-    objectShader.setVec3("light.direction", -0.2f, -1.0f, -0.3f);
-
-    objectShader.setInt("u_season", (int)gSeason);
-
-    int chunkN = xMapChunks * yMapChunks;
-    g_map_chunks.resize(chunkN);
-    g_tree_chunks.resize(chunkN);
-    g_flower_chunks.resize(chunkN);
-    g_chunkVertices.resize(chunkN);
-
-    // ---- FIX: allocate terrain buffers ----
-    g_mapPosVBO.assign(chunkN, 0);
-    g_mapNormalVBO.assign(chunkN, 0);
-    g_mapColorVBO.assign(chunkN, 0);
-    g_mapEBO.assign(chunkN, 0);
-
-    // ---- FIX: allocate instancing buffers/count ----
-    g_treeInstanceVBO.assign(chunkN, 0);
-    g_flowerInstanceVBO.assign(chunkN, 0);
-    g_treeInstanceCount.assign(chunkN, 0);
-    g_flowerInstanceCount.assign(chunkN, 0);
-
-    gObjectShader = &objectShader;
-    applySeasonParams(objectShader);
-    rebuild_world();
-
-    int nIndices = chunkWidth * chunkHeight * 6;
-
-    lastTime = glfwGetTime();
-    nbFrames = 0;
-
-    while (!glfwWindowShouldClose(window)) {
-        objectShader.use();
-        projection = glm::perspective(glm::radians(camera.Zoom),
-                                      (float)WIDTH / (float)HEIGHT,
-                                      0.1f,
-                                      (float)chunkWidth * (chunk_render_distance - 1.2f));
-        view = camera.GetViewMatrix();
-        objectShader.setMat4("u_projection", projection);
-        objectShader.setMat4("u_view", view);
-        objectShader.setVec3("u_viewPos", camera.Position);
-
-        render(g_map_chunks, objectShader, view, model, projection,
-               nIndices, g_tree_chunks, g_flower_chunks, uiShader);
-    }
-
-    // cleanup
-    for (int i = 0; i < (int)g_map_chunks.size(); i++) {
-        if (g_tree_chunks[i]) glDeleteVertexArrays(1, &g_tree_chunks[i]);
-        if (g_flower_chunks[i]) glDeleteVertexArrays(1, &g_flower_chunks[i]);
-    }
-
-    for (int i = 0; i < (int)g_map_chunks.size(); i++) {
-        destroy_map_chunk(i);
-    }
-
-    for (auto b : g_treeInstanceVBO) if (b) glDeleteBuffers(1, &b);
-    for (auto b : g_flowerInstanceVBO) if (b) glDeleteBuffers(1, &b);
-
-    if (g_textVAO) glDeleteVertexArrays(1, &g_textVAO);
-    if (g_textVBO) glDeleteBuffers(1, &g_textVBO);
-    if (g_fontTex) glDeleteTextures(1, &g_fontTex);
-    if (g_uiVAO) glDeleteVertexArrays(1, &g_uiVAO);
-    if (g_uiVBO) glDeleteBuffers(1, &g_uiVBO);
-
-    delete g_textShader;
-    glfwTerminate();
-    return 0;
-}
-
-// ----------------- instancing & render -----------------
-void setup_instancing(GLuint &VAO, std::vector<GLuint> &plant_chunk, std::string plant_type,
-                      std::vector<plant> &plants, std::string filename) {
-    (void)VAO;
-
-    const int chunkN = xMapChunks * yMapChunks;
-    if ((int)plant_chunk.size() != chunkN) plant_chunk.resize(chunkN, 0);
-
-    std::vector<GLuint>* instVBOs = nullptr;
-    std::vector<GLsizei>* instCnt = nullptr;
-
-    if (plant_type == "tree") {
-        instVBOs = &g_treeInstanceVBO;
-        instCnt  = &g_treeInstanceCount;
-    } else {
-        instVBOs = &g_flowerInstanceVBO;
-        instCnt  = &g_flowerInstanceCount;
-    }
-
-    if ((int)instVBOs->size() != chunkN) instVBOs->assign(chunkN, 0);
-    if ((int)instCnt->size()  != chunkN) instCnt->assign(chunkN, 0);
-
-    // load model VAO for each chunk (only once), create instance VBOs
-    for (int i = 0; i < chunkN; i++) {
-        if (plant_chunk[i] == 0) {
-            int vcount = 0;
-            float minY = load_model(plant_chunk[i], filename, &vcount);
-
-            if (plant_type == "tree" && !g_treeMinYSet) {
-                g_treeMinY = minY; g_treeMinYSet = true; g_treeVertexCount = vcount;
-                std::cout << "[INFO] Tree minY=" << g_treeMinY << " vtx=" << g_treeVertexCount << "\n";
-            }
-            if (plant_type == "flower" && !g_flowerMinYSet) {
-                g_flowerMinY = minY; g_flowerMinYSet = true; g_flowerVertexCount = vcount;
-                std::cout << "[INFO] Flower minY=" << g_flowerMinY << " vtx=" << g_flowerVertexCount << "\n";
-            }
-        }
-        if ((*instVBOs)[i] == 0) {
-            glGenBuffers(1, &((*instVBOs)[i]));
-        }
-    }
-
-    float modelMinY = (plant_type == "tree") ? g_treeMinY : g_flowerMinY;
-
-    // collect instances per chunk
-    std::vector<std::vector<float>> chunkInstances(chunkN);
-
-    for (int i = 0; i < (int)plants.size(); i++) {
-        if (plants[i].type != plant_type) continue;
-
-        float xPos = plants[i].xpos / MODEL_SCALE;
-        float yPos = plants[i].ypos / MODEL_SCALE + (-modelMinY);
-        float zPos = plants[i].zpos / MODEL_SCALE;
-
-        int pos = plants[i].xOffset + plants[i].yOffset * xMapChunks;
-        if (pos < 0 || pos >= chunkN) continue;
-
-        chunkInstances[pos].push_back(xPos);
-        chunkInstances[pos].push_back(yPos);
-        chunkInstances[pos].push_back(zPos);
-    }
-
-    // upload instance buffers
-    for (int y = 0; y < yMapChunks; y++) {
-        for (int x = 0; x < xMapChunks; x++) {
-            int pos = x + y * xMapChunks;
-
-            glBindVertexArray(plant_chunk[pos]);
-            glBindBuffer(GL_ARRAY_BUFFER, (*instVBOs)[pos]);
-
-            auto& data = chunkInstances[pos];
-            glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float),
-                         data.empty() ? nullptr : data.data(),
-                         GL_STATIC_DRAW);
-
-            glEnableVertexAttribArray(3);
-            glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-            glVertexAttribDivisor(3, 1);
-
-            (*instCnt)[pos] = (GLsizei)(data.size() / 3);
-        }
-    }
-
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-}
-
-void render(std::vector<GLuint> &map_chunks, Shader &shader,
-            glm::mat4 &view, glm::mat4 &model, glm::mat4 &projection,
-            int &nIndices, std::vector<GLuint> &tree_chunks,
-            std::vector<GLuint> &flower_chunks, Shader &uiShader) {
-
-    currentFrame = (float)glfwGetTime();
-    deltaTime = currentFrame - lastFrame;
-    lastFrame = currentFrame;
-
-    processInput(window, shader);
-
-    glClearColor(gSky.x, gSky.y, gSky.z, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-    gridPosX = (int)(camera.Position.x - originX) / chunkWidth + xMapChunks / 2;
-    gridPosY = (int)(camera.Position.z - originY) / chunkHeight + yMapChunks / 2;
-
-    for (int y = 0; y < yMapChunks; y++) {
-        for (int x = 0; x < xMapChunks; x++) {
-            if (std::abs(gridPosX - x) <= chunk_render_distance &&
-                (y - gridPosY) <= chunk_render_distance) {
-
-                int idx = x + y * xMapChunks;
-
-                // ---- terrain ----
-                model = glm::mat4(1.0f);
-                model = glm::translate(model,
-                    glm::vec3(-chunkWidth / 2.0f + (chunkWidth - 1) * x,
-                              0.0f,
-                              -chunkHeight / 2.0f + (chunkHeight - 1) * y));
-                shader.setMat4("u_model", model);
-                shader.setBool("u_isPlant", false);
-                shader.setInt("u_plantKind", 0);
-                shader.setInt("u_season", (int)gSeason);
-
-                glBindVertexArray(map_chunks[idx]);
-                glDrawElements(GL_TRIANGLES, nIndices, GL_UNSIGNED_INT, 0);
-
-                // ---- plants ----
-                model = glm::mat4(1.0f);
-                model = glm::translate(model,
-                    glm::vec3(-chunkWidth / 2.0f + (chunkWidth - 1) * x,
-                              0.0f,
-                              -chunkHeight / 2.0f + (chunkHeight - 1) * y));
-                model = glm::scale(model, glm::vec3(MODEL_SCALE));
-
-                shader.setMat4("u_model", model);
-                shader.setBool("u_isPlant", true);
-                shader.setInt("u_season", (int)gSeason);
-
-                glEnable(GL_CULL_FACE);
-
-                // flowers (FIX: use real instance count + real vertex count)
-                shader.setInt("u_plantKind", 1);
-                GLsizei fcnt = (idx < (int)g_flowerInstanceCount.size()) ? g_flowerInstanceCount[idx] : 0;
-                if (fcnt > 0) {
-                    glBindVertexArray(flower_chunks[idx]);
-                    glDrawArraysInstanced(GL_TRIANGLES, 0, g_flowerVertexCount, fcnt);
-                }
-
-                // trees (FIX)
-                shader.setInt("u_plantKind", 2);
-                GLsizei tcnt = (idx < (int)g_treeInstanceCount.size()) ? g_treeInstanceCount[idx] : 0;
-                if (tcnt > 0) {
-                    glBindVertexArray(tree_chunks[idx]);
-                    glDrawArraysInstanced(GL_TRIANGLES, 0, g_treeVertexCount, tcnt);
-                }
-
-                glDisable(GL_CULL_FACE);
-
-                shader.setBool("u_isPlant", false);
-                shader.setInt("u_plantKind", 0);
-                shader.setInt("u_season", (int)gSeason);
-            }
-        }
-    }
-
-    draw_ui(uiShader);
-
-    // ---- text ----
-    glDisable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    if (g_textShader) {
-        g_textShader->use();
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, g_fontTex);
-
-        float seasonSize = g_buttons[0].halfSize.y * 2.0f * 0.60f;
-        draw_text_centered_in_button(g_buttons[0], "SPRING", seasonSize, {1,1,1});
-        draw_text_centered_in_button(g_buttons[1], "SUMMER", seasonSize, {1,1,1});
-        draw_text_centered_in_button(g_buttons[2], "AUTUMN", seasonSize, {1,1,1});
-        draw_text_centered_in_button(g_buttons[3], "WINTER", seasonSize, {1,1,1});
-
-        draw_text_centered_in_button(g_buttons[4], "DAY", seasonSize, {1,1,1});
-        draw_text_centered_in_button(g_buttons[5], "DUSK", seasonSize, {1,1,1});
-        draw_text_centered_in_button(g_buttons[6], "NIGHT", seasonSize, {1,1,1});
-        draw_text_centered_in_button(g_buttons[7], "DAWN", seasonSize, {1,1,1});
-
-        float pmSize = g_buttons[8].halfSize.y * 2.0f * 0.80f;
-        draw_text_centered_in_button(g_buttons[8], "-", pmSize, {1,1,1});
-        draw_text_centered_in_button(g_buttons[9], "+", pmSize, {1,1,1});
-
-        std::string seasonText =
-            (gSeason == Season::SPRING) ? "Spring" :
-            (gSeason == Season::SUMMER) ? "Summer" :
-            (gSeason == Season::AUTUMN) ? "Autumn" : "Winter";
-
-        std::string timeText =
-            (gTimeOfDay == TimeOfDay::DAY) ? "Day" :
-            (gTimeOfDay == TimeOfDay::DUSK) ? "Dusk" :
-            (gTimeOfDay == TimeOfDay::NIGHT) ? "Night" : "Dawn";
-
-        draw_text(*g_textShader, "Season: " + seasonText, -0.95f, -0.80f, 0.06f, {1,1,0});
-        draw_text(*g_textShader, "Time: " + timeText, -0.95f, -0.86f, 0.06f, {1,0.8f,0.5f});
-        draw_text(*g_textShader, "Humidity: " + std::to_string(int(gHumidity * 100)) + "%",
-                  0.55f, -0.86f, 0.06f, {0.7f,0.9f,1.0f});
-    }
-
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glDisable(GL_BLEND);
-    glEnable(GL_DEPTH_TEST);
-
-    double currentTime = glfwGetTime();
-    nbFrames++;
-    if (currentTime - lastTime >= 1.0) {
-        printf("%f ms/frame\n", 1000.0 / double(nbFrames));
-        nbFrames = 0;
-        lastTime += 1.0;
-    }
-
-    glfwPollEvents();
-    glfwSwapBuffers(window);
-}
-
-// ? hIˬd
-static inline bool is_underwater_footprint(
-    float plantX, float plantZ,
-    const std::vector<float>& vertices,
-    int chunkWidth_, int chunkHeight_,
-    float waterLevel,
-    float radius)
-{
-    const float dx[9] = {0, radius, -radius, 0, 0, radius, radius, -radius, -radius};
-    const float dz[9] = {0, 0, 0, radius, -radius, radius, -radius, radius, -radius};
-
-    for (int i = 0; i < 9; i++) {
-        float h = get_terrain_height_at(plantX + dx[i], plantZ + dz[i],
-                                       vertices, chunkWidth_, chunkHeight_);
-        if (h <= waterLevel + 1.0f) return true;
-    }
-    return false;
-}
-
-// ----------------- Model loading & terrain -----------------
-float load_model(GLuint &VAO, std::string filename, int* outVertexCount) {
-    std::vector<float> vertices;
-    float minY = 1e9f;
-
-    tinyobj::attrib_t attrib;
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-
-    std::string warn;
-    std::string err;
-
-    bool ok = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filename.c_str());
-
-    if (!warn.empty()) std::cout << warn << std::endl;
-    if (!err.empty())  std::cerr << err << std::endl;
-    if (!ok) {
-        std::cerr << "[ERR] LoadObj failed: " << filename << std::endl;
-        if (outVertexCount) *outVertexCount = 0;
-        return 0.0f;
-    }
-
-    for (size_t s = 0; s < shapes.size(); s++) {
-        size_t index_offset = 0;
-        for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++) {
-            int fv = shapes[s].mesh.num_face_vertices[f];
-
-            int matId = -1;
-            if (f < shapes[s].mesh.material_ids.size()) matId = shapes[s].mesh.material_ids[f];
-
-            glm::vec3 diffuse(1.0f, 1.0f, 1.0f);
-            if (matId >= 0 && matId < (int)materials.size()) {
-                diffuse = glm::vec3(materials[matId].diffuse[0],
-                                    materials[matId].diffuse[1],
-                                    materials[matId].diffuse[2]);
-            }
-
-            for (int v = 0; v < fv; v++) {
-                tinyobj::index_t idx = shapes[s].mesh.indices[index_offset + v];
-
-                float px = attrib.vertices[3 * idx.vertex_index + 0];
-                float py = attrib.vertices[3 * idx.vertex_index + 1];
-                float pz = attrib.vertices[3 * idx.vertex_index + 2];
-
-                minY = std::min(minY, py);
-
-                glm::vec3 n(0,1,0);
-                if (idx.normal_index >= 0 && (3 * idx.normal_index + 2) < (int)attrib.normals.size()) {
-                    n = glm::vec3(attrib.normals[3 * idx.normal_index + 0],
-                                  attrib.normals[3 * idx.normal_index + 1],
-                                  attrib.normals[3 * idx.normal_index + 2]);
-                }
-
-                vertices.push_back(px);
-                vertices.push_back(py);
-                vertices.push_back(pz);
-                vertices.push_back(n.x);
-                vertices.push_back(n.y);
-                vertices.push_back(n.z);
-                vertices.push_back(diffuse.x * MODEL_BRIGHTNESS);
-                vertices.push_back(diffuse.y * MODEL_BRIGHTNESS);
-                vertices.push_back(diffuse.z * MODEL_BRIGHTNESS);
-            }
-            index_offset += fv;
-        }
-    }
-
-    if (outVertexCount) *outVertexCount = (int)vertices.size() / 9;
-
-    GLuint VBO;
-    glGenBuffers(1, &VBO);
-    glGenVertexArrays(1, &VAO);
-
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER,
-                 vertices.size() * sizeof(float),
-                 vertices.data(),
-                 GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-
-    glBindVertexArray(0);
-
-    return (minY == 1e9f) ? 0.0f : minY;
-}
-
-// FIXED generate_map_chunk (pos + store vertices at correct time + keep VBO handles)
-void generate_map_chunk(GLuint &VAO, int xOffset, int yOffset, std::vector<plant> &plants) {
-    int pos = xOffset + yOffset * xMapChunks;
-
-    if (pos >= 0 && pos < (int)g_map_chunks.size() && g_map_chunks[pos] != 0) {
-        destroy_map_chunk(pos);
-    }
-
-    std::vector<int> indices = generate_indices();
-    std::vector<float> noise_map = generate_noise_map(xOffset, yOffset);
-    std::vector<float> verts = generate_vertices(noise_map);
-    std::vector<float> normals = generate_normals(indices, verts);
-    std::vector<float> colors = generate_biome(verts, plants, xOffset, yOffset, gSeason, gWeather, gHumidity);
-
-    if (pos >= 0 && pos < (int)g_chunkVertices.size()) {
-        g_chunkVertices[pos] = verts;
-    }
-
-    GLuint VBOpos, VBOnrm, VBOcol, EBO;
-    glGenBuffers(1, &VBOpos);
-    glGenBuffers(1, &VBOnrm);
-    glGenBuffers(1, &VBOcol);
-    glGenBuffers(1, &EBO);
-    glGenVertexArrays(1, &VAO);
-
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBOpos);
-    glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(float), verts.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBOnrm);
-    glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(float), normals.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBOcol);
-    glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(float), colors.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(2);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(int), indices.data(), GL_STATIC_DRAW);
-
-    glBindVertexArray(0);
-
-    if (pos >= 0 && pos < (int)g_mapPosVBO.size())    g_mapPosVBO[pos] = VBOpos;
-    if (pos >= 0 && pos < (int)g_mapNormalVBO.size()) g_mapNormalVBO[pos] = VBOnrm;
-    if (pos >= 0 && pos < (int)g_mapColorVBO.size())  g_mapColorVBO[pos] = VBOcol;
-    if (pos >= 0 && pos < (int)g_mapEBO.size())       g_mapEBO[pos] = EBO;
-
-    if (pos >= 0 && pos < (int)g_map_chunks.size())   g_map_chunks[pos] = VAO;
-}
-
-glm::vec3 get_color(int r, int g, int b) {
-    return glm::vec3(r / 255.0f, g / 255.0f, b / 255.0f);
-}
-
-std::vector<float> generate_noise_map(int offsetX, int offsetY) {
-    std::vector<float> noiseValues;
-    std::vector<float> normalizedNoiseValues;
-    std::vector<int> p = get_permutation_vector();
-
-    float amp = 1.0f;
-    float freq = 1.0f;
-    float maxPossibleHeight = 0.0f;
-
-    for (int i = 0; i < octaves; i++) {
-        maxPossibleHeight += amp;
-        amp *= persistence;
-    }
-
-    for (int y = 0; y < chunkHeight; y++) {
-        for (int x = 0; x < chunkWidth; x++) {
-            amp = 1.0f;
-            freq = 1.0f;
-            float noiseHeight = 0.0f;
-            for (int i = 0; i < octaves; i++) {
-                float xSample = (x + offsetX * (chunkWidth - 1)) / noiseScale * freq;
-                float ySample = (y + offsetY * (chunkHeight - 1)) / noiseScale * freq;
-
-                float perlinValue = perlin_noise(xSample, ySample, p);
-                noiseHeight += perlinValue * amp;
-
-                amp *= persistence;
-                freq *= lacunarity;
-            }
-
-            noiseValues.push_back(noiseHeight);
-        }
-    }
-
-    for (int y = 0; y < chunkHeight; y++) {
-        for (int x = 0; x < chunkWidth; x++) {
-            normalizedNoiseValues.push_back((noiseValues[x + y * chunkWidth] + 1.0f) / maxPossibleHeight);
-        }
-    }
-
-    return normalizedNoiseValues;
-}
-
-static inline glm::vec3 lerp3(const glm::vec3& a, const glm::vec3& b, float t) {
-    t = std::fmax(0.0f, std::fmin(1.0f, t));
-    return a * (1.0f - t) + b * t;
-}
-
-struct terrainColor {
-    terrainColor(float _height, glm::vec3 _color) {
-        height = _height;
-        color = _color;
-    }
-    float height;
-    glm::vec3 color;
-};
-
-float get_terrain_height_at(float worldX, float worldZ, const std::vector<float>& vertices,
-                            int chunkWidth_, int chunkHeight_) {
-    int gridX = (int)worldX;
-    int gridZ = (int)worldZ;
-
-    gridX = std::max(0, std::min(gridX, chunkWidth_ - 2));
-    gridZ = std::max(0, std::min(gridZ, chunkHeight_ - 2));
-
-    float fracX = worldX - (float)gridX;
-    float fracZ = worldZ - (float)gridZ;
-
-    fracX = std::max(0.0f, std::min(1.0f, fracX));
-    fracZ = std::max(0.0f, std::min(1.0f, fracZ));
-
-    int idx00 = (gridX + gridZ * chunkWidth_) * 3;
-    int idx10 = ((gridX + 1) + gridZ * chunkWidth_) * 3;
-    int idx01 = (gridX + (gridZ + 1) * chunkWidth_) * 3;
-    int idx11 = ((gridX + 1) + (gridZ + 1) * chunkWidth_) * 3;
-
-    float h00 = vertices[idx00 + 1];
-    float h10 = vertices[idx10 + 1];
-    float h01 = vertices[idx01 + 1];
-    float h11 = vertices[idx11 + 1];
-
-    float h0 = h00 * (1.0f - fracX) + h10 * fracX;
-    float h1 = h01 * (1.0f - fracX) + h11 * fracX;
-    float height = h0 * (1.0f - fracZ) + h1 * fracZ;
-
-    return height;
-}
-
-static inline float compute_plant_ground_height(
-    float plantX, float plantZ,
-    const std::vector<float>& vertices,
-    int chunkWidth_, int chunkHeight_)
-{
-    float sampleRadius = 0.2f;
-    float lift = 0.01f;
-
-    float minH = get_terrain_height_at(plantX, plantZ, vertices, chunkWidth_, chunkHeight_);
-
-    minH = std::min(minH, get_terrain_height_at(plantX + sampleRadius, plantZ, vertices, chunkWidth_, chunkHeight_));
-    minH = std::min(minH, get_terrain_height_at(plantX - sampleRadius, plantZ, vertices, chunkWidth_, chunkHeight_));
-    minH = std::min(minH, get_terrain_height_at(plantX, plantZ + sampleRadius, vertices, chunkWidth_, chunkHeight_));
-    minH = std::min(minH, get_terrain_height_at(plantX, plantZ - sampleRadius, vertices, chunkWidth_, chunkHeight_));
-
-    return minH + lift;
-}
-
-std::vector<float> generate_biome(const std::vector<float> &vertices,
-                                  std::vector<plant> &plants,
-                                  int xOffset, int yOffset,
-                                  Season season,
-                                  Weather weather,
-                                  float humidity) {
-    std::vector<float> colors;
-    std::vector<terrainColor> biomeColors;
-    glm::vec3 color;
-
-    biomeColors.push_back(terrainColor(WATER_HEIGHT * 0.5f, get_color(60, 95, 190)));
-    biomeColors.push_back(terrainColor(WATER_HEIGHT, get_color(60, 100, 190)));
-    biomeColors.push_back(terrainColor(0.15f, get_color(210, 215, 130)));
-    biomeColors.push_back(terrainColor(0.30f, get_color(95, 165, 30)));
-    biomeColors.push_back(terrainColor(0.40f, get_color(65, 115, 20)));
-    biomeColors.push_back(terrainColor(0.55f, get_color(90, 65, 60)));
-    biomeColors.push_back(terrainColor(0.75f, get_color(75, 60, 55)));
-    biomeColors.push_back(terrainColor(2.00f, get_color(70, 55, 50)));
-
-    float snowLineHeight = 0.0f;
-
-    switch (season) {
-    case Season::SPRING:
-        biomeColors[3].color *= 1.2f;
-        biomeColors[4].color *= 1.1f;
-        snowLineHeight = 0.0f;
-        break;
-
-    case Season::SUMMER:
-        biomeColors[3].color *= 1.1f;
-        snowLineHeight = 0.0f;
-        break;
-
-    case Season::AUTUMN:
-        biomeColors[3].color = get_color(190, 150, 60);
-        biomeColors[4].color = get_color(160, 110, 50);
-        snowLineHeight = 0.70f;
-        biomeColors[6].height = 0.70f;
-        biomeColors[7].height = 0.75f;
-        biomeColors[7].color = get_color(95, 80, 75);
-        biomeColors.push_back(terrainColor(0.80f, get_color(160, 170, 180)));
-        biomeColors.push_back(terrainColor(0.90f, get_color(210, 220, 230)));
-        biomeColors.push_back(terrainColor(2.00f, get_color(240, 245, 250)));
-        break;
-
-    case Season::WINTER:
-        snowLineHeight = 0.45f;
-        biomeColors[5].height = 0.45f;
-        biomeColors[6].height = 0.50f;
-        biomeColors[7].height = 0.55f;
-        biomeColors[6].color = get_color(120, 125, 135);
-        biomeColors[7].color = get_color(180, 190, 200);
-        biomeColors.push_back(terrainColor(0.60f, get_color(210, 220, 230)));
-        biomeColors.push_back(terrainColor(0.70f, get_color(230, 235, 242)));
-        biomeColors.push_back(terrainColor(0.85f, get_color(245, 248, 252)));
-        biomeColors.push_back(terrainColor(2.00f, get_color(252, 254, 255)));
-        break;
-    }
-
-    float plantSpawnBase = 5.0f;
-    float plantSpawnScale = 1.0f + (humidity - 0.5f) * 2.0f;
-
-    glm::vec3 grassDry = get_color(180, 180, 100);
-    glm::vec3 grassNormal = get_color(95, 165, 30);
-    glm::vec3 grassWet = get_color(50, 140, 40);
-
-    glm::vec3 grass2Dry = get_color(150, 140, 90);
-    glm::vec3 grass2Normal = get_color(65, 115, 20);
-    glm::vec3 grass2Wet = get_color(40, 100, 30);
-
-    if (season != Season::WINTER) {
-        if (humidity < 0.5f) {
-            float t = humidity * 2.0f;
-            biomeColors[3].color = lerp3(grassDry, grassNormal, t);
-            biomeColors[4].color = lerp3(grass2Dry, grass2Normal, t);
-        } else {
-            float t = (humidity - 0.5f) * 2.0f;
-            biomeColors[3].color = lerp3(grassNormal, grassWet, t);
-            biomeColors[4].color = lerp3(grass2Normal, grass2Wet, t);
-        }
-    }
-
-    glm::vec3 sandDry = get_color(230, 225, 140);
-    glm::vec3 sandWet = get_color(190, 195, 110);
-    biomeColors[2].color = lerp3(sandDry, sandWet, humidity);
-
-    if (humidity > 0.6f && season != Season::WINTER) {
-        float wetness = (humidity - 0.6f) * 2.5f;
-        biomeColors[5].color = lerp3(biomeColors[5].color, biomeColors[5].color * 0.85f, wetness);
-        if (biomeColors.size() > 6) {
-            biomeColors[6].color = lerp3(biomeColors[6].color, biomeColors[6].color * 0.85f, wetness);
-        }
-    }
-
-    std::string plantType;
-
-    for (int i = 1; i < (int)vertices.size(); i += 3) {
-        float worldHeight = vertices[i];
-        float normalizedHeight = worldHeight / meshHeight;
-
-        normalizedHeight = std::fmax(0.0f, std::fmin(normalizedHeight, 1.5f));
-
-        int nBands = (int)biomeColors.size();
-
-        int k1 = nBands - 1;
-        for (int k = 0; k < nBands - 1; k++) {
-            if (normalizedHeight < biomeColors[k + 1].height) {
-                k1 = k + 1;
-                break;
-            }
-        }
-        int k0 = std::max(0, k1 - 1);
-
-        float h0 = biomeColors[k0].height;
-        float h1 = biomeColors[k1].height;
-
-        if (h1 - h0 < 0.001f) {
-            color = biomeColors[k1].color;
-        } else {
-            float t = (normalizedHeight - h0) / (h1 - h0);
-            t = std::fmax(0.0f, std::fmin(1.0f, t));
-            t = t * t * (3.0f - 2.0f * t);
-            color = lerp3(biomeColors[k0].color, biomeColors[k1].color, t);
-        }
-
-        bool isSnowRegion = (snowLineHeight > 0.0f && normalizedHeight >= snowLineHeight);
-
-        if (normalizedHeight >= 0.25f && normalizedHeight <= 0.45f && !isSnowRegion) {
-            float spawnThreshold = plantSpawnBase * plantSpawnScale;
-
-            if (season == Season::WINTER) {
-                spawnThreshold *= 0.3f;
-            }
-
-            if (rand() % 1000 < spawnThreshold) {
-                if (rand() % 100 < 70) plantType = "flower";
-                else plantType = "tree";
-
-                float plantX = vertices[i - 1];
-                float plantZ = vertices[i + 1];
-
-                float offsetX_ = (rand() % 100 - 50) / 100.0f * 0.8f;
-                float offsetZ_ = (rand() % 100 - 50) / 100.0f * 0.8f;
-                plantX += offsetX_;
-                plantZ += offsetZ_;
-
-                float finalHeight = compute_plant_ground_height(plantX, plantZ, vertices,
-                                                               chunkWidth, chunkHeight);
-                float normalizedFinal = finalHeight / meshHeight;
-
-                float waterLevel = WATER_HEIGHT * meshHeight;
-                float footprintRadius = (plantType == "tree") ? 0.8f : 0.35f;
-
-                if (is_underwater_footprint(plantX, plantZ, vertices, chunkWidth, chunkHeight,
-                                           waterLevel, footprintRadius)) {
-                    colors.push_back(color.r);
-                    colors.push_back(color.g);
-                    colors.push_back(color.b);
-                    continue;
-                }
-
-                if (finalHeight <= waterLevel + 1.0f) { colors.push_back(color.r); colors.push_back(color.g); colors.push_back(color.b); continue; }
-                if (normalizedFinal < WATER_HEIGHT + 0.08f) { colors.push_back(color.r); colors.push_back(color.g); colors.push_back(color.b); continue; }
-                if (snowLineHeight > 0.0f && normalizedFinal >= snowLineHeight) { colors.push_back(color.r); colors.push_back(color.g); colors.push_back(color.b); continue; }
-
-                plants.push_back(plant{
-                    plantType,
-                    plantX,
-                    finalHeight,
-                    plantZ,
-                    xOffset, yOffset
-                });
-            }
-        }
-
-        colors.push_back(color.r);
-        colors.push_back(color.g);
-        colors.push_back(color.b);
-    }
-
-    return colors;
-}
-
-std::vector<float> generate_normals(const std::vector<int> &indices, const std::vector<float> &vertices) {
-    int nVerts = (int)vertices.size() / 3;
-    std::vector<glm::vec3> acc(nVerts, glm::vec3(0.0f));
-    std::vector<float> normals(vertices.size(), 0.0f);
-
-    for (int i = 0; i < (int)indices.size(); i += 3) {
-        int i0 = indices[i], i1 = indices[i+1], i2 = indices[i+2];
-
-        glm::vec3 v0(vertices[i0*3+0], vertices[i0*3+1], vertices[i0*3+2]);
-        glm::vec3 v1(vertices[i1*3+0], vertices[i1*3+1], vertices[i1*3+2]);
-        glm::vec3 v2(vertices[i2*3+0], vertices[i2*3+1], vertices[i2*3+2]);
-
-        glm::vec3 n = glm::normalize(glm::cross(v1 - v0, v2 - v0));
-        acc[i0] += n; acc[i1] += n; acc[i2] += n;
-    }
-
-    for (int v = 0; v < nVerts; v++) {
-        glm::vec3 n = glm::normalize(acc[v]);
-        normals[v*3+0] = n.x;
-        normals[v*3+1] = n.y;
-        normals[v*3+2] = n.z;
-    }
-    return normals;
-}
-
-std::vector<float> generate_vertices(const std::vector<float> &noise_map) {
-    std::vector<float> v;
-
-    for (int y = 0; y < chunkHeight; y++) {
-        for (int x = 0; x < chunkWidth; x++) {
-            v.push_back((float)x);
-            float easedNoise = std::pow(noise_map[x + y * chunkWidth] * 1.1f, 3.0f);
-            v.push_back(std::fmax(easedNoise * meshHeight, WATER_HEIGHT * 0.5f * meshHeight));
-            v.push_back((float)y);
-        }
-    }
-    return v;
-}
-
-std::vector<int> generate_indices() {
-    std::vector<int> indices;
-
-    for (int y = 0; y < chunkHeight; y++) {
-        for (int x = 0; x < chunkWidth; x++) {
-            int pos = x + y * chunkWidth;
-
-            if (x == chunkWidth - 1 || y == chunkHeight - 1) {
-                continue;
-            } else {
-                indices.push_back(pos + chunkWidth);
-                indices.push_back(pos);
-                indices.push_back(pos + chunkWidth + 1);
-
-                indices.push_back(pos + 1);
-                indices.push_back(pos + 1 + chunkWidth);
-                indices.push_back(pos);
-            }
-        }
-    }
-    return indices;
-}
-
-// ----------------- GLFW / input -----------------
-int init() {
-    glfwInit();
-
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-
-    window = glfwCreateWindow(WIDTH, HEIGHT, "Terrain Generator", nullptr, nullptr);
-    if (window == NULL) {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-
-    glfwMakeContextCurrent(window);
-
-    int screenWidth, screenHeight;
-    glfwGetFramebufferSize(window, &screenWidth, &screenHeight);
-
-    glfwSetScrollCallback(window, scroll_callback);
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetMouseButtonCallback(window, mouse_button_callback);
-
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cout << "Failed to initialize GLAD" << std::endl;
-        return -1;
-    }
-
-    glViewport(0, 0, screenWidth, screenHeight);
-
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_FRAMEBUFFER_SRGB);
-
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-
-    init_ui_geometry();
-    init_ui_buttons();
-    init_text_renderer();
-
-    g_fontTex = load_texture_2d("assets/font.png");
-    g_textShader = new Shader("shaders/text.vert", "shaders/text.frag");
-    g_textShader->use();
-    g_textShader->setInt("uFont", 0);
-
-    return 0;
-}
-
-void processInput(GLFWwindow *window_, Shader &shader) {
-    if (glfwGetKey(window_, GLFW_KEY_Q) == GLFW_PRESS)
-        glfwSetWindowShouldClose(window_, true);
-
-    if (glfwGetKey(window_, GLFW_KEY_F) == GLFW_PRESS)
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-
-    if (glfwGetKey(window_, GLFW_KEY_G) == GLFW_PRESS) {
-        shader.use();
-        shader.setBool("isFlat", false);
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    }
-    if (glfwGetKey(window_, GLFW_KEY_H) == GLFW_PRESS) {
-        shader.use();
-        shader.setBool("isFlat", true);
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    }
-
-    if (glfwGetKey(window_, GLFW_KEY_W) == GLFW_PRESS)
-        camera.ProcessKeyboard(FORWARD, deltaTime);
-    if (glfwGetKey(window_, GLFW_KEY_S) == GLFW_PRESS)
-        camera.ProcessKeyboard(BACKWARD, deltaTime);
-    if (glfwGetKey(window_, GLFW_KEY_A) == GLFW_PRESS)
-        camera.ProcessKeyboard(LEFT, deltaTime);
-    if (glfwGetKey(window_, GLFW_KEY_D) == GLFW_PRESS)
-        camera.ProcessKeyboard(RIGHT, deltaTime);
-
-    static bool bWasPressed = false;
-    int bState = glfwGetKey(window_, GLFW_KEY_B);
-
-    if (bState == GLFW_PRESS && !bWasPressed) {
-        g_uiMode = !g_uiMode;
-        if (g_uiMode) {
-            glfwSetInputMode(window_, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
-        } else {
-            glfwSetInputMode(window_, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-            firstMouse = true;
-        }
-    }
-    bWasPressed = (bState == GLFW_PRESS);
-}
-
-void mouse_callback(GLFWwindow *window_, double xpos, double ypos) {
-    if (g_uiMode) {
-        lastX = (float)xpos;
-        lastY = (float)ypos;
-        return;
-    }
-
-    if (firstMouse) {
-        lastX = (float)xpos;
-        lastY = (float)ypos;
-        firstMouse = false;
-    }
-
-    float xoffset = (float)xpos - lastX;
-    float yoffset = lastY - (float)ypos;
-
-    lastX = (float)xpos;
-    lastY = (float)ypos;
-
-    camera.ProcessMouseMovement(xoffset, yoffset);
-}
-
-void scroll_callback(GLFWwindow* window_, double xoffset, double yoffset) {
-    (void)window_; (void)xoffset;
-    camera.ProcessMouseScroll((float)yoffset);
-}
\ No newline at end of file
+#include <cmath>
+#include <string>
+#include <random>
+#include <iostream>
+#include <math.h>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstddef>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <new>
+#include <array>
+#include <climits>
+#include <mutex>
+#include <condition_variable>
+
+#include "include/glad/glad.h"
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "lib/tiny_obj_loader.h"
+#include "shader.h"
+#include "camera.h"
+#include "perlin.h"
+#include "noise_simd.h"
+#include "surface_nets.h"
+#include "rtin.h"
+#include "work_queue.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+const GLint WIDTH = 1920, HEIGHT = 1080;
+
+// ---- Text renderer globals ----
+GLuint g_textVAO = 0, g_textVBO = 0;
+GLuint g_fontTex = 0;
+Shader* g_textShader = nullptr;
+
+static const int FONT_ATLAS_W = 1024;
+static const int FONT_ATLAS_H = 1024;
+int g_fontW = 0;
+int g_fontH = 0;
+static const int FONT_GRID = 16;
+
+// ---- Environment params ----
+enum class Season { SPRING = 0, SUMMER = 1, AUTUMN = 2, WINTER = 3 };
+enum class Weather { CLEAR = 0, RAINY = 1, SNOWY = 2 };
+enum class TimeOfDay { DAY = 0, DUSK = 1, NIGHT = 2, DAWN = 3 };
+TimeOfDay gTimeOfDay = TimeOfDay::DAY;
+
+Season gSeason = Season::SUMMER;
+Weather gWeather = Weather::CLEAR;
+float gHumidity = 0.3f;
+
+std::vector<std::vector<float>> g_chunkVertices;
+
+// ----------------- Structs -----------------
+struct plant {
+    std::string type;
+    float xpos;
+    float ypos;
+    float zpos;
+    int xOffset;
+    int yOffset;
+
+    plant(std::string _type, float _xpos, float _ypos, float _zpos, int _xOffset, int _yOffset) {
+        type = _type;
+        xpos = _xpos;
+        ypos = _ypos;
+        zpos = _zpos;
+        xOffset = _xOffset;
+        yOffset = _yOffset;
+    }
+};
+
+struct terrainColor {
+    terrainColor(float _height, glm::vec3 _color) {
+        height = _height;
+        color = _color;
+    }
+    float height;
+    glm::vec3 color;
+};
+
+// generate_biome's colour bands for one season and humidity, and what its plant pass needs.
+struct BiomePalette {
+    std::vector<terrainColor> bands;
+    float snowLine = 0.0f;          // normalized; 0 = no snow
+    float spawnThreshold = 0.0f;    // per mille chance of a plant on a vertex in the plant band
+};
+
+// A plant that passed its dice rolls and still has to be settled on the ground.
+struct PlantCandidate {
+    const char *type;
+    float x, z;
+};
+
+// A volume chunk's mesh, built on a worker thread and waiting for its GL upload.
+struct VolumeChunk {
+    SurfaceMesh mesh;
+    double densityMs = 0.0;
+    double meshMs = 0.0;
+};
+
+// ---- UI stuff ----
+enum class UIButtonType {
+    SEASON_SPRING,
+    SEASON_SUMMER,
+    SEASON_AUTUMN,
+    SEASON_WINTER,
+    TIME_DAY,
+    TIME_DUSK,
+    TIME_NIGHT,
+    TIME_DAWN,
+    HUMIDITY_UP,
+    HUMIDITY_DOWN
+};
+
+struct UIButton {
+    UIButtonType type;
+    glm::vec2 center;
+    glm::vec2 halfSize;
+    glm::vec4 color;
+};
+
+GLuint g_uiVAO = 0, g_uiVBO = 0;
+std::vector<UIButton> g_buttons;
+bool g_uiMode = false;
+
+// ----------------- Global state -----------------
+GLFWwindow *window = nullptr;
+
+// Map params
+float WATER_HEIGHT = 0.1f;
+int chunk_render_distance = 3;
+int xMapChunks = 21;                        // chunk slots a side, see stream_chunks
+int yMapChunks = 21;
+int chunkWidth = 129;                       // 2^k + 1, which the RTIN mesher needs
+int chunkHeight = 129;
+int gridPosX = 0;
+int gridPosY = 0;
+float originX = (chunkWidth * xMapChunks) / 2 - chunkWidth / 2;
+float originY = (chunkHeight * yMapChunks) / 2 - chunkHeight / 2;
+
+// Chunk size (--chunk-size <size>|auto). The render distances keep their
+// reach in world units as nearly as whole chunks allow (at 257 they overshoot
+// by half a chunk); set_chunk_size derives the distances, slot counts and
+// origin from it. "auto" runs tune_chunk_size, which times chunk generation
+// and draw calls on this machine for the sizes that keep the reach exactly
+// (chunk_size_keeps_reach) and picks the one with the least cost.
+// Generation is paid once at startup and draw call overhead every frame, so
+// the cost weighs one startup against chunkTuneFrames frames of draws
+// (--tune-frames <n>, default a minute at 60 fps): a short session favours
+// cheap generation, a long one few draw calls.
+const int CHUNK_SIZES[] = { 33, 65, 129, 257 };
+const int CHUNK_SIZE_COUNT = 4;
+const int RENDER_QUADS = 3 * 128;           // chunk_render_distance at 129
+const int LOD_RENDER_QUADS = 9 * 128;       // lod_render_distance at 129
+int chunkTuneFrames = 3600;
+const double DEFAULT_DRAW_CALL_US = 5.0;    // tuning without a GL context (--bench)
+
+// Streaming (stream_chunks): the world is unbounded and the xMapChunks x
+// yMapChunks chunk slots form a toroidal window over it, chunk (x, y) living
+// in slot (x mod xMapChunks, y mod yMapChunks). The window is the render
+// distance both ways plus STREAM_HYSTERESIS chunks, so a chunk is only evicted
+// once the camera is that many chunks past the point where it left the render
+// distance, and turning back does not regenerate it.
+//
+// Chunks are generated on a pool of worker threads (g_chunkWorkers): the GL
+// thread queues ChunkJobs, the workers build everything short of the GL calls
+// (noise, vertices, colours, plants, packing, RTIN or Surface Nets meshing)
+// into ChunkPayloads, and the GL thread uploads at most
+// STREAM_UPLOADS_PER_FRAME of them a frame, so neither startup nor a season
+// change stalls the window. Both directions are lock-free BoundedQueues; idle
+// workers sleep on a condition variable. The settings the workers read are
+// only changed after cancel_chunk_jobs has let them go idle.
+const int STREAM_HYSTERESIS = 2;
+const int STREAM_UPLOADS_PER_FRAME = 4;
+const int STREAM_JOBS_IN_FLIGHT = 64;       // queued, being built or waiting for upload
+const glm::ivec2 NO_CHUNK(INT_MIN, INT_MIN);
+std::vector<glm::ivec2> g_slotChunk;        // chunk each slot holds, NO_CHUNK if none
+std::vector<int> g_slotGeneration;          // g_worldGeneration it was built in
+std::vector<glm::ivec2> g_slotPending;      // chunk a job is building for the slot, NO_CHUNK if none
+int g_worldGeneration = 0;                  // bumped by rebuild_world: every chunk is out of date
+int g_jobEpoch = 0;                         // bumped by cancel_chunk_jobs: payloads in flight are void
+double g_rebuildStart = -1.0;               // glfwGetTime() of the last rebuild_world, until it completes
+
+// Noise params
+int octaves = 5;
+float meshHeight = 32.0f;
+float noiseScale = 64.0f;
+float persistence = 0.5f;
+float lacunarity = 2.0f;
+SimdLevel noiseSimdLevel = SimdLevel::AVX2; // clamped to what the CPU supports
+uint32_t worldSeed = 0;                     // 0 = Ken Perlin's reference permutation
+NoiseBackend noiseBackend = NoiseBackend::PERLIN3D;
+std::shared_ptr<const NoiseContext> g_noiseContext;
+
+// Domain warp: a low-octave fBm offsets the terrain's sample coordinates.
+// warpStrength is in noise units (1 = noiseScale vertices), 0 turns it off.
+// warpGridStep is the quality / speed knob: the warp is evaluated every
+// warpGridStep vertices and upsampled bilinearly (1 = exact, per vertex).
+// The warp field runs at warpFrequency times the terrain's base frequency
+// so it stays smooth enough for the coarse grid.
+float warpStrength = 0.0f;
+int warpGridStep = 8;
+int warpOctaves = 2;
+float warpFrequency = 0.5f;
+
+// Ridged / hybrid multifractal terrain. In those modes a vertex stops adding
+// octaves once the rest cannot move it into another generate_biome band or
+// change its height by more than octaveHeightError (normalized height,
+// 1 = meshHeight).
+FractalMode fractalMode = FractalMode::FBM;
+float octaveHeightError = 0.005f;
+thread_local long g_lastOctavesSkipped = 0; // sample-octaves skipped by the last generate_noise_map
+
+// Octave LOD: chunks more than octaveLodRadius rings from the camera's chunk
+// drop one octave per extra ring (never below octaveLodMinOctaves). Their
+// border vertices keep every octave so neighbours still meet exactly, and
+// coarse chunks are regenerated at full detail, octaveRefinePerFrame at a
+// time, as the camera approaches.
+int octaveLodRadius = 1;
+int octaveLodMinOctaves = 3;
+int octaveRefinePerFrame = 1;
+std::vector<int> g_chunkOctaves;            // octaves each chunk was generated with
+
+// Fixed-point terrain: integer Perlin fBm whose heights are bit-identical on
+// every build, so chunks can be cached and shared by content hash.
+bool fixedPointNoise = false;
+thread_local uint64_t g_lastContentHash = 0; // hash of the last fixed-point height map
+
+// Terrain shaping preset (noise_graph.inl). Presets shape plain fBm; with
+// --warp, --fractal or --fixed-noise the classic shaping is used.
+TerrainPreset terrainPreset = TerrainPreset::CLASSIC;
+
+// Volume terrain: chunks are meshed from a 3D density (classic fBm height
+// minus altitude, plus a 3D fBm term) with Surface Nets, so the ground can
+// overhang and open into caves. Samples are volumeStep units apart;
+// caveStrength is the 3D term's amplitude in normalized height and
+// caveFrequency its frequency relative to the terrain's. Chunks are meshed
+// on worker threads and have no plants.
+bool volumeTerrain = false;
+int volumeStep = 2;
+int caveOctaves = 3;
+float caveStrength = 0.25f;
+float caveFrequency = 1.5f;
+
+// Model params
+float MODEL_SCALE = 3.0f;
+float MODEL_BRIGHTNESS = 6.0f;
+
+// FPS
+double lastTime = 0.0;
+int nbFrames = 0;
+
+// ---- Model minY tracking ----
+float g_treeMinY = 0.0f;
+float g_flowerMinY = 0.0f;
+bool g_modelMinYInitialized = false; // kept for compatibility (no longer required)
+
+// ---- FIX: Per-chunk terrain GL buffers (for updating colors) ----
+std::vector<GLuint> g_mapVertexVBO;         // packed position + normal
+std::vector<GLuint> g_mapColorVBO;
+std::vector<GLuint> g_mapEBO;
+std::vector<GLsizei> g_mapIndexCount;       // indices drawn for each chunk
+std::vector<GLenum> g_mapIndexType;         // and their type
+
+// Terrain vertices are packed (objectShader.vert decodes them according to
+// u_terrainFormat): grid chunks store a unorm16 height and take x / z from
+// gl_VertexID, volume chunks a unorm16 position; both add an octahedral
+// normal in two bytes and an RGBA8 color. 8 / 12 bytes instead of 36.
+enum TerrainVertexFormat { FLOAT_VERTICES = 0, PACKED_GRID = 1, PACKED_VOLUME = 2 };
+struct PackedGridVertex { uint16_t height; int8_t normal[2]; };
+struct PackedVolumeVertex { uint16_t pos[3]; int8_t normal[2]; };
+std::vector<int> g_mapVertexFormat;         // TerrainVertexFormat of each chunk
+
+// What build_grid_chunk writes for one height-map chunk. Every array keeps its
+// capacity from chunk to chunk, so generating chunks of one size allocates nothing.
+struct GridChunkBuffers {
+    std::vector<PackedGridVertex> vertices;
+    std::vector<uint8_t> colors;                // RGBA8
+    std::vector<PlantCandidate> candidates;
+    std::vector<float> xSamples, rowHeight, rowDx, rowDz;  // one row of noise
+    std::vector<float> heights, gradients;      // whole chunk, for the modes without a fused noise pass
+    BiomePalette palette;
+    Season paletteSeason = Season::SPRING;
+    float paletteHumidity = -1.0f;
+};
+
+// One chunk for the workers to build, with the settings the GL thread may
+// change while it waits (the others only change once they are idle).
+struct ChunkJob {
+    glm::ivec2 chunk;
+    int lodOctaves, epoch;
+    bool volume;
+    float rtinError;                            // 0 = shared grid index buffer
+};
+
+// A built chunk waiting for upload_chunk_payload. Payloads are recycled, so
+// their arrays keep their capacity like GridChunkBuffers'.
+struct ChunkPayload {
+    ChunkJob job;
+    GridChunkBuffers grid;
+    std::vector<PackedVolumeVertex> volumeVertices;
+    std::vector<uint8_t> volumeColors;
+    std::vector<float> verts;                   // world space, for g_chunkVertices
+    std::vector<float> nodeBounds, rtinErrors;
+    std::vector<int> indices;                   // RTIN or volume triangles; empty = shared grid buffer
+    std::vector<plant> plants;
+    uint64_t contentHash = 0;
+    long octavesSkipped = 0;
+};
+
+struct ChunkWorkers {
+    BoundedQueue<ChunkJob> jobs{ STREAM_JOBS_IN_FLIGHT };
+    BoundedQueue<ChunkPayload *> ready{ STREAM_JOBS_IN_FLIGHT };
+    BoundedQueue<ChunkPayload *> spare{ STREAM_JOBS_IN_FLIGHT };
+    std::vector<std::thread> threads;
+    std::mutex mutex;                           // only for sleeping on wake
+    std::condition_variable wake;
+    std::atomic<int> queued{ 0 };               // jobs in the queue
+    std::atomic<int> busy{ 0 };                 // workers that may hold a job
+    std::atomic<bool> quit{ false };
+    int inFlight = 0;                           // GL thread: queued and not yet taken from ready
+};
+ChunkWorkers g_chunkWorkers;
+
+// Every height-map chunk has the same triangle list, so one index buffer is
+// built on first use and bound to all their VAOs (16-bit while a chunk has at
+// most 65536 vertices). Volume chunks keep their own.
+GLuint g_gridEBO = 0;
+GLsizei g_gridIndexCount = 0;
+GLenum g_gridIndexType = GL_UNSIGNED_SHORT;
+GLenum g_gridPrimitive = GL_TRIANGLES;
+
+// Order of the grid index buffer (--index-order, I key). ROW_MAJOR is the
+// plain scan, which has moved a whole row on by the time the row below reuses
+// its vertices, so nearly every vertex is shaded twice. BLOCKED walks stripes
+// INDEX_BLOCK_WIDTH quads wide down the chunk, zigzagging from row to row, so
+// both vertex rows of a stripe (30 vertices) stay in a 32-entry post-transform
+// cache. STRIPS draws the same stripes as triangle strips, one per stripe row,
+// joined by primitive restart.
+enum class IndexOrder { ROW_MAJOR = 0, BLOCKED = 1, STRIPS = 2 };
+const int INDEX_ORDER_COUNT = 3;
+const int INDEX_BLOCK_WIDTH = 14;
+const int PRIMITIVE_RESTART = -1;           // in generate_indices' output; all ones once narrowed
+IndexOrder indexOrder = IndexOrder::BLOCKED;
+
+// Flat shading (H key; G goes back to smooth) takes each triangle's color and
+// face normal from its provoking vertex, the last one. Every order above
+// makes each grid vertex provoke one triangle on either side of it, so the
+// vertex shader computes both faces from its neighbours and the fragment
+// shader picks one (u_flatPattern): by the anti-diagonal through the vertex
+// for the triangle lists (and CDLOD nodes), by its row for the strips.
+// Meshes with their own index lists fall back to position derivatives.
+enum FlatPattern { FLAT_DERIVATIVES = 0, FLAT_LISTS = 1, FLAT_STRIPS = 2 };
+
+// CDLOD (--no-cdlod, L key). Each grid chunk is a quadtree over a virtual
+// square of CDLOD_NODE_QUADS << (levels - 1) quads, clamped to the chunk: a
+// node of level k covers CDLOD_NODE_QUADS << k quads and is drawn as a
+// CDLOD_NODE_QUADS^2 grid at step 2^k. cdlod_select picks levels by distance
+// to the camera, and objectShader.vert slides each node's odd vertices onto
+// the next level's grid as they near the end of its range, so switching
+// levels does not pop. Border vertices lie on every level's grid and never
+// move, which keeps chunk seams closed. The node lists live in the grid index
+// buffer after the full-detail list, from g_cdlodIndexBase on.
+const int CDLOD_NODE_QUADS = 16;
+const float CDLOD_MORPH_START = 0.75f;      // fraction of a level's range where its morph begins
+bool cdlodTerrain = true;
+int lod_render_distance = 9;                // chunks drawn with CDLOD on: 3x chunk_render_distance
+GLsizei g_cdlodIndexBase = 0;
+std::vector<GLuint> g_mapHeightTex;         // each grid chunk's vertex / color VBO as a texture buffer,
+std::vector<GLuint> g_mapColorTex;          // where the morph fetches its target vertex
+std::vector<std::vector<float>> g_chunkNodeBounds;  // min / max height of each CDLOD node
+
+// RTIN meshing (--rtin <error>, K key): each grid chunk gets its own index list
+// with only the triangles needed to stay within rtinMaxError of the full grid,
+// in place of the shared buffer (and of CDLOD). 0 = off. Border edges are kept
+// at full resolution so neighbouring chunks meet without cracks.
+float rtinMaxError = 0.0f;
+const float RTIN_ERROR_STEPS[] = { 0.0f, 0.1f, 0.5f, 2.0f };
+RtinTile g_rtinTile;
+
+// What tune_chunk_size weighs for one chunk size.
+struct ChunkSizeCost {
+    int size, chunks, draws;
+    double generateMs, drawMs;      // startup generation; draw call overhead of one frame
+    double total() const { return generateMs + chunkTuneFrames * drawMs; }
+};
+
+struct CdlodDraw {
+    int level;
+    GLsizei first, count;                   // in the node lists
+};
+
+// GL_TIME_ELAPSED around the terrain pass, from a ring of queries: the one a
+// frame reuses was issued TERRAIN_TIMER_QUERIES frames earlier. Its result is
+// only read once GL_QUERY_RESULT_AVAILABLE says so; if the GPU is further
+// behind than that, the frame goes untimed instead of waiting.
+const int TERRAIN_TIMER_QUERIES = 4;
+GLuint g_terrainTimer[TERRAIN_TIMER_QUERIES] = {};
+bool g_terrainTimerPending[TERRAIN_TIMER_QUERIES] = {};
+double g_terrainGpuMs = 0.0;
+int g_terrainGpuFrames = 0;
+
+// ---- FIX: Per-chunk instancing buffers & counts ----
+std::vector<GLuint> g_treeInstanceVBO;
+std::vector<GLuint> g_flowerInstanceVBO;
+std::vector<GLsizei> g_treeInstanceCount;
+std::vector<GLsizei> g_flowerInstanceCount;
+
+// ---- FIX: Model vertex counts (avoid hard-coded 10192/1300) ----
+int g_treeVertexCount   = 0;
+int g_flowerVertexCount = 0;
+
+// ---- FIX: Model minY loaded flags ----
+bool g_treeMinYSet   = false;
+bool g_flowerMinYSet = false;
+
+// Camera
+Camera camera(glm::vec3(originX, 20.0f, originY));
+bool firstMouse = true;
+float lastX = WIDTH / 2;
+float lastY = HEIGHT / 2;
+
+// Timing
+float deltaTime = 0.0f;
+float lastFrame = 0.0f;
+float currentFrame = 0.0f;
+
+// Chunk & plant globals
+std::vector<GLuint> g_map_chunks;
+std::vector<GLuint> g_tree_chunks;
+std::vector<GLuint> g_flower_chunks;
+GLuint g_treeVAO = 0, g_flowerVAO = 0;
+std::vector<plant> g_plants;
+
+// ----------------- Forward declarations -----------------
+int init();
+void processInput(GLFWwindow *window, Shader &shader);
+void mouse_callback(GLFWwindow *window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+
+void render(std::vector<GLuint> &map_chunks, Shader &shader,
+            glm::mat4 &view, glm::mat4 &model, glm::mat4 &projection,
+            std::vector<GLuint> &tree_chunks,
+            std::vector<GLuint> &flower_chunks, Shader &uiShader);
+
+const char *index_order_name(IndexOrder order);
+static bool parse_index_order(const std::string &name, IndexOrder &order);
+static int cdlod_levels();
+static std::vector<int> cdlod_indices();
+static void cdlod_node_bounds(const std::vector<float> &verts, std::vector<float> &bounds);
+static void cdlod_select(const std::vector<float> &bounds, const glm::vec3 &camLocal, std::vector<CdlodDraw> &out);
+static glm::vec2 cdlod_morph_range(int level);
+int terrain_render_distance();
+std::vector<int> generate_indices(IndexOrder order);
+std::vector<float> generate_noise_map(int xOffset, int yOffset, std::vector<float> *gradients = nullptr,
+                                      int chunkOctaves = 0);
+std::vector<float> generate_height_map(int xOffset, int yOffset, std::vector<float> &gradients, int chunkOctaves = 0);
+std::vector<float> generate_vertices(const std::vector<float> &heights, const std::vector<float> &gradients,
+                                     std::vector<float> &normals);
+std::vector<float> biome_thresholds(Season season);
+std::vector<float> generate_biome(
+    const std::vector<float> &vertices,
+    std::vector<plant> &plants,
+    int xOffset, int yOffset,
+    Season season,
+    Weather weather,
+    float humidity,
+    bool spawnPlants = true
+);
+void build_grid_chunk(int xOffset, int yOffset, int lodOctaves, GridChunkBuffers &out,
+                      std::vector<float> &worldVerts, std::vector<plant> &plants);
+static void upload_map_chunk(GLuint &VAO, int pos, TerrainVertexFormat format, const void *vertices,
+                             size_t nVertices, const uint8_t *rgba, const std::vector<int> *indices);
+static std::vector<uint8_t> pack_colors(const std::vector<float> &colors);
+static glm::vec3 terrain_pack_extent();
+static void generate_volume_chunk(int offsetX, int offsetY, VolumeChunk &out, SimdLevel level);
+void start_chunk_workers(unsigned threads);
+void stop_chunk_workers();
+bool queue_chunk_job(const ChunkJob &job);
+bool submit_chunk_job(int x, int y);
+void cancel_chunk_jobs();
+static void build_chunk_payload(ChunkPayload &out);
+void upload_ready_chunks();
+void update_camera_chunk();
+int stream_window(int distance);
+int chunk_slot(int x, int y);
+bool chunk_resident(int x, int y);
+std::vector<glm::ivec2> chunks_around_camera(int distance);
+void stream_chunks();
+bool set_chunk_size(int size);
+int tune_chunk_size(double drawCallUs);
+double measure_draw_call_us();
+int chunk_lod_octaves(int xOffset, int yOffset);
+void refine_chunks();
+
+float get_terrain_height_at(float worldX, float worldZ,
+                            const std::vector<float>& vertices,
+                            int chunkWidth, int chunkHeight);
+
+float load_model(GLuint &VAO, std::string filename, int* outVertexCount);
+void setup_instancing(GLuint &VAO, std::vector<GLuint> &plant_chunk, std::string plant_type,
+                      std::vector<plant> &plants, std::string filename, int onlySlot = -1);
+void update_chunk_instances(int slot);
+
+void rebuild_world();
+void update_terrain_colors_only();
+
+int run_benchmarks();
+
+// UI helpers
+void init_ui_geometry();
+void init_ui_buttons();
+void on_button_clicked(UIButtonType type);
+void handle_ui_click(double mouseX, double mouseY);
+void draw_ui(Shader &uiShader);
+
+// Text rendering helpers
+void init_text_renderer();
+void draw_text(Shader& sh, const std::string& text, float xNDC, float yNDC, float sizeNDC, glm::vec3 color);
+
+glm::vec3 gSky = {0.53f, 0.81f, 0.92f};
+Shader* gObjectShader = nullptr;
+
+// ============ applySeasonParams() ============
+void applySeasonParams(Shader& sh){
+    glm::vec3 sky, amb, dif, spc;
+    float fogStart, fogEnd;
+
+    switch (gSeason){
+    case Season::SPRING:
+        sky = {0.60f, 0.86f, 0.98f};
+        amb = {0.26f, 0.26f, 0.26f};
+        dif = {0.45f, 0.45f, 0.45f};
+        spc = {1.00f, 1.00f, 1.00f};
+        fogStart = 120.f; fogEnd = 260.f;
+        break;
+    case Season::SUMMER:
+        sky = {0.35f, 0.70f, 0.98f};
+        amb = {0.22f, 0.22f, 0.22f};
+        dif = {0.55f, 0.55f, 0.55f};
+        spc = {1.00f, 1.00f, 1.00f};
+        fogStart = 160.f; fogEnd = 340.f;
+        break;
+    case Season::AUTUMN:
+        sky = {0.55f, 0.70f, 0.82f};
+        amb = {0.18f, 0.16f, 0.14f};
+        dif = {0.35f, 0.30f, 0.26f};
+        spc = {0.90f, 0.85f, 0.80f};
+        fogStart = 90.f;  fogEnd = 200.f;
+        break;
+    case Season::WINTER:
+        sky = {0.65f, 0.78f, 0.88f};
+        amb = {0.24f, 0.26f, 0.30f};
+        dif = {0.45f, 0.48f, 0.55f};
+        spc = {1.10f, 1.10f, 1.10f};
+        fogStart = 70.f;  fogEnd = 170.f;
+        break;
+    }
+
+    switch (gTimeOfDay) {
+    case TimeOfDay::DAY:
+        break;
+    case TimeOfDay::DUSK:
+        sky = glm::vec3(0.8f, 0.5f, 0.3f) * 0.7f;
+        amb *= 0.5f;
+        dif *= 0.6f;
+        fogStart *= 0.7f;
+        fogEnd *= 0.7f;
+        break;
+    case TimeOfDay::NIGHT:
+        sky = glm::vec3(0.05f, 0.08f, 0.15f);
+        amb *= 0.15f;
+        dif *= 0.20f;
+        spc *= 0.8f;
+        fogStart *= 0.5f;
+        fogEnd *= 0.5f;
+        break;
+    case TimeOfDay::DAWN:
+        sky = glm::vec3(0.7f, 0.5f, 0.7f) * 0.6f;
+        amb *= 0.6f;
+        dif *= 0.7f;
+        fogStart *= 0.8f;
+        fogEnd *= 0.8f;
+        break;
+    }
+
+    gSky = sky;
+
+    // fog reaches as far as the terrain does
+    float reach = (float)terrain_render_distance() / chunk_render_distance;
+    fogStart *= reach;
+    fogEnd *= reach;
+
+    sh.use();
+    sh.setInt("u_season", (int)gSeason);
+    sh.setInt("u_timeOfDay", (int)gTimeOfDay);
+    sh.setFloat("u_humidity", gHumidity);
+    sh.setVec3("u_skyColor", gSky);
+    sh.setFloat("u_meshHeight", meshHeight);
+    sh.setFloat("u_fogStart", fogStart);
+    sh.setFloat("u_fogEnd", fogEnd);
+
+    sh.setVec3("light.ambient",  amb.x, amb.y, amb.z);
+    sh.setVec3("light.diffuse",  dif.x, dif.y, dif.z);
+    sh.setVec3("light.specular", spc.x, spc.y, spc.z);
+}
+
+// ----------------- Text rendering implementation -----------------
+void init_text_renderer() {
+    if (g_textVAO != 0) return;
+
+    glGenVertexArrays(1, &g_textVAO);
+    glGenBuffers(1, &g_textVBO);
+
+    glBindVertexArray(g_textVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, g_textVBO);
+
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4 * 1024, nullptr, GL_DYNAMIC_DRAW);
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+static inline void push_quad(std::vector<float>& v,
+                             float x0, float y0, float x1, float y1,
+                             float u0, float v0, float u1, float v1)
+{
+    v.insert(v.end(), { x0,y0,u0,v0, x1,y0,u1,v0, x1,y1,u1,v1 });
+    v.insert(v.end(), { x0,y0,u0,v0, x1,y1,u1,v1, x0,y1,u0,v1 });
+}
+
+float measure_text_width_ndc(const std::string& text, float sizeNDC) {
+    int currentWidth, currentHeight;
+    glfwGetFramebufferSize(window, &currentWidth, &currentHeight);
+    float aspectFix = float(currentHeight) / float(currentWidth);
+
+    float glyphW = sizeNDC * aspectFix;
+    float advance = glyphW * 0.70f;
+
+    int n = 0;
+    for (unsigned char c : text) {
+        if (c == '\n') break;
+        n++;
+    }
+    if (n <= 0) return 0.0f;
+    return (n - 1) * advance + glyphW;
+}
+
+void draw_text_centered_in_button(const UIButton& btn,
+                                  const std::string& label,
+                                  float sizeNDC,
+                                  glm::vec3 color)
+{
+    float w = measure_text_width_ndc(label, sizeNDC);
+    float x = btn.center.x - 0.5f * w;
+    float y = btn.center.y - 0.5f * sizeNDC;
+    draw_text(*g_textShader, label, x, y, sizeNDC, color);
+}
+
+void draw_text(Shader& sh, const std::string& text, float xNDC, float yNDC, float sizeNDC, glm::vec3 color)
+{
+    if (g_textVAO == 0 || g_fontTex == 0) return;
+
+    int currentWidth, currentHeight;
+    glfwGetFramebufferSize(window, &currentWidth, &currentHeight);
+    float aspectFix = float(currentHeight) / float(currentWidth);
+
+    float glyphH = sizeNDC;
+    float glyphW = sizeNDC * aspectFix;
+    float advance = glyphW * 0.70f;
+
+    float epsU = 0.5f / float(g_fontW > 0 ? g_fontW : 1024);
+    float epsV = 0.5f / float(g_fontH > 0 ? g_fontH : 1024);
+
+    std::vector<float> verts;
+    verts.reserve(text.size() * 6 * 4);
+
+    float penX = xNDC;
+    float penY = yNDC;
+
+    for (unsigned char c : text) {
+        if (c == '\n') { penX = xNDC; penY -= glyphH * 1.2f; continue; }
+        if (c == ' ') { penX += advance; continue; }
+
+        unsigned char uc = (unsigned char)c;
+        int col = uc & 15;
+        int row = uc >> 4;
+
+        float u0 = (col + 0.0f) / float(FONT_GRID) + epsU;
+        float u1 = (col + 1.0f) / float(FONT_GRID) - epsU;
+
+        float vTop = 1.0f - (row + 0.0f) / float(FONT_GRID);
+        float vBottom = 1.0f - (row + 1.0f) / float(FONT_GRID);
+        float v0 = vBottom + epsV;
+        float v1 = vTop - epsV;
+
+        float x0 = penX;
+        float y0 = penY;
+        float x1 = penX + glyphW;
+        float y1 = penY + glyphH;
+
+        push_quad(verts, x0, y0, x1, y1, u0, v0, u1, v1);
+        penX += advance;
+    }
+
+    sh.use();
+    sh.setVec3("textColor", color);
+    sh.setInt("uFont", 0);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, g_fontTex);
+
+    glBindVertexArray(g_textVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, g_textVBO);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, verts.size() * sizeof(float), verts.data());
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(verts.size() / 4));
+    glBindVertexArray(0);
+}
+
+// load texture 2d
+GLuint load_texture_2d(const char* path) {
+    int w, h, n;
+    stbi_set_flip_vertically_on_load(true);
+    unsigned char* data = stbi_load(path, &w, &h, &n, 4);
+    if (!data) {
+        std::cout << "Failed to load texture: " << path << "\n";
+        return 0;
+    }
+    g_fontW = w;
+    g_fontH = h;
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    stbi_image_free(data);
+    return tex;
+}
+
+// ----------------- UI implementation -----------------
+void init_ui_geometry() {
+    if (g_uiVAO != 0) return;
+
+    float quadVertices[] = {
+        -1.0f, -1.0f,
+         1.0f, -1.0f,
+         1.0f,  1.0f,
+        -1.0f, -1.0f,
+         1.0f,  1.0f,
+        -1.0f,  1.0f
+    };
+
+    glGenVertexArrays(1, &g_uiVAO);
+    glGenBuffers(1, &g_uiVBO);
+
+    glBindVertexArray(g_uiVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, g_uiVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+void init_ui_buttons() {
+    g_buttons.clear();
+
+    float btnHalfH = 0.04f;
+    float btnHalfW = 0.09f;
+    float gap = 0.02f;
+
+    auto addBtn = [&](UIButtonType type, float x, float y, glm::vec4 color) {
+        UIButton b;
+        b.type = type;
+        b.center = glm::vec2(x, y);
+        b.halfSize = glm::vec2(btnHalfW, btnHalfH);
+        b.color = color;
+        g_buttons.push_back(b);
+    };
+
+    float topY = 0.85f;
+    float startX = -0.9f;
+
+    addBtn(UIButtonType::SEASON_SPRING, startX + btnHalfW, topY, glm::vec4(0.7f, 1.0f, 0.7f, 0.6f));
+    startX += btnHalfW * 2.0f + gap;
+    addBtn(UIButtonType::SEASON_SUMMER, startX + btnHalfW, topY, glm::vec4(0.3f, 0.8f, 0.3f, 0.6f));
+    startX += btnHalfW * 2.0f + gap;
+    addBtn(UIButtonType::SEASON_AUTUMN, startX + btnHalfW, topY, glm::vec4(0.9f, 0.6f, 0.2f, 0.6f));
+    startX += btnHalfW * 2.0f + gap;
+    addBtn(UIButtonType::SEASON_WINTER, startX + btnHalfW, topY, glm::vec4(0.7f, 0.8f, 1.0f, 0.6f));
+
+    float timeY = 0.75f;
+    startX = -0.9f;
+
+    addBtn(UIButtonType::TIME_DAY, startX + btnHalfW, timeY, glm::vec4(1.0f, 1.0f, 0.5f, 0.6f));
+    startX += btnHalfW * 2.0f + gap;
+    addBtn(UIButtonType::TIME_DUSK, startX + btnHalfW, timeY, glm::vec4(1.0f, 0.6f, 0.3f, 0.6f));
+    startX += btnHalfW * 2.0f + gap;
+    addBtn(UIButtonType::TIME_NIGHT, startX + btnHalfW, timeY, glm::vec4(0.2f, 0.2f, 0.5f, 0.6f));
+    startX += btnHalfW * 2.0f + gap;
+    addBtn(UIButtonType::TIME_DAWN, startX + btnHalfW, timeY, glm::vec4(0.8f, 0.5f, 0.8f, 0.6f));
+
+    float humidityBtnHalfW = 0.05f;
+    float humidityBtnHalfH = 0.04f;
+    float humidityGap = 0.03f;
+
+    UIButton down, up;
+
+    down.type = UIButtonType::HUMIDITY_DOWN;
+    down.center = glm::vec2(0.72f, 0.85f);
+    down.halfSize = glm::vec2(humidityBtnHalfW, humidityBtnHalfH);
+    down.color = glm::vec4(1.0f, 0.5f, 0.3f, 0.6f);
+    g_buttons.push_back(down);
+
+    up.type = UIButtonType::HUMIDITY_UP;
+    up.center = glm::vec2(0.72f + humidityBtnHalfW * 2.0f + humidityGap, 0.85f);
+    up.halfSize = glm::vec2(humidityBtnHalfW, humidityBtnHalfH);
+    up.color = glm::vec4(0.2f, 0.8f, 1.0f, 0.6f);
+    g_buttons.push_back(up);
+
+    std::cout << "[DEBUG] Button layout:" << std::endl;
+    for (size_t i = 0; i < g_buttons.size(); i++) {
+        std::cout << "  [" << i << "] type=" << (int)g_buttons[i].type
+                  << " center=(" << g_buttons[i].center.x << ", " << g_buttons[i].center.y << ")"
+                  << " bounds=[" << (g_buttons[i].center.x - g_buttons[i].halfSize.x) << " to "
+                  << (g_buttons[i].center.x + g_buttons[i].halfSize.x) << "]" << std::endl;
+    }
+}
+
+// ----------------- FIX: terrain chunk destroy helper -----------------
+static inline void destroy_map_chunk(int pos) {
+    if (pos < 0 || pos >= (int)g_map_chunks.size()) return;
+
+    if (g_map_chunks[pos]) glDeleteVertexArrays(1, &g_map_chunks[pos]);
+    if (!g_mapVertexVBO.empty() && g_mapVertexVBO[pos]) glDeleteBuffers(1, &g_mapVertexVBO[pos]);
+    if (!g_mapColorVBO.empty() && g_mapColorVBO[pos]) glDeleteBuffers(1, &g_mapColorVBO[pos]);
+    if (!g_mapEBO.empty() && g_mapEBO[pos]) glDeleteBuffers(1, &g_mapEBO[pos]);
+    if (!g_mapHeightTex.empty() && g_mapHeightTex[pos]) glDeleteTextures(1, &g_mapHeightTex[pos]);
+    if (!g_mapColorTex.empty() && g_mapColorTex[pos]) glDeleteTextures(1, &g_mapColorTex[pos]);
+
+    g_map_chunks[pos] = 0;
+    if (!g_mapVertexVBO.empty()) g_mapVertexVBO[pos] = 0;
+    if (!g_mapColorVBO.empty()) g_mapColorVBO[pos] = 0;
+    if (!g_mapEBO.empty()) g_mapEBO[pos] = 0;
+    if (!g_mapHeightTex.empty()) g_mapHeightTex[pos] = 0;
+    if (!g_mapColorTex.empty()) g_mapColorTex[pos] = 0;
+}
+
+// ----------------- FIX: only update terrain colors -----------------
+void update_terrain_colors_only() {
+    for (int pos = 0; pos < (int)g_slotChunk.size(); pos++) {
+        const glm::ivec2 chunk = g_slotChunk[pos];
+        if (chunk == NO_CHUNK) continue;
+        if (pos >= (int)g_map_chunks.size() || g_map_chunks[pos] == 0) continue;
+        if (pos >= (int)g_chunkVertices.size()) continue;
+
+        const std::vector<float>& verts = g_chunkVertices[pos];
+        if (verts.empty()) continue;
+
+        std::vector<plant> dummy_plants;
+        std::vector<float> colors = generate_biome(verts, dummy_plants, chunk.x, chunk.y, gSeason, gWeather, gHumidity, false);
+
+        if (pos < (int)g_mapColorVBO.size() && g_mapColorVBO[pos] != 0) {
+            std::vector<uint8_t> rgba = pack_colors(colors);
+            glBindBuffer(GL_ARRAY_BUFFER, g_mapColorVBO[pos]);
+            glBufferData(GL_ARRAY_BUFFER, rgba.size(), rgba.data(), GL_STATIC_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+    }
+}
+
+// ----------------- FIX: on_button_clicked -----------------
+void on_button_clicked(UIButtonType type) {
+    enum class UpdateKind { NONE, COLORS_ONLY, FULL_REBUILD };
+    UpdateKind upd = UpdateKind::NONE;
+
+    std::cout << "[DEBUG] Button clicked, type = " << (int)type << std::endl;
+    cancel_chunk_jobs();    // the workers read the season and humidity
+
+    switch (type) {
+    case UIButtonType::SEASON_SPRING:
+        if (gSeason != Season::SPRING) { gSeason = Season::SPRING; upd = UpdateKind::FULL_REBUILD; }
+        break;
+    case UIButtonType::SEASON_SUMMER:
+        if (gSeason != Season::SUMMER) { gSeason = Season::SUMMER; upd = UpdateKind::FULL_REBUILD; }
+        break;
+    case UIButtonType::SEASON_AUTUMN:
+        if (gSeason != Season::AUTUMN) { gSeason = Season::AUTUMN; upd = UpdateKind::FULL_REBUILD; }
+        break;
+    case UIButtonType::SEASON_WINTER:
+        if (gSeason != Season::WINTER) { gSeason = Season::WINTER; upd = UpdateKind::FULL_REBUILD; }
+        break;
+
+    case UIButtonType::HUMIDITY_UP:
+        gHumidity = std::min(1.0f, gHumidity + 0.1f);
+        upd = UpdateKind::COLORS_ONLY;
+        break;
+    case UIButtonType::HUMIDITY_DOWN:
+        gHumidity = std::max(0.0f, gHumidity - 0.1f);
+        upd = UpdateKind::COLORS_ONLY;
+        break;
+
+    case UIButtonType::TIME_DAY:   gTimeOfDay = TimeOfDay::DAY;   upd = UpdateKind::NONE; break;
+    case UIButtonType::TIME_DUSK:  gTimeOfDay = TimeOfDay::DUSK;  upd = UpdateKind::NONE; break;
+    case UIButtonType::TIME_NIGHT: gTimeOfDay = TimeOfDay::NIGHT; upd = UpdateKind::NONE; break;
+    case UIButtonType::TIME_DAWN:  gTimeOfDay = TimeOfDay::DAWN;  upd = UpdateKind::NONE; break;
+    }
+
+    std::cout << "[UI] Final state - Season=" << (int)gSeason
+              << " Humidity=" << gHumidity
+              << " Time=" << (int)gTimeOfDay << std::endl;
+
+    if (gObjectShader) applySeasonParams(*gObjectShader);
+
+    if (upd == UpdateKind::FULL_REBUILD) rebuild_world();
+    else if (upd == UpdateKind::COLORS_ONLY) update_terrain_colors_only();
+}
+
+void handle_ui_click(double mouseX, double mouseY) {
+    if (!g_uiMode) return;
+
+    int currentWidth, currentHeight;
+    glfwGetFramebufferSize(window, &currentWidth, &currentHeight);
+
+    float ndcX = 2.0f * float(mouseX) / float(currentWidth) - 1.0f;
+    float ndcY = -2.0f * float(mouseY) / float(currentHeight) + 1.0f;
+
+    std::cout << "[CLICK] Window size: " << currentWidth << "x" << currentHeight
+              << " | Mouse: (" << mouseX << ", " << mouseY << ") -> NDC: ("
+              << ndcX << ", " << ndcY << ")" << std::endl;
+
+    for (int i = 0; i < (int)g_buttons.size(); i++) {
+        const auto& btn = g_buttons[i];
+        glm::vec2 min = btn.center - btn.halfSize;
+        glm::vec2 max = btn.center + btn.halfSize;
+
+        if (ndcX >= min.x && ndcX <= max.x &&
+            ndcY >= min.y && ndcY <= max.y) {
+            std::cout << "  Button[" << i << "] type=" << (int)btn.type << " HIT!" << std::endl;
+            on_button_clicked(btn.type);
+            return;
+        }
+    }
+
+    std::cout << "[CLICK] No button hit" << std::endl;
+}
+
+void mouse_button_callback(GLFWwindow* window_, int button, int action, int mods) {
+    (void)window_; (void)mods;
+    if (!g_uiMode) return;
+
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
+        double mx, my;
+        glfwGetCursorPos(window, &mx, &my);
+        handle_ui_click(mx, my);
+    }
+}
+
+void draw_ui(Shader &uiShader) {
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    uiShader.use();
+    glBindVertexArray(g_uiVAO);
+
+    for (auto &btn : g_buttons) {
+        uiShader.setVec4("uColor", btn.color);
+        uiShader.setVec2("uPos", btn.center);
+        uiShader.setVec2("uSize", btn.halfSize);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+    }
+
+    glBindVertexArray(0);
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+}
+
+// ----------------- World generation helpers -----------------
+// Puts every chunk out of date. The workers regenerate them around the camera,
+// nearest first; until its replacement is uploaded each chunk stays on screen.
+void rebuild_world() {
+    cancel_chunk_jobs();
+    g_worldGeneration++;
+    g_rebuildStart = glfwGetTime();
+    update_camera_chunk();
+    stream_chunks();
+}
+
+// Chunk (x, y) spans the chunkWidth - 1 quads from -chunkWidth / 2 + (chunkWidth - 1) * x.
+void update_camera_chunk() {
+    gridPosX = (int)std::floor((camera.Position.x + chunkWidth / 2.0f) / (chunkWidth - 1));
+    gridPosY = (int)std::floor((camera.Position.z + chunkHeight / 2.0f) / (chunkHeight - 1));
+}
+
+// Slots a side that stream the chunks within distance, at either render distance.
+int stream_window(int distance) {
+    return 2 * distance + STREAM_HYSTERESIS + 1;
+}
+
+int chunk_slot(int x, int y) {
+    int sx = x % xMapChunks, sy = y % yMapChunks;
+    return (sx < 0 ? sx + xMapChunks : sx) + (sy < 0 ? sy + yMapChunks : sy) * xMapChunks;
+}
+
+bool chunk_resident(int x, int y) {
+    int pos = chunk_slot(x, y);
+    return pos < (int)g_slotChunk.size() && g_slotChunk[pos] == glm::ivec2(x, y);
+}
+
+// Chunks within distance (Chebyshev) of the camera chunk, nearest ring first.
+std::vector<glm::ivec2> chunks_around_camera(int distance) {
+    std::vector<glm::ivec2> chunks;
+    chunks.push_back(glm::ivec2(gridPosX, gridPosY));
+    for (int ring = 1; ring <= distance; ring++) {
+        for (int i = -ring; i < ring; i++) {
+            chunks.push_back(glm::ivec2(gridPosX + i, gridPosY - ring));
+            chunks.push_back(glm::ivec2(gridPosX + ring, gridPosY + i));
+            chunks.push_back(glm::ivec2(gridPosX - i, gridPosY + ring));
+            chunks.push_back(glm::ivec2(gridPosX - ring, gridPosY - i));
+        }
+    }
+    return chunks;
+}
+
+// Uploads what the workers have finished, then queues the chunks within the
+// render distance that are missing or out of date, nearest first, while fewer
+// than STREAM_JOBS_IN_FLIGHT jobs are in flight. A chunk is built for the slot
+// it will live in and, once uploaded, evicts the chunk (and plants) the slot
+// held, which is at least the window minus the render distance away.
+void stream_chunks() {
+    upload_ready_chunks();
+    bool complete = true;
+    for (const glm::ivec2 &c : chunks_around_camera(terrain_render_distance())) {
+        const int pos = chunk_slot(c.x, c.y);
+        if (g_slotChunk[pos] == c && g_slotGeneration[pos] == g_worldGeneration) continue;
+        complete = false;
+        if (g_slotPending[pos] == c) continue;
+        if (!submit_chunk_job(c.x, c.y)) break;
+    }
+    if (complete && g_rebuildStart >= 0.0) {
+        std::cout << "[TERRAIN] world ready in " << (glfwGetTime() - g_rebuildStart) * 1000.0 << " ms on "
+                  << g_chunkWorkers.threads.size() << " worker threads" << std::endl;
+        g_rebuildStart = -1.0;
+    }
+}
+
+// Switches to size x size chunks (one of CHUNK_SIZES) before the world is
+// allocated, and puts the camera back at the start position.
+bool set_chunk_size(int size) {
+    if (std::find(CHUNK_SIZES, CHUNK_SIZES + CHUNK_SIZE_COUNT, size) == CHUNK_SIZES + CHUNK_SIZE_COUNT) return false;
+    chunkWidth = chunkHeight = size;
+    chunk_render_distance = std::max(1, (int)std::lround((double)RENDER_QUADS / (size - 1)));
+    lod_render_distance = std::max(1, (int)std::lround((double)LOD_RENDER_QUADS / (size - 1)));
+    xMapChunks = yMapChunks = stream_window(std::max(chunk_render_distance, lod_render_distance));
+    originX = (chunkWidth * xMapChunks) / 2 - chunkWidth / 2;
+    originY = (chunkHeight * yMapChunks) / 2 - chunkHeight / 2;
+    camera.Position.x = originX;
+    camera.Position.z = originY;
+    update_camera_chunk();
+    return true;
+}
+
+int chunk_lod_octaves(int xOffset, int yOffset) {
+    if (fixedPointNoise) return octaves;    // cached chunks must not depend on where the camera was
+    if (volumeTerrain) return octaves;      // volume chunks are meshed at full detail
+    int ring = std::max(std::abs(xOffset - gridPosX), std::abs(yOffset - gridPosY));
+    int coarse = octaves - std::max(0, ring - octaveLodRadius);
+    return std::max(coarse, std::min(octaves, octaveLodMinOctaves));
+}
+
+// Queue the nearest chunks whose octave LOD is coarser than the camera now wants.
+void refine_chunks() {
+    for (int n = 0; n < octaveRefinePerFrame; n++) {
+        int best = -1, bestRing = 0;
+        for (int pos = 0; pos < (int)g_slotChunk.size(); pos++) {
+            const glm::ivec2 c = g_slotChunk[pos];
+            if (c == NO_CHUNK || g_slotPending[pos] == c || g_chunkOctaves[pos] >= chunk_lod_octaves(c.x, c.y)) continue;
+            int ring = std::max(std::abs(c.x - gridPosX), std::abs(c.y - gridPosY));
+            if (best < 0 || ring < bestRing) { best = pos; bestRing = ring; }
+        }
+        if (best < 0 || !submit_chunk_job(g_slotChunk[best].x, g_slotChunk[best].y)) return;
+    }
+}
+
+// ----------------- main -----------------
+int main(int argc, char **argv) {
+    glm::mat4 view;
+    glm::mat4 model;
+    glm::mat4 projection;
+
+    bool runBench = false, tuneChunkSize = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--bench") runBench = true;
+        else if (arg == "--seed" && i + 1 < argc) worldSeed = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--warp" && i + 1 < argc) warpStrength = std::strtof(argv[++i], nullptr);
+        else if (arg == "--warp-step" && i + 1 < argc) warpGridStep = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--octave-error" && i + 1 < argc) octaveHeightError = std::strtof(argv[++i], nullptr);
+        else if (arg == "--octave-lod" && i + 1 < argc) octaveLodRadius = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--fixed-noise") fixedPointNoise = true;
+        else if (arg == "--volume") volumeTerrain = true;
+        else if (arg == "--no-cdlod") cdlodTerrain = false;
+        else if (arg == "--rtin" && i + 1 < argc) rtinMaxError = std::max(0.0f, std::strtof(argv[++i], nullptr));
+        else if (arg == "--tune-frames" && i + 1 < argc) chunkTuneFrames = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--chunk-size" && i + 1 < argc) {
+            std::string size = argv[++i];
+            if (size == "auto") tuneChunkSize = true;
+            else if (!set_chunk_size(std::atoi(size.c_str())))
+                std::cout << "[WORLD] chunk size must be one of 33, 65, 129, 257; keeping " << chunkWidth << std::endl;
+        }
+        else if (arg == "--terrain" && i + 1 < argc) {
+            if (!parse_terrain_preset(argv[++i], terrainPreset))
+                std::cout << "[WORLD] unknown terrain preset '" << argv[i] << "', using classic" << std::endl;
+        }
+        else if (arg == "--fractal" && i + 1 < argc) {
+            if (!parse_fractal_mode(argv[++i], fractalMode))
+                std::cout << "[WORLD] unknown fractal mode '" << argv[i] << "', using fbm" << std::endl;
+        }
+        else if (arg == "--index-order" && i + 1 < argc) {
+            if (!parse_index_order(argv[++i], indexOrder))
+                std::cout << "[WORLD] unknown index order '" << argv[i] << "', using blocked" << std::endl;
+        }
+        else if (arg == "--noise" && i + 1 < argc) {
+            if (!parse_noise_backend(argv[++i], noiseBackend))
+                std::cout << "[WORLD] unknown noise backend '" << argv[i] << "', using perlin3d" << std::endl;
+        }
+    }
+
+    g_noiseContext = get_noise_context(worldSeed);
+    std::cout << "[WORLD] seed=" << worldSeed << " noise=" << noise_backend_name(noiseBackend)
+              << " fractal=" << fractal_mode_name(fractalMode) << " terrain=" << terrain_preset_name(terrainPreset)
+              << (fixedPointNoise ? " (fixed point)" : "") << (volumeTerrain ? " (volume)" : "") << std::endl;
+
+    // headless: time the terrain generation paths and exit
+    if (runBench)
+        return run_benchmarks();
+
+    if (init() != 0)
+        return -1;
+
+    Shader objectShader("shaders/objectShader.vert", "shaders/objectShader.frag");
+    Shader uiShader("shaders/uiShader.vert", "shaders/uiShader.frag");
+
+    objectShader.use();
+    objectShader.setBool("isFlat", false);    // start smooth; H / G switch flat shading on and off
+
+    objectShader.setVec3("light.ambient", 0.2f, 0.2f, 0.2f);
+    objectShader.setVec3("light.diffuse", 0.3f, 0.3f, 0.3f);
+    objectShader.setVec3("light.specular", 1.0f, 1.0f, 1.0f);
+    objectShader.setVec3("light.direction", -0.2f, -1.0f, -0.3f);
+
+    objectShader.setInt("u_season", (int)gSeason);
+    objectShader.setInt("u_heightTexels", 1);
+    objectShader.setInt("u_colorTexels", 2);
+
+    if (tuneChunkSize) set_chunk_size(tune_chunk_size(measure_draw_call_us()));
+
+    int chunkN = xMapChunks * yMapChunks;
+    g_map_chunks.resize(chunkN);
+    g_tree_chunks.resize(chunkN);
+    g_flower_chunks.resize(chunkN);
+    g_chunkVertices.resize(chunkN);
+    g_chunkOctaves.assign(chunkN, 0);
+    g_slotChunk.assign(chunkN, NO_CHUNK);
+    g_slotGeneration.assign(chunkN, 0);
+    g_slotPending.assign(chunkN, NO_CHUNK);
+
+    // ---- FIX: allocate terrain buffers ----
+    g_mapVertexVBO.assign(chunkN, 0);
+    g_mapColorVBO.assign(chunkN, 0);
+    g_mapEBO.assign(chunkN, 0);
+    g_mapIndexCount.assign(chunkN, 0);
+    g_mapIndexType.assign(chunkN, GL_UNSIGNED_SHORT);
+    g_mapVertexFormat.assign(chunkN, PACKED_GRID);
+    g_mapHeightTex.assign(chunkN, 0);
+    g_mapColorTex.assign(chunkN, 0);
+    g_chunkNodeBounds.resize(chunkN);
+
+    // ---- FIX: allocate instancing buffers/count ----
+    g_treeInstanceVBO.assign(chunkN, 0);
+    g_flowerInstanceVBO.assign(chunkN, 0);
+    g_treeInstanceCount.assign(chunkN, 0);
+    g_flowerInstanceCount.assign(chunkN, 0);
+
+    gObjectShader = &objectShader;
+    applySeasonParams(objectShader);
+    // one core stays with the GL thread
+    const unsigned cores = std::thread::hardware_concurrency();
+    start_chunk_workers(cores > 2 ? cores - 1 : 1);
+    rebuild_world();
+
+    lastTime = glfwGetTime();
+    nbFrames = 0;
+
+    while (!glfwWindowShouldClose(window)) {
+        objectShader.use();
+        projection = glm::perspective(glm::radians(camera.Zoom),
+                                      (float)WIDTH / (float)HEIGHT,
+                                      0.1f,
+                                      (float)chunkWidth * (terrain_render_distance() - 1.2f));
+        view = camera.GetViewMatrix();
+        objectShader.setMat4("u_projection", projection);
+        objectShader.setMat4("u_view", view);
+        objectShader.setVec3("u_viewPos", camera.Position);
+
+        render(g_map_chunks, objectShader, view, model, projection,
+               g_tree_chunks, g_flower_chunks, uiShader);
+    }
+
+    // cleanup
+    stop_chunk_workers();
+    for (int i = 0; i < (int)g_map_chunks.size(); i++) {
+        if (g_tree_chunks[i]) glDeleteVertexArrays(1, &g_tree_chunks[i]);
+        if (g_flower_chunks[i]) glDeleteVertexArrays(1, &g_flower_chunks[i]);
+    }
+
+    for (int i = 0; i < (int)g_map_chunks.size(); i++) {
+        destroy_map_chunk(i);
+    }
+
+    if (g_gridEBO) glDeleteBuffers(1, &g_gridEBO);
+    if (g_terrainTimer[0]) glDeleteQueries(TERRAIN_TIMER_QUERIES, g_terrainTimer);
+    for (auto b : g_treeInstanceVBO) if (b) glDeleteBuffers(1, &b);
+    for (auto b : g_flowerInstanceVBO) if (b) glDeleteBuffers(1, &b);
+
+    if (g_textVAO) glDeleteVertexArrays(1, &g_textVAO);
+    if (g_textVBO) glDeleteBuffers(1, &g_textVBO);
+    if (g_fontTex) glDeleteTextures(1, &g_fontTex);
+    if (g_uiVAO) glDeleteVertexArrays(1, &g_uiVAO);
+    if (g_uiVBO) glDeleteBuffers(1, &g_uiVBO);
+
+    delete g_textShader;
+    glfwTerminate();
+    return 0;
+}
+
+// ----------------- instancing & render -----------------
+// Plants reach as far as the terrain: flowers stop at chunk_render_distance,
+// trees go on to terrain_render_distance and thin out with (chunk_render_distance / ring)^2
+// past it, so the tree count per frame grows with the render distance rather
+// than with its square. Instances are uploaded in bit-reversed order, so
+// drawing the first n of a chunk spreads them over the whole chunk.
+void setup_instancing(GLuint &VAO, std::vector<GLuint> &plant_chunk, std::string plant_type,
+                      std::vector<plant> &plants, std::string filename, int onlySlot) {
+    (void)VAO;
+
+    const int chunkN = xMapChunks * yMapChunks;
+    if ((int)plant_chunk.size() != chunkN) plant_chunk.resize(chunkN, 0);
+
+    std::vector<GLuint>* instVBOs = nullptr;
+    std::vector<GLsizei>* instCnt = nullptr;
+
+    if (plant_type == "tree") {
+        instVBOs = &g_treeInstanceVBO;
+        instCnt  = &g_treeInstanceCount;
+    } else {
+        instVBOs = &g_flowerInstanceVBO;
+        instCnt  = &g_flowerInstanceCount;
+    }
+
+    if ((int)instVBOs->size() != chunkN) instVBOs->assign(chunkN, 0);
+    if ((int)instCnt->size()  != chunkN) instCnt->assign(chunkN, 0);
+
+    // load model VAO for each chunk (only once), create instance VBOs
+    for (int i = 0; i < chunkN; i++) {
+        if (onlySlot >= 0 && i != onlySlot) continue;
+        if (plant_chunk[i] == 0) {
+            int vcount = 0;
+            float minY = load_model(plant_chunk[i], filename, &vcount);
+
+            if (plant_type == "tree" && !g_treeMinYSet) {
+                g_treeMinY = minY; g_treeMinYSet = true; g_treeVertexCount = vcount;
+                std::cout << "[INFO] Tree minY=" << g_treeMinY << " vtx=" << g_treeVertexCount << "\n";
+            }
+            if (plant_type == "flower" && !g_flowerMinYSet) {
+                g_flowerMinY = minY; g_flowerMinYSet = true; g_flowerVertexCount = vcount;
+                std::cout << "[INFO] Flower minY=" << g_flowerMinY << " vtx=" << g_flowerVertexCount << "\n";
+            }
+        }
+        if ((*instVBOs)[i] == 0) {
+            glGenBuffers(1, &((*instVBOs)[i]));
+        }
+    }
+
+    float modelMinY = (plant_type == "tree") ? g_treeMinY : g_flowerMinY;
+
+    // collect instances per chunk
+    std::vector<std::vector<float>> chunkInstances(chunkN), scanOrder(chunkN);
+
+    for (int i = 0; i < (int)plants.size(); i++) {
+        if (plants[i].type != plant_type) continue;
+
+        float xPos = plants[i].xpos / MODEL_SCALE;
+        float yPos = plants[i].ypos / MODEL_SCALE + (-modelMinY);
+        float zPos = plants[i].zpos / MODEL_SCALE;
+
+        if (!chunk_resident(plants[i].xOffset, plants[i].yOffset)) continue;
+        int pos = chunk_slot(plants[i].xOffset, plants[i].yOffset);
+        if (onlySlot >= 0 && pos != onlySlot) continue;
+
+        scanOrder[pos].push_back(xPos);
+        scanOrder[pos].push_back(yPos);
+        scanOrder[pos].push_back(zPos);
+    }
+
+    // bit-reversed order, for drawing a thinned-out prefix far away
+    for (int pos = 0; pos < chunkN; pos++) {
+        const std::vector<float> &in = scanOrder[pos];
+        const uint32_t n = (uint32_t)in.size() / 3;
+        int bits = 0;
+        while ((1u << bits) < n) bits++;
+        for (uint32_t k = 0; k < (1u << bits); k++) {
+            uint32_t r = 0;
+            for (int b = 0; b < bits; b++) r |= ((k >> b) & 1u) << (bits - 1 - b);
+            if (r < n) chunkInstances[pos].insert(chunkInstances[pos].end(), &in[3 * r], &in[3 * r] + 3);
+        }
+    }
+
+    // upload instance buffers
+    for (int pos = 0; pos < chunkN; pos++) {
+        if (onlySlot >= 0 && pos != onlySlot) continue;
+
+        glBindVertexArray(plant_chunk[pos]);
+        glBindBuffer(GL_ARRAY_BUFFER, (*instVBOs)[pos]);
+
+        auto& data = chunkInstances[pos];
+        glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float),
+                     data.empty() ? nullptr : data.data(),
+                     GL_STATIC_DRAW);
+
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glVertexAttribDivisor(3, 1);
+
+        (*instCnt)[pos] = (GLsizei)(data.size() / 3);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Re-uploads the tree and flower instances of one slot's chunk.
+void update_chunk_instances(int slot) {
+    setup_instancing(g_treeVAO, g_tree_chunks, "tree", g_plants, "obj/CommonTree_1.obj", slot);
+    setup_instancing(g_flowerVAO, g_flower_chunks, "flower", g_plants, "obj/Flowers.obj", slot);
+}
+
+void render(std::vector<GLuint> &map_chunks, Shader &shader,
+            glm::mat4 &view, glm::mat4 &model, glm::mat4 &projection,
+            std::vector<GLuint> &tree_chunks,
+            std::vector<GLuint> &flower_chunks, Shader &uiShader) {
+
+    currentFrame = (float)glfwGetTime();
+    deltaTime = currentFrame - lastFrame;
+    lastFrame = currentFrame;
+
+    processInput(window, shader);
+
+    glClearColor(gSky.x, gSky.y, gSky.z, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    update_camera_chunk();
+    stream_chunks();
+    refine_chunks();
+
+    shader.setInt("u_gridWidth", chunkWidth);
+    shader.setInt("u_gridHeight", chunkHeight);
+    shader.setVec3("u_terrainExtent", terrain_pack_extent());
+
+    // ---- terrain ----
+    static int timerFrame = 0;
+    if (g_terrainTimer[0] == 0) glGenQueries(TERRAIN_TIMER_QUERIES, g_terrainTimer);
+    const int timerSlot = timerFrame++ % TERRAIN_TIMER_QUERIES;
+    const GLuint timer = g_terrainTimer[timerSlot];
+    if (g_terrainTimerPending[timerSlot]) {
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(timer, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(timer, GL_QUERY_RESULT, &ns);
+            g_terrainGpuMs += ns / 1e6;
+            g_terrainGpuFrames++;
+            g_terrainTimerPending[timerSlot] = false;
+        }
+    }
+    const bool timed = !g_terrainTimerPending[timerSlot];
+    if (timed) glBeginQuery(GL_TIME_ELAPSED, timer);
+    glPrimitiveRestartIndex(g_gridIndexType == GL_UNSIGNED_SHORT ? 0xFFFFu : 0xFFFFFFFFu);
+
+    shader.setBool("u_isPlant", false);
+    shader.setInt("u_plantKind", 0);
+    shader.setInt("u_season", (int)gSeason);
+    const int drawDistance = terrain_render_distance();
+    const GLint lodStepLoc = glGetUniformLocation(shader.ID, "u_lodStep");
+    const GLint morphRangeLoc = glGetUniformLocation(shader.ID, "u_morphRange");
+    const GLint flatPatternLoc = glGetUniformLocation(shader.ID, "u_flatPattern");
+    const size_t indexBytes = g_gridIndexType == GL_UNSIGNED_SHORT ? 2 : 4;
+    static std::vector<CdlodDraw> draws;
+    for (int y = gridPosY - drawDistance; y <= gridPosY + drawDistance; y++) {
+        for (int x = gridPosX - drawDistance; x <= gridPosX + drawDistance; x++) {
+            if (chunk_resident(x, y)) {
+
+                int idx = chunk_slot(x, y);
+                glm::vec3 chunkOrigin(-chunkWidth / 2.0f + (chunkWidth - 1) * x, 0.0f,
+                                      -chunkHeight / 2.0f + (chunkHeight - 1) * y);
+                model = glm::translate(glm::mat4(1.0f), chunkOrigin);
+                shader.setMat4("u_model", model);
+                shader.setInt("u_terrainFormat", g_mapVertexFormat[idx]);
+
+                // volume and RTIN chunks draw their own lists; other grid chunks their CDLOD nodes
+                // or the shared buffer in its current order. The CDLOD morph and flat shading
+                // fetch neighbouring grid vertices from the texture buffers.
+                glBindVertexArray(map_chunks[idx]);
+                if (g_mapHeightTex[idx]) {
+                    glActiveTexture(GL_TEXTURE1);
+                    glBindTexture(GL_TEXTURE_BUFFER, g_mapHeightTex[idx]);
+                    glActiveTexture(GL_TEXTURE2);
+                    glBindTexture(GL_TEXTURE_BUFFER, g_mapColorTex[idx]);
+                    glActiveTexture(GL_TEXTURE0);
+                }
+                if (g_mapEBO[idx]) {
+                    glUniform1i(flatPatternLoc, FLAT_DERIVATIVES);
+                    glDrawElements(GL_TRIANGLES, g_mapIndexCount[idx], g_mapIndexType[idx], 0);
+                } else if (cdlodTerrain && !g_chunkNodeBounds[idx].empty()) {
+                    glUniform1i(flatPatternLoc, FLAT_LISTS);
+                    draws.clear();
+                    cdlod_select(g_chunkNodeBounds[idx], camera.Position - chunkOrigin, draws);
+                    for (const CdlodDraw &d : draws) {
+                        glm::vec2 range = cdlod_morph_range(d.level);
+                        glUniform1i(lodStepLoc, 1 << d.level);
+                        glUniform2f(morphRangeLoc, range.x, range.y);
+                        glDrawElements(GL_TRIANGLES, d.count, g_gridIndexType,
+                                       (void*)((g_cdlodIndexBase + d.first) * indexBytes));
+                    }
+                    glUniform1i(lodStepLoc, 0);
+                } else {
+                    glUniform1i(flatPatternLoc, g_gridPrimitive == GL_TRIANGLE_STRIP ? FLAT_STRIPS : FLAT_LISTS);
+                    if (g_gridPrimitive == GL_TRIANGLE_STRIP) glEnable(GL_PRIMITIVE_RESTART);
+                    glDrawElements(g_gridPrimitive, g_gridIndexCount, g_gridIndexType, 0);
+                    glDisable(GL_PRIMITIVE_RESTART);
+                }
+            }
+        }
+    }
+    shader.setInt("u_terrainFormat", FLOAT_VERTICES);
+    if (timed) {
+        glEndQuery(GL_TIME_ELAPSED);
+        g_terrainTimerPending[timerSlot] = true;
+    }
+
+    for (int y = gridPosY - drawDistance; y <= gridPosY + drawDistance; y++) {
+        for (int x = gridPosX - drawDistance; x <= gridPosX + drawDistance; x++) {
+            if (chunk_resident(x, y)) {
+
+                int idx = chunk_slot(x, y);
+                const int ring = std::max(std::abs(x - gridPosX), std::abs(y - gridPosY));
+                const bool nearChunk = ring <= chunk_render_distance;
+                const float density = nearChunk ? 1.0f : (float)(chunk_render_distance * chunk_render_distance) / (ring * ring);
+
+                // ---- plants ----
+                model = glm::mat4(1.0f);
+                model = glm::translate(model,
+                    glm::vec3(-chunkWidth / 2.0f + (chunkWidth - 1) * x,
+                              0.0f,
+                              -chunkHeight / 2.0f + (chunkHeight - 1) * y));
+                model = glm::scale(model, glm::vec3(MODEL_SCALE));
+
+                shader.setMat4("u_model", model);
+                shader.setBool("u_isPlant", true);
+                shader.setInt("u_season", (int)gSeason);
+
+                glEnable(GL_CULL_FACE);
+
+                // flowers (FIX: use real instance count + real vertex count)
+                shader.setInt("u_plantKind", 1);
+                GLsizei fcnt = (nearChunk && idx < (int)g_flowerInstanceCount.size()) ? g_flowerInstanceCount[idx] : 0;
+                if (fcnt > 0) {
+                    glBindVertexArray(flower_chunks[idx]);
+                    glDrawArraysInstanced(GL_TRIANGLES, 0, g_flowerVertexCount, fcnt);
+                }
+
+                // trees (FIX)
+                shader.setInt("u_plantKind", 2);
+                GLsizei tcnt = (idx < (int)g_treeInstanceCount.size()) ? g_treeInstanceCount[idx] : 0;
+                tcnt = (GLsizei)std::ceil(tcnt * density);
+                if (tcnt > 0) {
+                    glBindVertexArray(tree_chunks[idx]);
+                    glDrawArraysInstanced(GL_TRIANGLES, 0, g_treeVertexCount, tcnt);
+                }
+
+                glDisable(GL_CULL_FACE);
+
+                shader.setBool("u_isPlant", false);
+                shader.setInt("u_plantKind", 0);
+                shader.setInt("u_season", (int)gSeason);
+            }
+        }
+    }
+
+    draw_ui(uiShader);
+
+    // ---- text ----
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    if (g_textShader) {
+        g_textShader->use();
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, g_fontTex);
+
+        float seasonSize = g_buttons[0].halfSize.y * 2.0f * 0.60f;
+        draw_text_centered_in_button(g_buttons[0], "SPRING", seasonSize, {1,1,1});
+        draw_text_centered_in_button(g_buttons[1], "SUMMER", seasonSize, {1,1,1});
+        draw_text_centered_in_button(g_buttons[2], "AUTUMN", seasonSize, {1,1,1});
+        draw_text_centered_in_button(g_buttons[3], "WINTER", seasonSize, {1,1,1});
+
+        draw_text_centered_in_button(g_buttons[4], "DAY", seasonSize, {1,1,1});
+        draw_text_centered_in_button(g_buttons[5], "DUSK", seasonSize, {1,1,1});
+        draw_text_centered_in_button(g_buttons[6], "NIGHT", seasonSize, {1,1,1});
+        draw_text_centered_in_button(g_buttons[7], "DAWN", seasonSize, {1,1,1});
+
+        float pmSize = g_buttons[8].halfSize.y * 2.0f * 0.80f;
+        draw_text_centered_in_button(g_buttons[8], "-", pmSize, {1,1,1});
+        draw_text_centered_in_button(g_buttons[9], "+", pmSize, {1,1,1});
+
+        std::string seasonText =
+            (gSeason == Season::SPRING) ? "Spring" :
+            (gSeason == Season::SUMMER) ? "Summer" :
+            (gSeason == Season::AUTUMN) ? "Autumn" : "Winter";
+
+        std::string timeText =
+            (gTimeOfDay == TimeOfDay::DAY) ? "Day" :
+            (gTimeOfDay == TimeOfDay::DUSK) ? "Dusk" :
+            (gTimeOfDay == TimeOfDay::NIGHT) ? "Night" : "Dawn";
+
+        draw_text(*g_textShader, "Season: " + seasonText, -0.95f, -0.80f, 0.06f, {1,1,0});
+        draw_text(*g_textShader, "Time: " + timeText, -0.95f, -0.86f, 0.06f, {1,0.8f,0.5f});
+        draw_text(*g_textShader, "Humidity: " + std::to_string(int(gHumidity * 100)) + "%",
+                  0.55f, -0.86f, 0.06f, {0.7f,0.9f,1.0f});
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+
+    double currentTime = glfwGetTime();
+    nbFrames++;
+    if (currentTime - lastTime >= 1.0) {
+        printf("%f ms/frame, terrain %.3f ms GPU (%s indices)\n", 1000.0 / double(nbFrames),
+               g_terrainGpuFrames ? g_terrainGpuMs / g_terrainGpuFrames : 0.0, index_order_name(indexOrder));
+        g_terrainGpuMs = 0.0;
+        g_terrainGpuFrames = 0;
+        nbFrames = 0;
+        lastTime += 1.0;
+    }
+
+    glfwPollEvents();
+    glfwSwapBuffers(window);
+}
+
+// ? @@LATIN1_COMMENT@@
+static inline bool is_underwater_footprint(
+    float plantX, float plantZ,
+    const std::vector<float>& vertices,
+    int chunkWidth_, int chunkHeight_,
+    float waterLevel,
+    float radius)
+{
+    const float dx[9] = {0, radius, -radius, 0, 0, radius, radius, -radius, -radius};
+    const float dz[9] = {0, 0, 0, radius, -radius, radius, -radius, radius, -radius};
+
+    for (int i = 0; i < 9; i++) {
+        float h = get_terrain_height_at(plantX + dx[i], plantZ + dz[i],
+                                       vertices, chunkWidth_, chunkHeight_);
+        if (h <= waterLevel + 1.0f) return true;
+    }
+    return false;
+}
+
+// ----------------- Model loading & terrain -----------------
+float load_model(GLuint &VAO, std::string filename, int* outVertexCount) {
+    std::vector<float> vertices;
+    float minY = 1e9f;
+
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+
+    std::string warn;
+    std::string err;
+
+    bool ok = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filename.c_str());
+
+    if (!warn.empty()) std::cout << warn << std::endl;
+    if (!err.empty())  std::cerr << err << std::endl;
+    if (!ok) {
+        std::cerr << "[ERR] LoadObj failed: " << filename << std::endl;
+        if (outVertexCount) *outVertexCount = 0;
+        return 0.0f;
+    }
+
+    for (size_t s = 0; s < shapes.size(); s++) {
+        size_t index_offset = 0;
+        for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++) {
+            int fv = shapes[s].mesh.num_face_vertices[f];
+
+            int matId = -1;
+            if (f < shapes[s].mesh.material_ids.size()) matId = shapes[s].mesh.material_ids[f];
+
+            glm::vec3 diffuse(1.0f, 1.0f, 1.0f);
+            if (matId >= 0 && matId < (int)materials.size()) {
+                diffuse = glm::vec3(materials[matId].diffuse[0],
+                                    materials[matId].diffuse[1],
+                                    materials[matId].diffuse[2]);
+            }
+
+            for (int v = 0; v < fv; v++) {
+                tinyobj::index_t idx = shapes[s].mesh.indices[index_offset + v];
+
+                float px = attrib.vertices[3 * idx.vertex_index + 0];
+                float py = attrib.vertices[3 * idx.vertex_index + 1];
+                float pz = attrib.vertices[3 * idx.vertex_index + 2];
+
+                minY = std::min(minY, py);
+
+                glm::vec3 n(0,1,0);
+                if (idx.normal_index >= 0 && (3 * idx.normal_index + 2) < (int)attrib.normals.size()) {
+                    n = glm::vec3(attrib.normals[3 * idx.normal_index + 0],
+                                  attrib.normals[3 * idx.normal_index + 1],
+                                  attrib.normals[3 * idx.normal_index + 2]);
+                }
+
+                vertices.push_back(px);
+                vertices.push_back(py);
+                vertices.push_back(pz);
+                vertices.push_back(n.x);
+                vertices.push_back(n.y);
+                vertices.push_back(n.z);
+                vertices.push_back(diffuse.x * MODEL_BRIGHTNESS);
+                vertices.push_back(diffuse.y * MODEL_BRIGHTNESS);
+                vertices.push_back(diffuse.z * MODEL_BRIGHTNESS);
+            }
+            index_offset += fv;
+        }
+    }
+
+    if (outVertexCount) *outVertexCount = (int)vertices.size() / 9;
+
+    GLuint VBO;
+    glGenBuffers(1, &VBO);
+    glGenVertexArrays(1, &VAO);
+
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER,
+                 vertices.size() * sizeof(float),
+                 vertices.data(),
+                 GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+
+    glBindVertexArray(0);
+
+    return (minY == 1e9f) ? 0.0f : minY;
+}
+
+const char *index_order_name(IndexOrder order) {
+    switch (order) {
+    case IndexOrder::ROW_MAJOR: return "row";
+    case IndexOrder::STRIPS:    return "strip";
+    default:                    return "blocked";
+    }
+}
+
+static bool parse_index_order(const std::string &name, IndexOrder &order) {
+    for (int i = 0; i < INDEX_ORDER_COUNT; i++) {
+        if (name == index_order_name((IndexOrder)i)) {
+            order = (IndexOrder)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Fills the shared grid index buffer in indexOrder. The first call comes with
+// a chunk VAO bound, which keeps the buffer bound; later ones (a new order)
+// refill it through GL_COPY_WRITE_BUFFER, leaving every VAO's binding alone.
+static void fill_grid_index_buffer() {
+    std::vector<int> indices = generate_indices(indexOrder);
+    g_gridIndexCount = (GLsizei)indices.size();
+    g_gridPrimitive = indexOrder == IndexOrder::STRIPS ? GL_TRIANGLE_STRIP : GL_TRIANGLES;
+    g_cdlodIndexBase = g_gridIndexCount;
+    std::vector<int> nodes = cdlod_indices();
+    indices.insert(indices.end(), nodes.begin(), nodes.end());
+    GLenum target = GL_COPY_WRITE_BUFFER;
+    if (g_gridEBO == 0) {
+        glGenBuffers(1, &g_gridEBO);
+        target = GL_ELEMENT_ARRAY_BUFFER;
+    }
+    glBindBuffer(target, g_gridEBO);
+    if (chunkWidth * chunkHeight <= 65535) {    // 0xFFFF is the restart index
+        std::vector<uint16_t> narrow(indices.begin(), indices.end());
+        g_gridIndexType = GL_UNSIGNED_SHORT;
+        glBufferData(target, narrow.size() * sizeof(uint16_t), narrow.data(), GL_STATIC_DRAW);
+    } else {
+        g_gridIndexType = GL_UNSIGNED_INT;
+        glBufferData(target, indices.size() * sizeof(int), indices.data(), GL_STATIC_DRAW);
+    }
+    if (target == GL_COPY_WRITE_BUFFER) glBindBuffer(target, 0);
+    std::cout << "[TERRAIN] shared grid index buffer (" << index_order_name(indexOrder) << "): " << g_gridIndexCount
+              << " indices + " << nodes.size() << " for " << cdlod_levels() << " CDLOD levels, "
+              << indices.size() * (g_gridIndexType == GL_UNSIGNED_SHORT ? 2 : 4) << " bytes" << std::endl;
+}
+
+static int cdlod_levels() {
+    int levels = 1;
+    while ((CDLOD_NODE_QUADS << (levels - 1)) < std::max(chunkWidth, chunkHeight) - 1) levels++;
+    return levels;
+}
+
+// Nodes are numbered level by level from the root down, row-major within a level.
+static int cdlod_node_index(int level, int nx, int nz, int levels) {
+    int base = 0;
+    for (int l = levels - 1; l > level; l--) base += 1 << (2 * (levels - 1 - l));
+    return base + nx + nz * (1 << (levels - 1 - level));
+}
+
+// Index lists of every node in cdlod_node_index order, each as four quadrants
+// of (CDLOD_NODE_QUADS / 2)^2 quads, so a quadrant can be drawn on its own
+// when the rest of the node is drawn finer. Same triangles per quad as
+// generate_indices; vertices past the chunk clamp onto its last row / column.
+static std::vector<int> cdlod_indices() {
+    const int levels = cdlod_levels(), half = CDLOD_NODE_QUADS / 2;
+    auto vertex = [](int x, int z) { return std::min(x, chunkWidth - 1) + std::min(z, chunkHeight - 1) * chunkWidth; };
+    std::vector<int> indices;
+    for (int level = levels - 1; level >= 0; level--) {
+        const int n = 1 << (levels - 1 - level), step = 1 << level, size = CDLOD_NODE_QUADS << level;
+        for (int nz = 0; nz < n; nz++)
+            for (int nx = 0; nx < n; nx++)
+                for (int q = 0; q < 4; q++)
+                    for (int j = 0; j < half; j++)
+                        for (int i = 0; i < half; i++) {
+                            int x = nx * size + ((q & 1) * half + i) * step, z = nz * size + ((q >> 1) * half + j) * step;
+                            int a = vertex(x, z), b = vertex(x + step, z), c = vertex(x, z + step),
+                                d = vertex(x + step, z + step);
+                            indices.insert(indices.end(), { c, a, d, b, d, a });
+                        }
+    }
+    return indices;
+}
+
+// Min / max height over each node's vertices (edges included), leaves first, then merged upwards.
+static void cdlod_node_bounds(const std::vector<float> &verts, std::vector<float> &bounds) {
+    const int levels = cdlod_levels();
+    bounds.assign(2 * cdlod_node_index(-1, 0, 0, levels), 0.0f);
+    const int leaves = 1 << (levels - 1);
+    for (int nz = 0; nz < leaves; nz++) {
+        for (int nx = 0; nx < leaves; nx++) {
+            float lo = INFINITY, hi = -INFINITY;
+            int x0 = std::min(nx * CDLOD_NODE_QUADS, chunkWidth - 1), x1 = std::min(x0 + CDLOD_NODE_QUADS, chunkWidth - 1);
+            int z0 = std::min(nz * CDLOD_NODE_QUADS, chunkHeight - 1), z1 = std::min(z0 + CDLOD_NODE_QUADS, chunkHeight - 1);
+            for (int z = z0; z <= z1; z++)
+                for (int x = x0; x <= x1; x++) {
+                    float h = verts[3 * (x + z * chunkWidth) + 1];
+                    lo = std::min(lo, h);
+                    hi = std::max(hi, h);
+                }
+            int node = cdlod_node_index(0, nx, nz, levels);
+            bounds[2 * node] = lo;
+            bounds[2 * node + 1] = hi;
+        }
+    }
+    for (int level = 1; level < levels; level++) {
+        for (int nz = 0; nz < 1 << (levels - 1 - level); nz++) {
+            for (int nx = 0; nx < 1 << (levels - 1 - level); nx++) {
+                float lo = INFINITY, hi = -INFINITY;
+                for (int c = 0; c < 4; c++) {
+                    int child = cdlod_node_index(level - 1, 2 * nx + (c & 1), 2 * nz + (c >> 1), levels);
+                    lo = std::min(lo, bounds[2 * child]);
+                    hi = std::max(hi, bounds[2 * child + 1]);
+                }
+                int node = cdlod_node_index(level, nx, nz, levels);
+                bounds[2 * node] = lo;
+                bounds[2 * node + 1] = hi;
+            }
+        }
+    }
+}
+
+// Level k is drawn within cdlod_range(k) of the camera. Twice the diagonal of
+// a level-k node (heights up to the 1.5 meshHeight ceiling) keeps the next
+// level's morph from starting where the two levels meet.
+static float cdlod_range(int level) {
+    float s = (float)CDLOD_NODE_QUADS, h = 1.5f * meshHeight;
+    return 2.0f * std::sqrt(2.0f * s * s + h * h) * (float)(1 << level);
+}
+
+// u_morphRange for a level: the coarsest one has nothing to morph into.
+static glm::vec2 cdlod_morph_range(int level) {
+    if (level >= cdlod_levels() - 1) return glm::vec2(1e30f, 2e30f);
+    return glm::vec2(CDLOD_MORPH_START * cdlod_range(level), cdlod_range(level));
+}
+
+static void cdlod_select_node(int level, int nx, int nz, int levels, const std::vector<float> &bounds,
+                              const glm::vec3 &camLocal, std::vector<CdlodDraw> &out) {
+    const GLsizei quadrantIndices = CDLOD_NODE_QUADS * CDLOD_NODE_QUADS / 4 * 6;
+    auto box_distance = [&](int l, int x, int z) {
+        int size = CDLOD_NODE_QUADS << l, node = cdlod_node_index(l, x, z, levels);
+        glm::vec3 lo((float)std::min(x * size, chunkWidth - 1), bounds[2 * node], (float)std::min(z * size, chunkHeight - 1));
+        glm::vec3 hi((float)std::min((x + 1) * size, chunkWidth - 1), bounds[2 * node + 1],
+                     (float)std::min((z + 1) * size, chunkHeight - 1));
+        return glm::length(glm::max(glm::max(lo - camLocal, camLocal - hi), glm::vec3(0.0f)));
+    };
+    const GLsizei first = cdlod_node_index(level, nx, nz, levels) * 4 * quadrantIndices;
+    if (level == 0 || box_distance(level, nx, nz) > cdlod_range(level - 1)) {
+        out.push_back({ level, first, 4 * quadrantIndices });
+        return;
+    }
+    // children in range of the finer level go down; the others stay quadrants of this node
+    for (int c = 0; c < 4; c++) {
+        int cx = 2 * nx + (c & 1), cz = 2 * nz + (c >> 1);
+        if ((cx * (CDLOD_NODE_QUADS << (level - 1))) >= chunkWidth - 1 ||
+            (cz * (CDLOD_NODE_QUADS << (level - 1))) >= chunkHeight - 1) continue;   // past the chunk
+        if (box_distance(level - 1, cx, cz) <= cdlod_range(level - 1))
+            cdlod_select_node(level - 1, cx, cz, levels, bounds, camLocal, out);
+        else
+            out.push_back({ level, first + c * quadrantIndices, quadrantIndices });
+    }
+}
+
+// The node (or node quadrant) draws covering one grid chunk; camLocal is the camera in chunk coordinates.
+static void cdlod_select(const std::vector<float> &bounds, const glm::vec3 &camLocal, std::vector<CdlodDraw> &out) {
+    const int levels = cdlod_levels();
+    cdlod_select_node(levels - 1, 0, 0, levels, bounds, camLocal, out);
+}
+
+// Chunks drawn around the camera: with CDLOD a far chunk costs a few hundred
+// triangles, so lod_render_distance of them fit the frame time of full detail.
+int terrain_render_distance() {
+    return cdlodTerrain && !volumeTerrain && rtinMaxError <= 0.0f ? lod_render_distance : chunk_render_distance;
+}
+
+// Whether whole chunks of this size reach exactly RENDER_QUADS and
+// LOD_RENDER_QUADS, so the tuner compares it over the terrain the others draw.
+bool chunk_size_keeps_reach(int size) {
+    return RENDER_QUADS % (size - 1) == 0 && LOD_RENDER_QUADS % (size - 1) == 0;
+}
+
+// CPU time of one terrain-sized draw call on this driver: a few thousand
+// one-triangle draws from a throwaway VAO, with the queue drained around them.
+double measure_draw_call_us() {
+    const int draws = 2000;
+    GLuint vao, vbo;
+    const float triangle[9] = { 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(triangle), triangle, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glFinish();
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < draws; i++) glDrawArrays(GL_TRIANGLES, 0, 3);
+    glFinish();
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / draws;
+    glBindVertexArray(0);
+    glDeleteBuffers(1, &vbo);
+    glDeleteVertexArrays(1, &vao);
+    return us;
+}
+
+// Estimated cost of each of CHUNK_SIZES that keeps the reach: startup
+// generation (a few chunks near the camera timed, scaled by the octave LOD of
+// every chunk within the render distance) and the terrain draw calls of a
+// frame from the start position, as many as the render loop would issue
+// (CDLOD node selections over flat nodes when CDLOD is on).
+static std::vector<ChunkSizeCost> chunk_size_costs(double drawCallUs) {
+    const int savedSize = chunkWidth;
+    const glm::vec3 savedCamera = camera.Position;
+    std::vector<ChunkSizeCost> costs;
+    GridChunkBuffers buffers;
+    std::vector<float> verts;
+    std::vector<plant> plants;
+    std::vector<CdlodDraw> draws;
+    for (int size : CHUNK_SIZES) {
+        if (!chunk_size_keeps_reach(size)) continue;
+        set_chunk_size(size);
+        const int distance = terrain_render_distance();
+        const std::vector<glm::ivec2> chunks = chunks_around_camera(distance);
+        ChunkSizeCost cost = { size, (int)chunks.size(), 0, 0.0, 0.0 };
+
+        // as many samples as four default chunks, so the small sizes are not timed on a single chunk
+        const int samples = std::max(1, 4 * 129 * 129 / (size * size));
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < samples; i++) {
+            plants.clear();
+            build_grid_chunk(gridPosX + i % 4, gridPosY + i / 4 % 4, octaves, buffers, verts, plants);
+        }
+        double chunkMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count() / samples;
+        double octaveChunks = 0.0;
+        for (const glm::ivec2 &c : chunks) octaveChunks += (double)chunk_lod_octaves(c.x, c.y) / octaves;
+        cost.generateMs = chunkMs * octaveChunks;
+
+        const bool cdlod = cdlodTerrain && !volumeTerrain && rtinMaxError <= 0.0f;
+        const std::vector<float> flatBounds(2 * cdlod_node_index(-1, 0, 0, cdlod_levels()), 0.0f);
+        for (const glm::ivec2 &c : chunks) {
+            if (!cdlod) { cost.draws++; continue; }
+            glm::vec3 chunkOrigin(-chunkWidth / 2.0f + (chunkWidth - 1) * c.x, 0.0f, -chunkHeight / 2.0f + (chunkHeight - 1) * c.y);
+            draws.clear();
+            cdlod_select(flatBounds, camera.Position - chunkOrigin, draws);
+            cost.draws += (int)draws.size();
+        }
+        cost.drawMs = cost.draws * drawCallUs / 1000.0;
+        costs.push_back(cost);
+    }
+    set_chunk_size(savedSize);
+    camera.Position = savedCamera;
+    update_camera_chunk();
+    return costs;
+}
+
+int tune_chunk_size(double drawCallUs) {
+    std::vector<ChunkSizeCost> costs = chunk_size_costs(drawCallUs);
+    for (int size : CHUNK_SIZES)
+        if (!chunk_size_keeps_reach(size))
+            std::cout << "[TUNE] chunk " << size << ": skipped, " << RENDER_QUADS << " / " << LOD_RENDER_QUADS
+                      << " quads are not whole chunks" << std::endl;
+    int best = 0;
+    for (int i = 0; i < (int)costs.size(); i++) {
+        const ChunkSizeCost &c = costs[i];
+        std::cout << "[TUNE] chunk " << c.size << ": " << c.chunks << " chunks, generate " << c.generateMs << " ms, "
+                  << c.draws << " draws/frame (" << c.drawMs << " ms), total " << c.total() << " ms over "
+                  << chunkTuneFrames << " frames" << std::endl;
+        if (c.total() < costs[best].total()) best = i;
+    }
+    std::cout << "[TUNE] " << drawCallUs << " us per draw call; chunk size " << costs[best].size << std::endl;
+    return costs[best].size;
+}
+
+// Chunk-local box the packed unorm16 coordinates span: volume chunks reach one
+// volumeStep past the grid, and heights stop at the 1.5 meshHeight biome ceiling.
+static glm::vec3 terrain_pack_extent() {
+    return glm::vec3(chunkWidth - 1 + volumeStep, 1.5f * meshHeight + volumeStep, chunkHeight - 1 + volumeStep);
+}
+
+static inline uint16_t pack_unorm16(float v, float extent) {
+    return (uint16_t)std::lround(std::fmax(0.0f, std::fmin(v / extent, 1.0f)) * 65535.0f);
+}
+
+// Octahedral map about +y, where terrain normals cluster; e in [-1, 1]^2. Same as oct_decode() in the shader.
+static inline glm::vec3 oct_decode(glm::vec2 e) {
+    glm::vec3 n(e.x, 1.0f - std::fabs(e.x) - std::fabs(e.y), e.y);
+    if (n.y < 0.0f) {
+        float x = (1.0f - std::fabs(n.z)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+        float z = (1.0f - std::fabs(n.x)) * (n.z >= 0.0f ? 1.0f : -1.0f);
+        n.x = x;
+        n.z = z;
+    }
+    return glm::normalize(n);
+}
+
+// Unit normal -> two bytes (within 1 degree of n).
+static inline void oct_encode(const glm::vec3 &n, int8_t out[2]) {
+    float s = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    if (s == 0.0f) {
+        out[0] = out[1] = 0;    // degenerate (flat density), decodes to up
+        return;
+    }
+    glm::vec2 e(n.x / s, n.z / s);
+    if (n.y < 0.0f)
+        e = glm::vec2((1.0f - std::fabs(e.y)) * (e.x >= 0.0f ? 1.0f : -1.0f),
+                      (1.0f - std::fabs(e.x)) * (e.y >= 0.0f ? 1.0f : -1.0f));
+    out[0] = (int8_t)std::lround(glm::clamp(e.x, -1.0f, 1.0f) * 127.0f);
+    out[1] = (int8_t)std::lround(glm::clamp(e.y, -1.0f, 1.0f) * 127.0f);
+}
+
+static inline void pack_color(const float *color, uint8_t rgba[4]) {
+    for (int c = 0; c < 3; c++) rgba[c] = (uint8_t)std::lround(std::fmax(0.0f, std::fmin(color[c], 1.0f)) * 255.0f);
+    rgba[3] = 255;
+}
+
+static std::vector<uint8_t> pack_colors(const std::vector<float> &colors) {
+    std::vector<uint8_t> rgba(colors.size() / 3 * 4);
+    for (size_t v = 0; v < colors.size() / 3; v++) pack_color(&colors[3 * v], &rgba[4 * v]);
+    return rgba;
+}
+
+static std::vector<PackedVolumeVertex> pack_volume_vertices(const SurfaceMesh &mesh) {
+    const glm::vec3 extent = terrain_pack_extent();
+    std::vector<PackedVolumeVertex> packed(mesh.positions.size() / 3);
+    for (size_t i = 0; i < packed.size(); i++) {
+        for (int c = 0; c < 3; c++) packed[i].pos[c] = pack_unorm16(mesh.positions[3 * i + c], extent[c]);
+        oct_encode(glm::make_vec3(&mesh.normals[3 * i]), packed[i].normal);
+    }
+    return packed;
+}
+
+// Uploads one chunk's mesh, packed, and records its GL buffers (and indices)
+// under pos. A slot that already has them (streaming recycles slots) keeps its
+// VAO, buffers and texture buffers and only re-specifies their data.
+// indices == nullptr is a grid chunk: x / z are implied by the vertex index
+// and it draws with the shared grid index buffer.
+static void upload_map_chunk(GLuint &VAO, int pos, TerrainVertexFormat format, const void *vertices,
+                             size_t nVertices, const uint8_t *rgba, const std::vector<int> *indices) {
+    const bool slot = pos >= 0 && pos < (int)g_mapVertexVBO.size();
+    GLuint VBOvtx = slot ? g_mapVertexVBO[pos] : 0, VBOcol = slot ? g_mapColorVBO[pos] : 0;
+    GLuint EBO = slot ? g_mapEBO[pos] : 0;
+    if (!VBOvtx) glGenBuffers(1, &VBOvtx);
+    if (!VBOcol) glGenBuffers(1, &VBOcol);
+    if (!VAO) glGenVertexArrays(1, &VAO);
+
+    glBindVertexArray(VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBOvtx);
+    if (format == PACKED_VOLUME) {
+        glBufferData(GL_ARRAY_BUFFER, nVertices * sizeof(PackedVolumeVertex), vertices, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVolumeVertex),
+                              (void*)offsetof(PackedVolumeVertex, pos));
+        glVertexAttribPointer(1, 2, GL_BYTE, GL_FALSE, sizeof(PackedVolumeVertex),
+                              (void*)offsetof(PackedVolumeVertex, normal));
+    } else {
+        glBufferData(GL_ARRAY_BUFFER, nVertices * sizeof(PackedGridVertex), vertices, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 1, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedGridVertex),
+                              (void*)offsetof(PackedGridVertex, height));
+        glVertexAttribPointer(1, 2, GL_BYTE, GL_FALSE, sizeof(PackedGridVertex),
+                              (void*)offsetof(PackedGridVertex, normal));
+    }
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBOcol);
+    glBufferData(GL_ARRAY_BUFFER, nVertices * 4, rgba, GL_STATIC_DRAW);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, 4, (void*)0);
+    glEnableVertexAttribArray(2);
+
+    // grid chunks expose both buffers as texture buffers too, for the CDLOD morph to fetch another vertex
+    GLuint heightTex = slot ? g_mapHeightTex[pos] : 0, colorTex = slot ? g_mapColorTex[pos] : 0;
+    if (format == PACKED_GRID) {
+        if (!heightTex) glGenTextures(1, &heightTex);
+        glBindTexture(GL_TEXTURE_BUFFER, heightTex);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RG16, VBOvtx);
+        if (!colorTex) glGenTextures(1, &colorTex);
+        glBindTexture(GL_TEXTURE_BUFFER, colorTex);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA8, VBOcol);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    } else {
+        if (heightTex) glDeleteTextures(1, &heightTex);
+        if (colorTex) glDeleteTextures(1, &colorTex);
+        heightTex = colorTex = 0;
+    }
+
+    GLsizei indexCount;
+    GLenum indexType;
+    if (indices) {
+        if (!EBO) glGenBuffers(1, &EBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices->size() * sizeof(int), indices->data(), GL_STATIC_DRAW);
+        indexCount = (GLsizei)indices->size();
+        indexType = GL_UNSIGNED_INT;
+    } else {
+        if (g_gridEBO == 0) fill_grid_index_buffer();
+        else glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_gridEBO);
+        if (EBO) glDeleteBuffers(1, &EBO);     // the slot's last chunk had its own list
+        EBO = 0;
+        indexCount = g_gridIndexCount;
+        indexType = g_gridIndexType;
+    }
+
+    glBindVertexArray(0);
+
+    if (pos >= 0 && pos < (int)g_mapVertexVBO.size()) g_mapVertexVBO[pos] = VBOvtx;
+    if (pos >= 0 && pos < (int)g_mapColorVBO.size())  g_mapColorVBO[pos] = VBOcol;
+    if (pos >= 0 && pos < (int)g_mapEBO.size())       g_mapEBO[pos] = EBO;
+    if (pos >= 0 && pos < (int)g_mapIndexCount.size()) g_mapIndexCount[pos] = indexCount;
+    if (pos >= 0 && pos < (int)g_mapIndexType.size())  g_mapIndexType[pos] = indexType;
+    if (pos >= 0 && pos < (int)g_mapVertexFormat.size()) g_mapVertexFormat[pos] = format;
+    if (pos >= 0 && pos < (int)g_mapHeightTex.size())  g_mapHeightTex[pos] = heightTex;
+    if (pos >= 0 && pos < (int)g_mapColorTex.size())   g_mapColorTex[pos] = colorTex;
+
+    if (pos >= 0 && pos < (int)g_map_chunks.size())   g_map_chunks[pos] = VAO;
+}
+
+glm::vec3 get_color(int r, int g, int b) {
+    return glm::vec3(r / 255.0f, g / 255.0f, b / 255.0f);
+}
+
+// Coarse domain-warp field of one chunk: the offset added to the sample
+// coordinates and its Jacobian (column i = d(offset)/d(sample axis i)) at
+// every stepX / stepY vertices.
+struct WarpField {
+    int stepX, stepY, nx, ny;
+    std::vector<glm::vec2> offset;
+    std::vector<glm::mat2> jacobian;
+};
+
+// Largest divisor of span not above the requested step, so the coarse grid
+// points land on chunk borders and neighbouring chunks share them (no seams).
+static int warp_step_for(int span, int requested) {
+    for (int step = std::min(std::max(requested, 1), span); step > 1; step--)
+        if (span % step == 0) return step;
+    return 1;
+}
+
+static WarpField build_warp_field(int offsetX, int offsetY, const uint8_t *p, const FbmRuntimeWeights &weights) {
+    WarpField f;
+    f.stepX = warp_step_for(chunkWidth - 1, warpGridStep);
+    f.stepY = warp_step_for(chunkHeight - 1, warpGridStep);
+    f.nx = (chunkWidth - 1) / f.stepX + 1;
+    f.ny = (chunkHeight - 1) / f.stepY + 1;
+    f.offset.resize(f.nx * f.ny);
+    f.jacobian.resize(f.nx * f.ny);
+
+    // two decorrelated fBm fields, the second one shifted in noise space
+    const glm::vec2 shiftB(5.2f, 1.3f);
+    std::vector<float> xsA(f.nx), xsB(f.nx), qa(f.nx), qb(f.nx), da(2 * f.nx), db(2 * f.nx);
+    for (int cx = 0; cx < f.nx; cx++) {
+        xsA[cx] = (cx * f.stepX + offsetX * (chunkWidth - 1)) / noiseScale * warpFrequency;
+        xsB[cx] = xsA[cx] + shiftB.x;
+    }
+    for (int cy = 0; cy < f.ny; cy++) {
+        float ySample = (cy * f.stepY + offsetY * (chunkHeight - 1)) / noiseScale * warpFrequency;
+        fbm_noise_row(noiseBackend, xsA.data(), ySample, qa.data(), da.data(), da.data() + f.nx, f.nx, p,
+                      warpOctaves, weights, noiseSimdLevel);
+        fbm_noise_row(noiseBackend, xsB.data(), ySample + shiftB.y, qb.data(), db.data(), db.data() + f.nx, f.nx, p,
+                      warpOctaves, weights, noiseSimdLevel);
+        for (int cx = 0; cx < f.nx; cx++) {
+            // fBm values sit around 0.5; centre them so the warp has no net drift
+            int i = cx + cy * f.nx;
+            f.offset[i] = warpStrength * glm::vec2(2.0f * qa[cx] - 1.0f, 2.0f * qb[cx] - 1.0f);
+            f.jacobian[i] = 2.0f * warpStrength * warpFrequency * glm::mat2(da[cx], db[cx], da[f.nx + cx], db[f.nx + cx]);
+        }
+    }
+    return f;
+}
+
+// Normalized height after the cubic easing in generate_vertices (what generate_biome bands on).
+static inline float eased_height(float n) {
+    float e = n * 1.1f;
+    return std::fmax(e * e * e, WATER_HEIGHT * 0.5f);
+}
+
+// Bit-reproducible heights: fbm_noise_fixed on integer lattice coordinates, so
+// a vertex shared by two chunks gets the same bits whichever chunk, shard or
+// machine computes it. Slopes are central differences over a one-vertex
+// apron, so seam vertices get the same normal from both sides. This mode is
+// Perlin fBm only (no backend choice, fractal mode, warp or octave LOD).
+static std::vector<float> generate_noise_map_fixed(int offsetX, int offsetY, std::vector<float> *gradients) {
+    const int nSamples = chunkWidth * chunkHeight;
+    const int apronW = chunkWidth + 2, apronH = chunkHeight + 2;
+    const FixedFbmWeights weights(octaves, persistence, lacunarity);
+    const int32_t step = (int32_t)std::lround(FIXED_ONE / noiseScale);   // one grid step in Q16.16
+    const uint8_t *p = g_noiseContext->perm;
+
+    std::vector<int32_t> field(apronW * apronH);
+    for (int y = 0; y < apronH; y++) {
+        int32_t ySample = (y - 1 + offsetY * (chunkHeight - 1)) * step;
+        for (int x = 0; x < apronW; x++)
+            field[x + y * apronW] = fbm_noise_fixed((x - 1 + offsetX * (chunkWidth - 1)) * step, ySample, p, weights);
+    }
+
+    std::vector<int32_t> heights(nSamples);
+    std::vector<float> noiseValues(nSamples);
+    if (gradients) gradients->resize(2 * nSamples);
+    for (int y = 0; y < chunkHeight; y++) {
+        for (int x = 0; x < chunkWidth; x++) {
+            int i = x + y * chunkWidth, a = (x + 1) + (y + 1) * apronW;
+            heights[i] = field[a];
+            noiseValues[i] = field[a] / (float)FIXED_ONE;
+            if (gradients) {
+                (*gradients)[i] = (field[a + 1] - field[a - 1]) / (2.0f * FIXED_ONE);
+                (*gradients)[nSamples + i] = (field[a + apronW] - field[a - apronW]) / (2.0f * FIXED_ONE);
+            }
+        }
+    }
+
+    g_lastContentHash = fixed_content_hash(heights.data(), heights.size());
+    return noiseValues;
+}
+
+// Vertex indices of a chunk's outer ring, shared with its neighbours.
+static std::vector<int> chunk_border_indices() {
+    std::vector<int> border;
+    for (int x = 0; x < chunkWidth; x++) {
+        border.push_back(x);
+        border.push_back(x + (chunkHeight - 1) * chunkWidth);
+    }
+    for (int y = 1; y < chunkHeight - 1; y++) {
+        border.push_back(y * chunkWidth);
+        border.push_back(chunkWidth - 1 + y * chunkWidth);
+    }
+    return border;
+}
+
+// Normalized fBm heights for one chunk. If gradients is given it receives the
+// analytic slope of each value per grid step: chunkWidth * chunkHeight d/dx
+// values followed by as many d/dz values. chunkOctaves (0 = octaves) lowers
+// the octave count of the interior; the border always gets every octave.
+std::vector<float> generate_noise_map(int offsetX, int offsetY, std::vector<float> *gradients, int chunkOctaves) {
+    const int nSamples = chunkWidth * chunkHeight;
+    const int lodOctaves = chunkOctaves > 0 ? std::min(chunkOctaves, octaves) : octaves;
+    if (fixedPointNoise)
+        return generate_noise_map_fixed(offsetX, offsetY, gradients);
+    std::vector<float> noiseValues(nSamples);
+    const uint8_t *p = g_noiseContext->perm;
+
+    // amp / freq / maxPossibleHeight per octave; constant-folded when persistence and lacunarity are the defaults
+    const FbmRuntimeWeights weights(persistence, lacunarity);
+
+    // sample coordinates of every vertex, domain-warped if enabled
+    std::vector<float> xSamples(nSamples), ySamples(nSamples);
+    std::vector<glm::mat2> warpJacobian;
+    for (int y = 0; y < chunkHeight; y++) {
+        for (int x = 0; x < chunkWidth; x++) {
+            xSamples[x + y * chunkWidth] = (x + offsetX * (chunkWidth - 1)) / noiseScale;
+            ySamples[x + y * chunkWidth] = (y + offsetY * (chunkHeight - 1)) / noiseScale;
+        }
+    }
+
+    if (warpStrength != 0.0f) {
+        WarpField warp = build_warp_field(offsetX, offsetY, p, weights);
+        if (gradients) warpJacobian.resize(nSamples);
+
+        for (int y = 0; y < chunkHeight; y++) {
+            int cy = std::min(y / warp.stepY, warp.ny - 2);
+            float ty = (y - cy * warp.stepY) / (float)warp.stepY;
+
+            for (int x = 0; x < chunkWidth; x++) {
+                int cx = std::min(x / warp.stepX, warp.nx - 2);
+                float tx = (x - cx * warp.stepX) / (float)warp.stepX;
+                int i00 = cx + cy * warp.nx, i01 = i00 + warp.nx, i = x + y * chunkWidth;
+
+                glm::vec2 o = glm::mix(glm::mix(warp.offset[i00], warp.offset[i00 + 1], tx),
+                                       glm::mix(warp.offset[i01], warp.offset[i01 + 1], tx), ty);
+                xSamples[i] += o.x;
+                ySamples[i] += o.y;
+                if (gradients)
+                    warpJacobian[i] = (warp.jacobian[i00] * (1.0f - tx) + warp.jacobian[i00 + 1] * tx) * (1.0f - ty) +
+                                      (warp.jacobian[i01] * (1.0f - tx) + warp.jacobian[i01 + 1] * tx) * ty;
+            }
+        }
+    }
+
+    if (gradients) gradients->resize(2 * nSamples);
+    float *dx = gradients ? gradients->data() : nullptr;
+    float *dz = gradients ? dx + nSamples : nullptr;
+
+    // biome thresholds mapped back through the easing into noise space
+    std::vector<float> thresholds;
+    if (fractalMode != FractalMode::FBM) {
+        thresholds = biome_thresholds(gSeason);
+        for (float &t : thresholds) t = std::cbrt(t) / 1.1f;
+    }
+    // a coarse chunk is the full sum with its top octaves dropped, so it keeps the full normalization
+    const float lodScale = weights.max_height(lodOctaves) / weights.max_height(octaves);
+    float stopScale = 1.0f;
+    auto canStop = [&](float lo, float hi) {
+        lo *= stopScale;
+        hi *= stopScale;
+        auto next = std::upper_bound(thresholds.begin(), thresholds.end(), lo);
+        if (next != thresholds.end() && *next <= hi) return false;
+        return eased_height(hi) - eased_height(lo) <= octaveHeightError;
+    };
+    auto evaluate_points = [&](const float *xs, const float *ys, float *out, float *ddx, float *ddz, int n, int oct) {
+        stopScale = oct == lodOctaves ? lodScale : 1.0f;
+        if (fractalMode == FractalMode::FBM)
+            fbm_noise_points(noiseBackend, xs, ys, out, ddx, ddz, n, p, oct, weights, noiseSimdLevel);
+        else
+            g_lastOctavesSkipped += multifractal_noise_points(fractalMode, noiseBackend, xs, ys, out, ddx, ddz, n, p,
+                                                              oct, weights, canStop, noiseSimdLevel);
+    };
+
+    g_lastOctavesSkipped = 0;
+    if (fractalMode == FractalMode::FBM && warpStrength == 0.0f) {
+        for (int y = 0; y < chunkHeight; y++) {
+            int row = y * chunkWidth;
+            fbm_noise_row(noiseBackend, &xSamples[row], ySamples[row], &noiseValues[row],
+                          dx ? dx + row : nullptr, dz ? dz + row : nullptr, chunkWidth, p,
+                          lodOctaves, weights, noiseSimdLevel);
+        }
+    } else {
+        evaluate_points(xSamples.data(), ySamples.data(), noiseValues.data(), dx, dz, nSamples, lodOctaves);
+    }
+    if (lodOctaves < octaves) {
+        for (float &v : noiseValues) v *= lodScale;
+        if (gradients)
+            for (float &g : *gradients) g *= lodScale;
+    }
+
+    // a coarse chunk re-evaluates its border at full detail so both sides of every seam agree
+    if (lodOctaves < octaves) {
+        std::vector<int> border = chunk_border_indices();
+        const int nb = (int)border.size();
+        std::vector<float> bx(nb), by(nb), bv(nb), bdx(nb), bdz(nb);
+        for (int b = 0; b < nb; b++) {
+            bx[b] = xSamples[border[b]];
+            by[b] = ySamples[border[b]];
+        }
+        evaluate_points(bx.data(), by.data(), bv.data(), dx ? bdx.data() : nullptr, dz ? bdz.data() : nullptr,
+                        nb, octaves);
+        for (int b = 0; b < nb; b++) {
+            noiseValues[border[b]] = bv[b];
+            if (dx) dx[border[b]] = bdx[b];
+            if (dz) dz[border[b]] = bdz[b];
+        }
+    }
+
+    // chain rule through the warp: grad n = (I + J)^T grad fbm
+    if (gradients && !warpJacobian.empty()) {
+        for (int i = 0; i < nSamples; i++) {
+            glm::vec2 g = glm::transpose(glm::mat2(1.0f) + warpJacobian[i]) * glm::vec2(dx[i], dz[i]);
+            dx[i] = g.x;
+            dz[i] = g.y;
+        }
+    }
+
+    // the kernel's slopes are per unit of sample coordinate; one grid step is 1 / noiseScale of that
+    if (gradients)
+        for (float &g : *gradients) g /= noiseScale;
+
+    return noiseValues;
+}
+
+// Normalized terrain heights of one chunk (1 = meshHeight), with their slopes
+// per grid step in gradients laid out like generate_noise_map's. Plain fBm
+// runs the terrain preset's noise graph, which computes the final height and
+// slope of each vertex in one fused pass; the other modes take
+// generate_noise_map's values through the classic easing afterwards.
+std::vector<float> generate_height_map(int offsetX, int offsetY, std::vector<float> &gradients, int chunkOctaves) {
+    const int nSamples = chunkWidth * chunkHeight;
+    std::vector<float> heights;
+
+    if (fractalMode != FractalMode::FBM || warpStrength != 0.0f || fixedPointNoise) {
+        heights = generate_noise_map(offsetX, offsetY, &gradients, chunkOctaves);
+        for (int i = 0; i < nSamples; i++) {
+            float e = heights[i] * 1.1f;
+            float slope = e * e * e < WATER_HEIGHT * 0.5f ? 0.0f : 3.0f * e * e * 1.1f;
+            heights[i] = eased_height(heights[i]);
+            gradients[i] *= slope;
+            gradients[nSamples + i] *= slope;
+        }
+        return heights;
+    }
+
+    const int lodOctaves = chunkOctaves > 0 ? std::min(chunkOctaves, octaves) : octaves;
+    const uint8_t *p = g_noiseContext->perm;
+    const FbmRuntimeWeights weights(persistence, lacunarity);
+    TerrainGraphParams graph = { lodOctaves, weights.amps, weights.freqs, 1.0f / weights.max_height(octaves),
+                                 WATER_HEIGHT * 0.5f, 0.6f };
+    heights.resize(nSamples);
+    gradients.resize(2 * nSamples);
+    float *dx = gradients.data(), *dz = dx + nSamples;
+
+    std::vector<float> xSamples(chunkWidth);
+    for (int x = 0; x < chunkWidth; x++) xSamples[x] = (x + offsetX * (chunkWidth - 1)) / noiseScale;
+    for (int y = 0; y < chunkHeight; y++) {
+        int row = y * chunkWidth;
+        float ySample = (y + offsetY * (chunkHeight - 1)) / noiseScale;
+        terrain_graph_lanes(terrainPreset, noiseBackend, xSamples.data(), &ySample, 0, &heights[row],
+                            dx + row, dz + row, chunkWidth, p, graph, noiseSimdLevel);
+    }
+
+    // octave LOD: full detail on the border, as in generate_noise_map
+    if (lodOctaves < octaves) {
+        std::vector<int> border = chunk_border_indices();
+        const int nb = (int)border.size();
+        std::vector<float> bx(nb), by(nb), bh(nb), bdx(nb), bdz(nb);
+        for (int b = 0; b < nb; b++) {
+            bx[b] = (border[b] % chunkWidth + offsetX * (chunkWidth - 1)) / noiseScale;
+            by[b] = (border[b] / chunkWidth + offsetY * (chunkHeight - 1)) / noiseScale;
+        }
+        graph.octaves = octaves;
+        terrain_graph_lanes(terrainPreset, noiseBackend, bx.data(), by.data(), 1, bh.data(), bdx.data(), bdz.data(),
+                            nb, p, graph, noiseSimdLevel);
+        for (int b = 0; b < nb; b++) {
+            heights[border[b]] = bh[b];
+            dx[border[b]] = bdx[b];
+            dz[border[b]] = bdz[b];
+        }
+    }
+
+    for (float &g : gradients) g /= noiseScale;
+    g_lastOctavesSkipped = 0;
+    return heights;
+}
+
+static inline glm::vec3 lerp3(const glm::vec3& a, const glm::vec3& b, float t) {
+    t = std::fmax(0.0f, std::fmin(1.0f, t));
+    return a * (1.0f - t) + b * t;
+}
+
+float get_terrain_height_at(float worldX, float worldZ, const std::vector<float>& vertices,
+                            int chunkWidth_, int chunkHeight_) {
+    int gridX = (int)worldX;
+    int gridZ = (int)worldZ;
+
+    gridX = std::max(0, std::min(gridX, chunkWidth_ - 2));
+    gridZ = std::max(0, std::min(gridZ, chunkHeight_ - 2));
+
+    float fracX = worldX - (float)gridX;
+    float fracZ = worldZ - (float)gridZ;
+
+    fracX = std::max(0.0f, std::min(1.0f, fracX));
+    fracZ = std::max(0.0f, std::min(1.0f, fracZ));
+
+    int idx00 = (gridX + gridZ * chunkWidth_) * 3;
+    int idx10 = ((gridX + 1) + gridZ * chunkWidth_) * 3;
+    int idx01 = (gridX + (gridZ + 1) * chunkWidth_) * 3;
+    int idx11 = ((gridX + 1) + (gridZ + 1) * chunkWidth_) * 3;
+
+    float h00 = vertices[idx00 + 1];
+    float h10 = vertices[idx10 + 1];
+    float h01 = vertices[idx01 + 1];
+    float h11 = vertices[idx11 + 1];
+
+    float h0 = h00 * (1.0f - fracX) + h10 * fracX;
+    float h1 = h01 * (1.0f - fracX) + h11 * fracX;
+    float height = h0 * (1.0f - fracZ) + h1 * fracZ;
+
+    return height;
+}
+
+static inline float compute_plant_ground_height(
+    float plantX, float plantZ,
+    const std::vector<float>& vertices,
+    int chunkWidth_, int chunkHeight_)
+{
+    float sampleRadius = 0.2f;
+    float lift = 0.01f;
+
+    float minH = get_terrain_height_at(plantX, plantZ, vertices, chunkWidth_, chunkHeight_);
+
+    minH = std::min(minH, get_terrain_height_at(plantX + sampleRadius, plantZ, vertices, chunkWidth_, chunkHeight_));
+    minH = std::min(minH, get_terrain_height_at(plantX - sampleRadius, plantZ, vertices, chunkWidth_, chunkHeight_));
+    minH = std::min(minH, get_terrain_height_at(plantX, plantZ + sampleRadius, vertices, chunkWidth_, chunkHeight_));
+    minH = std::min(minH, get_terrain_height_at(plantX, plantZ - sampleRadius, vertices, chunkWidth_, chunkHeight_));
+
+    return minH + lift;
+}
+
+// Height bands of generate_biome for a season: band heights are normalized
+// (world height / meshHeight), colours before the humidity tweaks.
+std::vector<terrainColor> biome_bands(Season season, float &snowLineHeight) {
+    std::vector<terrainColor> biomeColors;
+
+    biomeColors.push_back(terrainColor(WATER_HEIGHT * 0.5f, get_color(60, 95, 190)));
+    biomeColors.push_back(terrainColor(WATER_HEIGHT, get_color(60, 100, 190)));
+    biomeColors.push_back(terrainColor(0.15f, get_color(210, 215, 130)));
+    biomeColors.push_back(terrainColor(0.30f, get_color(95, 165, 30)));
+    biomeColors.push_back(terrainColor(0.40f, get_color(65, 115, 20)));
+    biomeColors.push_back(terrainColor(0.55f, get_color(90, 65, 60)));
+    biomeColors.push_back(terrainColor(0.75f, get_color(75, 60, 55)));
+    biomeColors.push_back(terrainColor(2.00f, get_color(70, 55, 50)));
+
+    snowLineHeight = 0.0f;
+
+    switch (season) {
+    case Season::SPRING:
+        biomeColors[3].color *= 1.2f;
+        biomeColors[4].color *= 1.1f;
+        snowLineHeight = 0.0f;
+        break;
+
+    case Season::SUMMER:
+        biomeColors[3].color *= 1.1f;
+        snowLineHeight = 0.0f;
+        break;
+
+    case Season::AUTUMN:
+        biomeColors[3].color = get_color(190, 150, 60);
+        biomeColors[4].color = get_color(160, 110, 50);
+        snowLineHeight = 0.70f;
+        biomeColors[6].height = 0.70f;
+        biomeColors[7].height = 0.75f;
+        biomeColors[7].color = get_color(95, 80, 75);
+        biomeColors.push_back(terrainColor(0.80f, get_color(160, 170, 180)));
+        biomeColors.push_back(terrainColor(0.90f, get_color(210, 220, 230)));
+        biomeColors.push_back(terrainColor(2.00f, get_color(240, 245, 250)));
+        break;
+
+    case Season::WINTER:
+        snowLineHeight = 0.45f;
+        biomeColors[5].height = 0.45f;
+        biomeColors[6].height = 0.50f;
+        biomeColors[7].height = 0.55f;
+        biomeColors[6].color = get_color(120, 125, 135);
+        biomeColors[7].color = get_color(180, 190, 200);
+        biomeColors.push_back(terrainColor(0.60f, get_color(210, 220, 230)));
+        biomeColors.push_back(terrainColor(0.70f, get_color(230, 235, 242)));
+        biomeColors.push_back(terrainColor(0.85f, get_color(245, 248, 252)));
+        biomeColors.push_back(terrainColor(2.00f, get_color(252, 254, 255)));
+        break;
+    }
+    return biomeColors;
+}
+
+// Normalized heights at which generate_biome changes its decision for a
+// vertex: band edges, the plant spawn range and the snow line. Sorted.
+std::vector<float> biome_thresholds(Season season) {
+    float snowLineHeight;
+    std::vector<float> thresholds;
+    for (const terrainColor &band : biome_bands(season, snowLineHeight)) thresholds.push_back(band.height);
+    thresholds.push_back(0.25f);
+    thresholds.push_back(0.45f);
+    if (snowLineHeight > 0.0f) thresholds.push_back(snowLineHeight);
+    std::sort(thresholds.begin(), thresholds.end());
+    return thresholds;
+}
+
+BiomePalette biome_palette(Season season, float humidity) {
+    BiomePalette palette;
+    std::vector<terrainColor> &biomeColors = palette.bands;
+    biomeColors = biome_bands(season, palette.snowLine);
+
+    float plantSpawnBase = 5.0f;
+    float plantSpawnScale = 1.0f + (humidity - 0.5f) * 2.0f;
+    palette.spawnThreshold = plantSpawnBase * plantSpawnScale;
+    if (season == Season::WINTER) {
+        palette.spawnThreshold *= 0.3f;
+    }
+
+    glm::vec3 grassDry = get_color(180, 180, 100);
+    glm::vec3 grassNormal = get_color(95, 165, 30);
+    glm::vec3 grassWet = get_color(50, 140, 40);
+
+    glm::vec3 grass2Dry = get_color(150, 140, 90);
+    glm::vec3 grass2Normal = get_color(65, 115, 20);
+    glm::vec3 grass2Wet = get_color(40, 100, 30);
+
+    if (season != Season::WINTER) {
+        if (humidity < 0.5f) {
+            float t = humidity * 2.0f;
+            biomeColors[3].color = lerp3(grassDry, grassNormal, t);
+            biomeColors[4].color = lerp3(grass2Dry, grass2Normal, t);
+        } else {
+            float t = (humidity - 0.5f) * 2.0f;
+            biomeColors[3].color = lerp3(grassNormal, grassWet, t);
+            biomeColors[4].color = lerp3(grass2Normal, grass2Wet, t);
+        }
+    }
+
+    glm::vec3 sandDry = get_color(230, 225, 140);
+    glm::vec3 sandWet = get_color(190, 195, 110);
+    biomeColors[2].color = lerp3(sandDry, sandWet, humidity);
+
+    if (humidity > 0.6f && season != Season::WINTER) {
+        float wetness = (humidity - 0.6f) * 2.5f;
+        biomeColors[5].color = lerp3(biomeColors[5].color, biomeColors[5].color * 0.85f, wetness);
+        if (biomeColors.size() > 6) {
+            biomeColors[6].color = lerp3(biomeColors[6].color, biomeColors[6].color * 0.85f, wetness);
+        }
+    }
+    return palette;
+}
+
+// Colour of a vertex at normalizedHeight (clamped to [0, 1.5]).
+static inline glm::vec3 biome_color(const BiomePalette &palette, float normalizedHeight) {
+    const std::vector<terrainColor> &biomeColors = palette.bands;
+    int nBands = (int)biomeColors.size();
+
+    int k1 = nBands - 1;
+    for (int k = 0; k < nBands - 1; k++) {
+        if (normalizedHeight < biomeColors[k + 1].height) {
+            k1 = k + 1;
+            break;
+        }
+    }
+    int k0 = std::max(0, k1 - 1);
+
+    float h0 = biomeColors[k0].height;
+    float h1 = biomeColors[k1].height;
+
+    if (h1 - h0 < 0.001f) return biomeColors[k1].color;
+    float t = (normalizedHeight - h0) / (h1 - h0);
+    t = std::fmax(0.0f, std::fmin(1.0f, t));
+    t = t * t * (3.0f - 2.0f * t);
+    return lerp3(biomeColors[k0].color, biomeColors[k1].color, t);
+}
+
+// The plant dice of one chunk: a splitmix64 stream seeded from the world seed
+// and the chunk, so a chunk grows the same plants on whichever thread builds
+// it and however often it is streamed back in.
+struct PlantRng {
+    uint64_t state;
+    PlantRng(int xOffset, int yOffset)
+        : state(worldSeed * 0x9E3779B97F4A7C15ull ^ (uint32_t)xOffset * 0xBF58476D1CE4E5B9ull ^
+                (uint64_t)(uint32_t)yOffset << 32) {}
+    int roll(int n) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return (int)((z ^ (z >> 31)) % (uint64_t)n);
+    }
+};
+
+// First half of the plant pass for the vertex at (x, z): the dice rolls. It
+// makes the same rolls in the same order whether or not place_plant runs
+// right after, so rolling a whole chunk first grows the same plants.
+static inline bool roll_plant(const BiomePalette &palette, float normalizedHeight, float x, float z,
+                              PlantRng &rng, PlantCandidate &out) {
+    bool isSnowRegion = (palette.snowLine > 0.0f && normalizedHeight >= palette.snowLine);
+    if (normalizedHeight < 0.25f || normalizedHeight > 0.45f || isSnowRegion) return false;
+    if (!(rng.roll(1000) < palette.spawnThreshold)) return false;
+
+    out.type = (rng.roll(100) < 70) ? "flower" : "tree";
+    float offsetX_ = (rng.roll(100) - 50) / 100.0f * 0.8f;
+    float offsetZ_ = (rng.roll(100) - 50) / 100.0f * 0.8f;
+    out.x = x + offsetX_;
+    out.z = z + offsetZ_;
+    return true;
+}
+
+// Second half: settles a candidate on the ground of vertices and keeps it
+// unless part of it would stand in water or snow.
+static void place_plant(const PlantCandidate &c, const std::vector<float> &vertices, const BiomePalette &palette,
+                        std::vector<plant> &plants, int xOffset, int yOffset) {
+    float finalHeight = compute_plant_ground_height(c.x, c.z, vertices, chunkWidth, chunkHeight);
+    float normalizedFinal = finalHeight / meshHeight;
+
+    float waterLevel = WATER_HEIGHT * meshHeight;
+    bool isTree = c.type[0] == 't';
+    float footprintRadius = isTree ? 0.8f : 0.35f;
+
+    if (is_underwater_footprint(c.x, c.z, vertices, chunkWidth, chunkHeight, waterLevel, footprintRadius)) return;
+    if (finalHeight <= waterLevel + 1.0f) return;
+    if (normalizedFinal < WATER_HEIGHT + 0.08f) return;
+    if (palette.snowLine > 0.0f && normalizedFinal >= palette.snowLine) return;
+
+    plants.push_back(plant{
+        c.type,
+        c.x,
+        finalHeight,
+        c.z,
+        xOffset, yOffset
+    });
+}
+
+std::vector<float> generate_biome(const std::vector<float> &vertices,
+                                  std::vector<plant> &plants,
+                                  int xOffset, int yOffset,
+                                  Season season,
+                                  Weather weather,
+                                  float humidity,
+                                  bool spawnPlants) {
+    std::vector<float> colors;
+    BiomePalette palette = biome_palette(season, humidity);
+    PlantCandidate candidate;
+    PlantRng rng(xOffset, yOffset);
+
+    for (int i = 1; i < (int)vertices.size(); i += 3) {
+        float worldHeight = vertices[i];
+        float normalizedHeight = worldHeight / meshHeight;
+
+        normalizedHeight = std::fmax(0.0f, std::fmin(normalizedHeight, 1.5f));
+        glm::vec3 color = biome_color(palette, normalizedHeight);
+
+        if (spawnPlants && roll_plant(palette, normalizedHeight, vertices[i - 1], vertices[i + 1], rng, candidate)) {
+            place_plant(candidate, vertices, palette, plants, xOffset, yOffset);
+        }
+
+        colors.push_back(color.r);
+        colors.push_back(color.g);
+        colors.push_back(color.b);
+    }
+
+    return colors;
+}
+
+// Height and up-facing normal of one vertex from its noise value and noise
+// slope, following the easing (1.1 n, cubed) through the chain rule. Vertices clamped
+// to the water plane are flat.
+static inline float eased_vertex(float n, float dndx, float dndz, glm::vec3 &normal) {
+    float e = n * 1.1f;
+    float easedNoise = e * e * e;
+    float floorHeight = WATER_HEIGHT * 0.5f * meshHeight;
+    if (easedNoise * meshHeight < floorHeight) {
+        normal = glm::vec3(0.0f, 1.0f, 0.0f);
+        return floorHeight;
+    }
+    float dHdn = 3.0f * e * e * 1.1f * meshHeight;
+    normal = glm::normalize(glm::vec3(-dHdn * dndx, 1.0f, -dHdn * dndz));
+    return easedNoise * meshHeight;
+}
+
+// Vertices from generate_height_map's already shaped heights, with normals
+// taken from its slopes in the same pass (no triangle walk over the index buffer).
+std::vector<float> generate_vertices(const std::vector<float> &heights, const std::vector<float> &gradients,
+                                     std::vector<float> &normals) {
+    const int nSamples = chunkWidth * chunkHeight;
+    std::vector<float> v(3 * nSamples);
+    normals.resize(3 * nSamples);
+
+    for (int y = 0; y < chunkHeight; y++) {
+        for (int x = 0; x < chunkWidth; x++) {
+            int i = x + y * chunkWidth;
+            glm::vec3 n = glm::normalize(glm::vec3(-meshHeight * gradients[i], 1.0f,
+                                                   -meshHeight * gradients[nSamples + i]));
+            v[i*3+0] = (float)x;
+            v[i*3+1] = heights[i] * meshHeight;
+            v[i*3+2] = (float)y;
+            normals[i*3+0] = n.x;
+            normals[i*3+1] = n.y;
+            normals[i*3+2] = n.z;
+        }
+    }
+    return v;
+}
+
+// One pass over a height-map chunk that writes everything a chunk worker
+// hands to the GL thread: world-space vertices (what get_terrain_height_at reads),
+// packed vertices, RGBA8 colours and plants, the same as generate_height_map,
+// generate_vertices, generate_biome and the packing in turn. Plain fBm runs
+// the noise graph one row at a time into scratch that stays in L1 and shades
+// the row before moving on; the other modes take generate_height_map's arrays.
+// Plant candidates are rolled during the pass and placed after it, once the
+// rows they sample exist.
+void build_grid_chunk(int xOffset, int yOffset, int lodOctaves, GridChunkBuffers &out,
+                      std::vector<float> &worldVerts, std::vector<plant> &plants) {
+    const int nSamples = chunkWidth * chunkHeight;
+    const float heightExtent = terrain_pack_extent().y;
+    lodOctaves = lodOctaves > 0 ? std::min(lodOctaves, octaves) : octaves;
+    worldVerts.resize(3 * nSamples);
+    out.vertices.resize(nSamples);
+    out.colors.resize(4 * nSamples);
+    out.candidates.clear();
+    PlantRng rng(xOffset, yOffset);
+    if (out.palette.bands.empty() || out.paletteSeason != gSeason || out.paletteHumidity != gHumidity) {
+        out.palette = biome_palette(gSeason, gHumidity);
+        out.paletteSeason = gSeason;
+        out.paletteHumidity = gHumidity;
+    }
+
+    const bool fusedNoise = fractalMode == FractalMode::FBM && warpStrength == 0.0f && !fixedPointNoise;
+    const uint8_t *p = g_noiseContext->perm;
+    const FbmRuntimeWeights weights(persistence, lacunarity);
+    TerrainGraphParams graph = { lodOctaves, weights.amps, weights.freqs, 1.0f / weights.max_height(octaves),
+                                 WATER_HEIGHT * 0.5f, 0.6f };
+    if (fusedNoise) {
+        out.xSamples.resize(chunkWidth);
+        out.rowHeight.resize(chunkWidth);
+        out.rowDx.resize(chunkWidth);
+        out.rowDz.resize(chunkWidth);
+        for (int x = 0; x < chunkWidth; x++) out.xSamples[x] = (x + xOffset * (chunkWidth - 1)) / noiseScale;
+        g_lastOctavesSkipped = 0;
+    } else {
+        out.heights = generate_height_map(xOffset, yOffset, out.gradients, lodOctaves);
+    }
+
+    for (int y = 0; y < chunkHeight; y++) {
+        const int row = y * chunkWidth;
+        const float *h, *dx, *dz;
+        if (fusedNoise) {
+            float ySample = (y + yOffset * (chunkHeight - 1)) / noiseScale;
+            // octave LOD: full detail on the border, as in generate_height_map
+            bool borderRow = y == 0 || y == chunkHeight - 1;
+            graph.octaves = borderRow ? octaves : lodOctaves;
+            terrain_graph_lanes(terrainPreset, noiseBackend, out.xSamples.data(), &ySample, 0, out.rowHeight.data(),
+                                out.rowDx.data(), out.rowDz.data(), chunkWidth, p, graph, noiseSimdLevel);
+            if (!borderRow && lodOctaves < octaves) {
+                const int last = chunkWidth - 1;
+                float ex[2] = { out.xSamples[0], out.xSamples[last] }, eh[2], edx[2], edz[2];
+                graph.octaves = octaves;
+                terrain_graph_lanes(terrainPreset, noiseBackend, ex, &ySample, 0, eh, edx, edz, 2, p, graph,
+                                    noiseSimdLevel);
+                out.rowHeight[0] = eh[0];    out.rowDx[0] = edx[0];    out.rowDz[0] = edz[0];
+                out.rowHeight[last] = eh[1]; out.rowDx[last] = edx[1]; out.rowDz[last] = edz[1];
+            }
+            for (int x = 0; x < chunkWidth; x++) {
+                out.rowDx[x] /= noiseScale;
+                out.rowDz[x] /= noiseScale;
+            }
+            h = out.rowHeight.data();
+            dx = out.rowDx.data();
+            dz = out.rowDz.data();
+        } else {
+            h = &out.heights[row];
+            dx = &out.gradients[row];
+            dz = &out.gradients[nSamples + row];
+        }
+
+        for (int x = 0; x < chunkWidth; x++) {
+            const int i = row + x;
+            const float height = h[x] * meshHeight;
+            glm::vec3 n = glm::normalize(glm::vec3(-meshHeight * dx[x], 1.0f, -meshHeight * dz[x]));
+            worldVerts[3 * i + 0] = (float)x;
+            worldVerts[3 * i + 1] = height;
+            worldVerts[3 * i + 2] = (float)y;
+
+            out.vertices[i].height = pack_unorm16(height, heightExtent);
+            oct_encode(n, out.vertices[i].normal);
+
+            float normalizedHeight = std::fmax(0.0f, std::fmin(height / meshHeight, 1.5f));
+            glm::vec3 color = biome_color(out.palette, normalizedHeight);
+            pack_color(&color.x, &out.colors[4 * i]);
+
+            PlantCandidate candidate;
+            if (roll_plant(out.palette, normalizedHeight, (float)x, (float)y, rng, candidate))
+                out.candidates.push_back(candidate);
+        }
+    }
+
+    for (const PlantCandidate &candidate : out.candidates)
+        place_plant(candidate, worldVerts, out.palette, plants, xOffset, yOffset);
+}
+
+std::vector<int> generate_indices(IndexOrder order) {
+    std::vector<int> indices;
+
+    if (order == IndexOrder::ROW_MAJOR) {
+        for (int y = 0; y < chunkHeight; y++) {
+            for (int x = 0; x < chunkWidth; x++) {
+                int pos = x + y * chunkWidth;
+
+                if (x == chunkWidth - 1 || y == chunkHeight - 1) {
+                    continue;
+                } else {
+                    indices.push_back(pos + chunkWidth);
+                    indices.push_back(pos);
+                    indices.push_back(pos + chunkWidth + 1);
+
+                    indices.push_back(pos + 1);
+                    indices.push_back(pos + 1 + chunkWidth);
+                    indices.push_back(pos);
+                }
+            }
+        }
+        return indices;
+    }
+
+    // the same two triangles per quad as above; a strip row runs
+    // (x, y+1), (x, y), (x+1, y+1), (x+1, y), ..., which makes the same
+    // triangles with the same winding
+    auto quad = [&](int x, int y) {
+        int pos = x + y * chunkWidth;
+        indices.insert(indices.end(), { pos + chunkWidth, pos, pos + chunkWidth + 1,
+                                        pos + 1, pos + 1 + chunkWidth, pos });
+    };
+    for (int x0 = 0; x0 < chunkWidth - 1; x0 += INDEX_BLOCK_WIDTH) {
+        int x1 = std::min(x0 + INDEX_BLOCK_WIDTH, chunkWidth - 1);
+        for (int y = 0; y < chunkHeight - 1; y++) {
+            if (order == IndexOrder::STRIPS) {
+                for (int x = x0; x <= x1; x++) {
+                    indices.push_back(x + (y + 1) * chunkWidth);
+                    indices.push_back(x + y * chunkWidth);
+                }
+                indices.push_back(PRIMITIVE_RESTART);
+            } else if (y % 2 == 0) {
+                for (int x = x0; x < x1; x++) quad(x, y);
+            } else {
+                for (int x = x1 - 1; x >= x0; x--) quad(x, y);
+            }
+        }
+    }
+    return indices;
+}
+
+// Density of one chunk (> 0 is solid) for surface_nets, sampled every
+// volumeStep units from the ground up to 1.5 meshHeight. The grid runs one
+// cell past the chunk's +x / +z edges onto samples the neighbour computes
+// bit for bit, so the two meshes meet. Thread-safe: it only reads settings.
+static void build_density_field(int offsetX, int offsetY, std::vector<float> &density, int &nx, int &ny, int &nz,
+                                SimdLevel level) {
+    nx = (chunkWidth - 1) / volumeStep + 2;
+    nz = (chunkHeight - 1) / volumeStep + 2;
+    ny = (int)std::ceil(1.5f * meshHeight / volumeStep) + 1;
+    density.resize((size_t)nx * ny * nz);
+    const uint8_t *p = g_noiseContext->perm;
+    const FbmRuntimeWeights weights(persistence, lacunarity);
+
+    // classic eased height of every column
+    std::vector<float> xs(nx), caveXs(nx), heights((size_t)nx * nz), cave(nx);
+    for (int x = 0; x < nx; x++) {
+        xs[x] = (x * volumeStep + offsetX * (chunkWidth - 1)) / noiseScale;
+        caveXs[x] = xs[x] * caveFrequency;
+    }
+    for (int z = 0; z < nz; z++) {
+        float zs = (z * volumeStep + offsetY * (chunkHeight - 1)) / noiseScale;
+        float *row = &heights[(size_t)z * nx];
+        fbm_noise_row(noiseBackend, xs.data(), zs, row, nullptr, nullptr, nx, p, octaves, weights, level);
+        for (int x = 0; x < nx; x++) row[x] = eased_height(row[x]);
+    }
+
+    for (int y = 0; y < ny; y++) {
+        float altitude = y * volumeStep / meshHeight;
+        float ys = y * volumeStep / noiseScale * caveFrequency;
+        for (int z = 0; z < nz; z++) {
+            float zs = (z * volumeStep + offsetY * (chunkHeight - 1)) / noiseScale * caveFrequency;
+            fbm3_noise_row(caveXs.data(), ys, zs, cave.data(), nx, p, caveOctaves, weights, level);
+            float *out = &density[(size_t)nx * (z + nz * y)];
+            const float *h = &heights[(size_t)z * nx];
+            for (int x = 0; x < nx; x++) out[x] = h[x] - altitude + caveStrength * (2.0f * cave[x] - 1.0f);
+            // closed floor and open sky, so the surface never leaves the grid vertically
+            if (y == 0)      for (int x = 0; x < nx; x++) out[x] = std::fmax(out[x], 1e-3f);
+            if (y == ny - 1) for (int x = 0; x < nx; x++) out[x] = std::fmin(out[x], -1e-3f);
+        }
+    }
+}
+
+static void generate_volume_chunk(int offsetX, int offsetY, VolumeChunk &out, SimdLevel level) {
+    std::vector<float> density;
+    int nx, ny, nz;
+    auto t0 = std::chrono::steady_clock::now();
+    build_density_field(offsetX, offsetY, density, nx, ny, nz, level);
+    auto t1 = std::chrono::steady_clock::now();
+    surface_nets(density.data(), nx, ny, nz, (float)volumeStep, out.mesh, level);
+    auto t2 = std::chrono::steady_clock::now();
+    out.densityMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    out.meshMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+}
+
+// Everything of one chunk that needs no GL, on a worker thread. Volume chunks
+// are coloured without plants, as generate_biome does for them.
+static void build_chunk_payload(ChunkPayload &out) {
+    const ChunkJob &job = out.job;
+    const int x = job.chunk.x, y = job.chunk.y;
+    out.plants.clear();
+    out.indices.clear();
+    out.nodeBounds.clear();
+    if (job.volume) {
+        VolumeChunk volume;
+        generate_volume_chunk(x, y, volume, noiseSimdLevel);
+        std::vector<float> colors = generate_biome(volume.mesh.positions, out.plants, x, y,
+                                                   gSeason, gWeather, gHumidity, false);
+        out.volumeVertices = pack_volume_vertices(volume.mesh);
+        out.volumeColors = pack_colors(colors);
+        out.verts.swap(volume.mesh.positions);
+        out.indices.swap(volume.mesh.indices);
+        return;
+    }
+
+    build_grid_chunk(x, y, job.lodOctaves, out.grid, out.verts, out.plants);
+    out.contentHash = g_lastContentHash;
+    out.octavesSkipped = g_lastOctavesSkipped;
+    cdlod_node_bounds(out.verts, out.nodeBounds);
+    if (job.rtinError > 0.0f) {
+        rtin_errors(g_rtinTile, out.verts.data() + 1, 3, true, out.rtinErrors);
+        rtin_mesh(g_rtinTile, out.rtinErrors, job.rtinError, out.indices);
+    }
+}
+
+static void chunk_worker() {
+    ChunkWorkers &w = g_chunkWorkers;
+    for (;;) {
+        // busy goes up before the pop, so cancel_chunk_jobs never misses a job being taken
+        w.busy++;
+        ChunkJob job;
+        if (w.jobs.try_pop(job)) {
+            w.queued--;
+            ChunkPayload *payload;
+            if (!w.spare.try_pop(payload)) payload = new ChunkPayload;
+            payload->job = job;
+            build_chunk_payload(*payload);
+            // ready has room for every job in flight, so this only waits if the GL thread is mid-pop
+            while (!w.ready.try_push(payload)) std::this_thread::yield();
+            w.busy--;
+            continue;
+        }
+        w.busy--;
+        std::unique_lock<std::mutex> lock(w.mutex);
+        w.wake.wait(lock, [&] { return w.quit.load() || w.queued.load() > 0; });
+        if (w.quit.load()) return;
+    }
+}
+
+void start_chunk_workers(unsigned threads) {
+    g_chunkWorkers.quit = false;
+    for (unsigned t = 0; t < std::max(threads, 1u); t++) g_chunkWorkers.threads.emplace_back(chunk_worker);
+}
+
+void stop_chunk_workers() {
+    ChunkWorkers &w = g_chunkWorkers;
+    {
+        std::lock_guard<std::mutex> lock(w.mutex);
+        w.quit = true;
+    }
+    w.wake.notify_all();
+    for (std::thread &t : w.threads) t.join();
+    w.threads.clear();
+    ChunkJob job;
+    while (w.jobs.try_pop(job)) w.queued--;
+    ChunkPayload *payload;
+    while (w.ready.try_pop(payload)) delete payload;
+    while (w.spare.try_pop(payload)) delete payload;
+    w.inFlight = 0;
+}
+
+// Hands a job to the workers; false when STREAM_JOBS_IN_FLIGHT are already out.
+bool queue_chunk_job(const ChunkJob &job) {
+    ChunkWorkers &w = g_chunkWorkers;
+    if (w.inFlight >= STREAM_JOBS_IN_FLIGHT || !w.jobs.try_push(job)) return false;
+    w.inFlight++;
+    {
+        std::lock_guard<std::mutex> lock(w.mutex);
+        w.queued++;
+    }
+    w.wake.notify_one();
+    return true;
+}
+
+// Queues chunk (x, y) at the octave LOD the camera wants for it, for its slot.
+bool submit_chunk_job(int x, int y) {
+    float rtinError = rtinMaxError > 0.0f && rtin_grid_size_ok(chunkWidth) && chunkWidth == chunkHeight ? rtinMaxError : 0.0f;
+    if (rtinError > 0.0f && g_rtinTile.gridSize != chunkWidth) rtin_build_tile(chunkWidth, g_rtinTile);
+    ChunkJob job = { glm::ivec2(x, y), chunk_lod_octaves(x, y), g_jobEpoch, volumeTerrain, rtinError };
+    if (!queue_chunk_job(job)) return false;
+    g_slotPending[chunk_slot(x, y)] = job.chunk;
+    return true;
+}
+
+// Drops the queued jobs and waits for the workers to finish the ones they are
+// building, so the settings they read can change. What was built before is
+// void (older epoch) and dropped on upload; its chunks are queued again.
+void cancel_chunk_jobs() {
+    ChunkWorkers &w = g_chunkWorkers;
+    ChunkJob job;
+    while (w.jobs.try_pop(job)) {
+        w.queued--;
+        w.inFlight--;
+    }
+    while (w.busy.load() > 0) std::this_thread::yield();
+    g_jobEpoch++;
+    std::fill(g_slotPending.begin(), g_slotPending.end(), NO_CHUNK);
+}
+
+// Moves a built chunk into its slot's GL objects, replacing the chunk (and the
+// plants) the slot held.
+static void upload_chunk_payload(ChunkPayload &c) {
+    const glm::ivec2 chunk = c.job.chunk;
+    const int pos = chunk_slot(chunk.x, chunk.y);
+    const glm::ivec2 evicted = g_slotChunk[pos];
+    g_plants.erase(std::remove_if(g_plants.begin(), g_plants.end(),
+                                  [&](const plant &pl) {
+                                      glm::ivec2 p(pl.xOffset, pl.yOffset);
+                                      return p == evicted || p == chunk;
+                                  }),
+                   g_plants.end());
+    g_plants.insert(g_plants.end(), c.plants.begin(), c.plants.end());
+
+    g_slotChunk[pos] = chunk;
+    g_slotGeneration[pos] = g_worldGeneration;
+    g_slotPending[pos] = NO_CHUNK;
+    g_chunkOctaves[pos] = c.job.lodOctaves;
+    g_chunkVertices[pos].swap(c.verts);
+    g_chunkNodeBounds[pos].swap(c.nodeBounds);
+
+    if (c.job.volume) {
+        upload_map_chunk(g_map_chunks[pos], pos, PACKED_VOLUME, c.volumeVertices.data(), c.volumeVertices.size(),
+                         c.volumeColors.data(), &c.indices);
+    } else {
+        if (fixedPointNoise) {
+            std::cout << "[TERRAIN] chunk (" << chunk.x << "," << chunk.y << ") content hash "
+                      << std::hex << c.contentHash << std::dec << std::endl;
+        } else if (fractalMode != FractalMode::FBM) {
+            long total = (long)chunkWidth * chunkHeight * c.job.lodOctaves;
+            std::cout << "[TERRAIN] chunk (" << chunk.x << "," << chunk.y << ") " << fractal_mode_name(fractalMode)
+                      << ": skipped " << c.octavesSkipped << " of " << total << " octave evaluations ("
+                      << (100.0 * c.octavesSkipped / total) << "%)" << std::endl;
+        }
+        if (!c.indices.empty()) {
+            const long full = 2L * (chunkWidth - 1) * (chunkHeight - 1), n = (long)c.indices.size() / 3;
+            std::cout << "[TERRAIN] chunk (" << chunk.x << "," << chunk.y << ") rtin: " << n << " of " << full
+                      << " triangles (" << (100.0 - 100.0 * n / full) << "% fewer)" << std::endl;
+        }
+        upload_map_chunk(g_map_chunks[pos], pos, PACKED_GRID, c.grid.vertices.data(), c.grid.vertices.size(),
+                         c.grid.colors.data(), c.indices.empty() ? nullptr : &c.indices);
+    }
+    update_chunk_instances(pos);
+}
+
+// Uploads up to STREAM_UPLOADS_PER_FRAME finished chunks, skipping void ones
+// (cancelled, or their slot has since been asked for another chunk).
+void upload_ready_chunks() {
+    ChunkWorkers &w = g_chunkWorkers;
+    ChunkPayload *payload;
+    for (int uploaded = 0; uploaded < STREAM_UPLOADS_PER_FRAME && w.ready.try_pop(payload);) {
+        w.inFlight--;
+        const glm::ivec2 chunk = payload->job.chunk;
+        if (payload->job.epoch == g_jobEpoch && g_slotPending[chunk_slot(chunk.x, chunk.y)] == chunk) {
+            upload_chunk_payload(*payload);
+            uploaded++;
+        }
+        if (!w.spare.try_push(payload)) delete payload;
+    }
+}
+
+// ----------------- GLFW / input -----------------
+int init() {
+    glfwInit();
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+    window = glfwCreateWindow(WIDTH, HEIGHT, "Terrain Generator", nullptr, nullptr);
+    if (window == NULL) {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    glfwMakeContextCurrent(window);
+
+    int screenWidth, screenHeight;
+    glfwGetFramebufferSize(window, &screenWidth, &screenHeight);
+
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    glViewport(0, 0, screenWidth, screenHeight);
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_FRAMEBUFFER_SRGB);
+
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    init_ui_geometry();
+    init_ui_buttons();
+    init_text_renderer();
+
+    g_fontTex = load_texture_2d("assets/font.png");
+    g_textShader = new Shader("shaders/text.vert", "shaders/text.frag");
+    g_textShader->use();
+    g_textShader->setInt("uFont", 0);
+
+    return 0;
+}
+
+void processInput(GLFWwindow *window_, Shader &shader) {
+    if (glfwGetKey(window_, GLFW_KEY_Q) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window_, true);
+
+    if (glfwGetKey(window_, GLFW_KEY_F) == GLFW_PRESS)
+        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+
+    if (glfwGetKey(window_, GLFW_KEY_G) == GLFW_PRESS) {
+        shader.use();
+        shader.setBool("isFlat", false);
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    }
+    if (glfwGetKey(window_, GLFW_KEY_H) == GLFW_PRESS) {
+        shader.use();
+        shader.setBool("isFlat", true);
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    }
+
+    if (glfwGetKey(window_, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window_, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window_, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window_, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    // N: roll a new world seed and regenerate
+    static bool nWasPressed = false;
+    int nState = glfwGetKey(window_, GLFW_KEY_N);
+    if (nState == GLFW_PRESS && !nWasPressed) {
+        cancel_chunk_jobs();
+        worldSeed = (uint32_t)std::random_device{}();
+        g_noiseContext = get_noise_context(worldSeed);
+        std::cout << "[WORLD] seed=" << worldSeed << std::endl;
+        rebuild_world();
+    }
+    nWasPressed = (nState == GLFW_PRESS);
+
+    // M: cycle the noise backend and regenerate
+    static bool mWasPressed = false;
+    int mState = glfwGetKey(window_, GLFW_KEY_M);
+    if (mState == GLFW_PRESS && !mWasPressed) {
+        cancel_chunk_jobs();
+        noiseBackend = (NoiseBackend)(((int)noiseBackend + 1) % NOISE_BACKEND_COUNT);
+        std::cout << "[WORLD] noise=" << noise_backend_name(noiseBackend) << std::endl;
+        rebuild_world();
+    }
+    mWasPressed = (mState == GLFW_PRESS);
+
+    // R: cycle fBm / ridged / hybrid terrain and regenerate
+    static bool rWasPressed = false;
+    int rState = glfwGetKey(window_, GLFW_KEY_R);
+    if (rState == GLFW_PRESS && !rWasPressed) {
+        cancel_chunk_jobs();
+        fractalMode = (FractalMode)(((int)fractalMode + 1) % FRACTAL_MODE_COUNT);
+        std::cout << "[WORLD] fractal=" << fractal_mode_name(fractalMode) << std::endl;
+        rebuild_world();
+    }
+    rWasPressed = (rState == GLFW_PRESS);
+
+    // T: cycle the terrain shaping preset and regenerate
+    static bool tWasPressed = false;
+    int tState = glfwGetKey(window_, GLFW_KEY_T);
+    if (tState == GLFW_PRESS && !tWasPressed) {
+        cancel_chunk_jobs();
+        terrainPreset = (TerrainPreset)(((int)terrainPreset + 1) % TERRAIN_PRESET_COUNT);
+        std::cout << "[WORLD] terrain=" << terrain_preset_name(terrainPreset) << std::endl;
+        rebuild_world();
+    }
+    tWasPressed = (tState == GLFW_PRESS);
+
+    // V: toggle height-field / volume terrain and regenerate
+    static bool vWasPressed = false;
+    int vState = glfwGetKey(window_, GLFW_KEY_V);
+    if (vState == GLFW_PRESS && !vWasPressed) {
+        cancel_chunk_jobs();
+        volumeTerrain = !volumeTerrain;
+        std::cout << "[WORLD] volume=" << (volumeTerrain ? "on" : "off") << std::endl;
+        rebuild_world();
+        applySeasonParams(shader);
+    }
+    vWasPressed = (vState == GLFW_PRESS);
+
+    // L: toggle CDLOD (and its longer view distance) for grid terrain
+    static bool lWasPressed = false;
+    int lState = glfwGetKey(window_, GLFW_KEY_L);
+    if (lState == GLFW_PRESS && !lWasPressed) {
+        cdlodTerrain = !cdlodTerrain;
+        std::cout << "[WORLD] cdlod=" << (cdlodTerrain ? "on" : "off") << ", drawing "
+                  << terrain_render_distance() << " chunks out" << std::endl;
+        applySeasonParams(shader);
+    }
+    lWasPressed = (lState == GLFW_PRESS);
+
+    // K: cycle the RTIN error bound (0 = full grid)
+    static bool kWasPressed = false;
+    int kState = glfwGetKey(window_, GLFW_KEY_K);
+    if (kState == GLFW_PRESS && !kWasPressed && !volumeTerrain) {
+        const int nSteps = sizeof(RTIN_ERROR_STEPS) / sizeof(RTIN_ERROR_STEPS[0]);
+        int step = 0;
+        while (step < nSteps && RTIN_ERROR_STEPS[step] < rtinMaxError) step++;
+        cancel_chunk_jobs();
+        rtinMaxError = RTIN_ERROR_STEPS[(step + 1) % nSteps];
+        std::cout << "[WORLD] rtin error=" << rtinMaxError << std::endl;
+        // the workers re-mesh every chunk; the old meshes stay on screen until then
+        rebuild_world();
+        applySeasonParams(shader);
+    }
+    kWasPressed = (kState == GLFW_PRESS);
+
+    // I: cycle the grid index order (row / blocked / strip); no regeneration needed
+    static bool iWasPressed = false;
+    int iState = glfwGetKey(window_, GLFW_KEY_I);
+    if (iState == GLFW_PRESS && !iWasPressed && g_gridEBO != 0) {
+        indexOrder = (IndexOrder)(((int)indexOrder + 1) % INDEX_ORDER_COUNT);
+        fill_grid_index_buffer();
+    }
+    iWasPressed = (iState == GLFW_PRESS);
+
+    static bool bWasPressed = false;
+    int bState = glfwGetKey(window_, GLFW_KEY_B);
+
+    if (bState == GLFW_PRESS && !bWasPressed) {
+        g_uiMode = !g_uiMode;
+        if (g_uiMode) {
+            glfwSetInputMode(window_, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+        } else {
+            glfwSetInputMode(window_, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+            firstMouse = true;
+        }
+    }
+    bWasPressed = (bState == GLFW_PRESS);
+}
+
+void mouse_callback(GLFWwindow *window_, double xpos, double ypos) {
+    if (g_uiMode) {
+        lastX = (float)xpos;
+        lastY = (float)ypos;
+        return;
+    }
+
+    if (firstMouse) {
+        lastX = (float)xpos;
+        lastY = (float)ypos;
+        firstMouse = false;
+    }
+
+    float xoffset = (float)xpos - lastX;
+    float yoffset = lastY - (float)ypos;
+
+    lastX = (float)xpos;
+    lastY = (float)ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+void scroll_callback(GLFWwindow* window_, double xoffset, double yoffset) {
+    (void)window_; (void)xoffset;
+    camera.ProcessMouseScroll((float)yoffset);
+}
+
+#include "bench.inl"
@@ -0,0 +1,292 @@
+// Terrain noise graph. Included once per SIMD namespace by noise_simd.h, after
+// noise_kernels.inl.
+//
+// A graph is a tree of small node structs (sources, add / mul, curves, clamp,
+// warp, select) built with ordinary operators. Every node evaluates a whole
+// SIMD vector of samples as a dual number: the value plus its d/dx and d/dy.
+// A composed graph is therefore a single nested inline expression, and
+// graph_lanes() runs it as one per-sample loop that writes the final height
+// and slope with no intermediate buffers.
+
+// Value and its partial derivatives with respect to the sample coordinates.
+struct dvf { vf v, dx, dy; };
+
+NOISE_INLINE dvf dconst(float c) { return { splat(c), splat(0.0f), splat(0.0f) }; }
+
+NOISE_INLINE vf min_(vf a, vf b) { return select(lt(b, a), b, a); }
+
+// Node structs mark themselves with graph_node so the operators below only
+// ever apply to graph nodes, never to vf or plain floats.
+template <class T>
+using graph_enable = typename std::enable_if<T::graph_node>::type;
+
+// fBm of a Noise policy: (sum of amp * noise(freq * p) + 1) * invNorm, like
+// fbm_row(), with the frequencies scaled by freqScale and the domain shifted
+// by (shiftX, shiftY) so several sources can be decorrelated.
+template <class Noise>
+struct FbmSource {
+    static constexpr bool graph_node = true;
+    int octaves;
+    const float *amps, *freqs;
+    float invNorm, freqScale, shiftX, shiftY;
+
+    NOISE_INLINE dvf eval(vf x, vf y, const uint8_t *p) const {
+        vf acc = splat(0.0f), dx = splat(0.0f), dy = splat(0.0f);
+        x = x + splat(shiftX);
+        y = y + splat(shiftY);
+        for (int i = 0; i < octaves; i++) {
+            float f = freqs[i] * freqScale;
+            vf ox, oy;
+            acc = acc + Noise::eval_d(x * splat(f), y * splat(f), p, ox, oy) * splat(amps[i]);
+            vf af = splat(amps[i] * f);
+            dx = dx + ox * af;
+            dy = dy + oy * af;
+        }
+        vf s = splat(invNorm);
+        return { (acc + splat(1.0f)) * s, dx * s, dy * s };
+    }
+};
+
+struct ConstNode {
+    static constexpr bool graph_node = true;
+    float c;
+    NOISE_INLINE dvf eval(vf, vf, const uint8_t *) const { return dconst(c); }
+};
+
+template <class A, class B>
+struct AddNode {
+    static constexpr bool graph_node = true;
+    A a;
+    B b;
+    NOISE_INLINE dvf eval(vf x, vf y, const uint8_t *p) const {
+        dvf u = a.eval(x, y, p), v = b.eval(x, y, p);
+        return { u.v + v.v, u.dx + v.dx, u.dy + v.dy };
+    }
+};
+
+template <class A, class B>
+struct MulNode {
+    static constexpr bool graph_node = true;
+    A a;
+    B b;
+    NOISE_INLINE dvf eval(vf x, vf y, const uint8_t *p) const {
+        dvf u = a.eval(x, y, p), v = b.eval(x, y, p);
+        return { u.v * v.v, u.dx * v.v + u.v * v.dx, u.dy * v.v + u.v * v.dy };
+    }
+};
+
+// Curves map a value and return the slope of the map, applied to both derivatives.
+struct CubeCurve {
+    static NOISE_INLINE vf apply(vf v, vf &slope) {
+        slope = splat(3.0f) * v * v;
+        return v * v * v;
+    }
+};
+
+// 1 - |2v - 1|: folds a [0, 1] source into sharp crests at 0.5.
+struct RidgeCurve {
+    static NOISE_INLINE vf apply(vf v, vf &slope) {
+        vf c = v * splat(2.0f) - splat(1.0f);
+        vm below = lt(c, splat(0.0f));
+        slope = select(below, splat(2.0f), splat(-2.0f));
+        return splat(1.0f) - select(below, -c, c);
+    }
+};
+
+template <class A, class Curve>
+struct CurveNode {
+    static constexpr bool graph_node = true;
+    A a;
+    NOISE_INLINE dvf eval(vf x, vf y, const uint8_t *p) const {
+        dvf u = a.eval(x, y, p);
+        vf slope;
+        vf v = Curve::apply(u.v, slope);
+        return { v, u.dx * slope, u.dy * slope };
+    }
+};
+
+// Clamped samples are flat.
+template <class A>
+struct ClampNode {
+    static constexpr bool graph_node = true;
+    A a;
+    float lo, hi;
+    NOISE_INLINE dvf eval(vf x, vf y, const uint8_t *p) const {
+        dvf u = a.eval(x, y, p);
+        vf l = splat(lo), h = splat(hi), zero = splat(0.0f);
+        vm outside = lt(u.v, l) | lt(h, u.v);
+        return { min_(max_(u.v, l), h), select(outside, zero, u.dx), select(outside, zero, u.dy) };
+    }
+};
+
+// src evaluated at (x + ox, y + oy), with the chain rule through the offset fields.
+template <class S, class OX, class OY>
+struct WarpNode {
+    static constexpr bool graph_node = true;
+    S src;
+    OX ox;
+    OY oy;
+    NOISE_INLINE dvf eval(vf x, vf y, const uint8_t *p) const {
+        dvf wx = ox.eval(x, y, p), wy = oy.eval(x, y, p);
+        dvf s = src.eval(x + wx.v, y + wy.v, p);
+        vf one = splat(1.0f);
+        return { s.v,
+                 s.dx * (one + wx.dx) + s.dy * wy.dx,
+                 s.dx * wx.dy + s.dy * (one + wy.dy) };
+    }
+};
+
+// a where c < threshold, b elsewhere (both sides are evaluated; lanes pick one).
+template <class C, class A, class B>
+struct SelectNode {
+    static constexpr bool graph_node = true;
+    C c;
+    A a;
+    B b;
+    float threshold;
+    NOISE_INLINE dvf eval(vf x, vf y, const uint8_t *p) const {
+        vm m = lt(c.eval(x, y, p).v, splat(threshold));
+        dvf u = a.eval(x, y, p), v = b.eval(x, y, p);
+        return { select(m, u.v, v.v), select(m, u.dx, v.dx), select(m, u.dy, v.dy) };
+    }
+};
+
+// An already evaluated value, see share().
+struct BoundNode {
+    static constexpr bool graph_node = true;
+    dvf d;
+    NOISE_INLINE dvf eval(vf, vf, const uint8_t *) const { return d; }
+};
+
+// Evaluates a once and hands it to body(t) as a BoundNode, so a subgraph used
+// several times (a source that is both a select condition and a branch, say)
+// is only computed once per sample.
+template <class A, class Body>
+struct ShareNode {
+    static constexpr bool graph_node = true;
+    A a;
+    Body body;
+    NOISE_INLINE dvf eval(vf x, vf y, const uint8_t *p) const {
+        BoundNode t = { a.eval(x, y, p) };
+        return body(t).eval(x, y, p);
+    }
+};
+
+template <class A, class B, class = graph_enable<A>, class = graph_enable<B>>
+NOISE_INLINE AddNode<A, B> operator+(A a, B b) { return { a, b }; }
+template <class A, class = graph_enable<A>>
+NOISE_INLINE AddNode<A, ConstNode> operator+(A a, float c) { return { a, { c } }; }
+template <class A, class = graph_enable<A>>
+NOISE_INLINE AddNode<A, ConstNode> operator-(A a, float c) { return { a, { -c } }; }
+template <class A, class B, class = graph_enable<A>, class = graph_enable<B>>
+NOISE_INLINE MulNode<A, B> operator*(A a, B b) { return { a, b }; }
+template <class A, class = graph_enable<A>>
+NOISE_INLINE MulNode<A, ConstNode> operator*(A a, float c) { return { a, { c } }; }
+
+template <class Noise>
+NOISE_INLINE FbmSource<Noise> fbm_source(int octaves, const float *amps, const float *freqs, float invNorm,
+                                         float freqScale = 1.0f, float shiftX = 0.0f, float shiftY = 0.0f) {
+    return { octaves, amps, freqs, invNorm, freqScale, shiftX, shiftY };
+}
+template <class A> NOISE_INLINE CurveNode<A, CubeCurve> cube(A a) { return { a }; }
+template <class A> NOISE_INLINE CurveNode<A, RidgeCurve> ridge(A a) { return { a }; }
+template <class A> NOISE_INLINE ClampNode<A> clamp(A a, float lo, float hi) { return { a, lo, hi }; }
+template <class S, class OX, class OY> NOISE_INLINE WarpNode<S, OX, OY> warp(S src, OX ox, OY oy) {
+    return { src, ox, oy };
+}
+template <class A, class Body> NOISE_INLINE ShareNode<A, Body> share(A a, Body body) { return { a, body }; }
+template <class C, class A, class B> NOISE_INLINE SelectNode<C, A, B> select_below(C c, float threshold, A a, B b) {
+    return { c, a, b, threshold };
+}
+
+// The fused loop: out[i] = g(xs[i], ys[i * yStride]) and its slope.
+template <class Graph>
+inline void graph_lanes(const Graph &g, const float *xs, const float *ys, int yStride,
+                        float *out, float *outDx, float *outDy, int n, const uint8_t *p) {
+    int i = 0;
+    for (; i + WIDTH <= n; i += WIDTH) {
+        dvf r = g.eval(load(xs + i), load_y(ys, yStride, i), p);
+        store(out + i, r.v);
+        if (outDx) {
+            store(outDx + i, r.dx);
+            store(outDy + i, r.dy);
+        }
+    }
+
+    if (i < n) {
+        vf x, y;
+        load_tail(xs, ys, yStride, i, n, x, y);
+        dvf r = g.eval(x, y, p);
+        store_tail(out, i, n, r.v);
+        if (outDx) {
+            store_tail(outDx, i, n, r.dx);
+            store_tail(outDy, i, n, r.dy);
+        }
+    }
+}
+
+// ----------------- terrain presets -----------------
+// Each preset is its own graph type, so each compiles to its own fused loop.
+// Output is the normalized terrain height (1 = meshHeight), water clamp included.
+template <class Noise>
+inline void terrain_graph_lanes_for(TerrainPreset preset, const float *xs, const float *ys, int yStride,
+                                    float *out, float *outDx, float *outDy, int n, const uint8_t *p,
+                                    const TerrainGraphParams &gp) {
+    const float UNBOUNDED = 1e30f;
+    auto terrain = fbm_source<Noise>(gp.octaves, gp.amps, gp.freqs, gp.invMaxHeight);
+
+    // low-octave, low-frequency fields for shaping
+    const int detailOctaves = std::min(gp.octaves, 2);
+    const float detailNorm = 1.0f / (gp.amps[0] + (detailOctaves > 1 ? gp.amps[1] : 0.0f));
+    auto fieldA = fbm_source<Noise>(detailOctaves, gp.amps, gp.freqs, detailNorm, 0.5f, 5.2f, 1.3f);
+    auto fieldB = fbm_source<Noise>(detailOctaves, gp.amps, gp.freqs, detailNorm, 0.5f, 1.7f, 9.2f);
+
+    switch (preset) {
+    case TerrainPreset::MESAS: {
+        // the classic curve up to a cliff line, then a nearly flat table top
+        const float edge = 0.62f, top = (edge * 1.1f) * (edge * 1.1f) * (edge * 1.1f);
+        auto g = clamp(share(terrain, [=](BoundNode t) {
+                           return select_below(t, edge, cube(t * 1.1f), (t - edge) * 0.15f + top);
+                       }), gp.waterFloor, UNBOUNDED);
+        graph_lanes(g, xs, ys, yStride, out, outDx, outDy, n, p);
+        return;
+    }
+    case TerrainPreset::RIDGES: {
+        // crests folded out of a broad field, blended into the regular fBm
+        auto g = clamp(cube((terrain * 0.65f + ridge(fieldA) * 0.35f) * 1.1f), gp.waterFloor, UNBOUNDED);
+        graph_lanes(g, xs, ys, yStride, out, outDx, outDy, n, p);
+        return;
+    }
+    case TerrainPreset::WARPED: {
+        // per-sample domain warp by two centred fields
+        auto g = clamp(cube(warp(terrain, (fieldA - 0.5f) * (2.0f * gp.warpStrength),
+                                          (fieldB - 0.5f) * (2.0f * gp.warpStrength)) * 1.1f),
+                       gp.waterFloor, UNBOUNDED);
+        graph_lanes(g, xs, ys, yStride, out, outDx, outDy, n, p);
+        return;
+    }
+    default: {
+        // max((1.1 n)^3, water floor), the shaping generate_vertices always applied
+        auto g = clamp(cube(terrain * 1.1f), gp.waterFloor, UNBOUNDED);
+        graph_lanes(g, xs, ys, yStride, out, outDx, outDy, n, p);
+        return;
+    }
+    }
+}
+
+inline void terrain_graph_lanes(TerrainPreset preset, NoiseBackend backend, const float *xs, const float *ys,
+                                int yStride, float *out, float *outDx, float *outDy, int n, const uint8_t *p,
+                                const TerrainGraphParams &gp) {
+    switch (backend) {
+    case NoiseBackend::PERLIN2D:
+        terrain_graph_lanes_for<Perlin2DNoise>(preset, xs, ys, yStride, out, outDx, outDy, n, p, gp);     return;
+    case NoiseBackend::OPENSIMPLEX2:
+        terrain_graph_lanes_for<OpenSimplex2Noise>(preset, xs, ys, yStride, out, outDx, outDy, n, p, gp); return;
+    case NoiseBackend::VALUE:
+        terrain_graph_lanes_for<ValueNoise>(preset, xs, ys, yStride, out, outDx, outDy, n, p, gp);        return;
+    case NoiseBackend::HASH:
+        terrain_graph_lanes_for<HashNoise>(preset, xs, ys, yStride, out, outDx, outDy, n, p, gp);         return;
+    default:
+        terrain_graph_lanes_for<Perlin3DNoise>(preset, xs, ys, yStride, out, outDx, outDy, n, p, gp);     return;
+    }
+}
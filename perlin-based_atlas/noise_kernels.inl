@@ -0,0 +1,476 @@
+// Lane-generic noise kernels. Included once per SIMD namespace by noise_simd.h;
+// everything here only uses the vf / vi / vm wrapper API of that namespace.
+
+NOISE_INLINE vf fade(vf t) {
+    return t * t * t * (t * (t * splat(6.0f) - splat(15.0f)) + splat(10.0f));
+}
+
+NOISE_INLINE vf lerp(vf t, vf a, vf b) { return a + t * (b - a); }
+
+// grad() from perlin.h with z == 0: the 12 gradient directions collapse to
+// +-x +-y, +-x, +-y and 0 on the z = 0 face of the cube.
+NOISE_INLINE vf grad(vi hash, vf x, vf y) {
+    vi h = hash & splati(15);
+    vf u = select(lt(h, splati(8)), x, y);
+    vf v = select(lt(h, splati(4)), y,
+                  select(eq(h, splati(12)) | eq(h, splati(14)), x, splat(0.0f)));
+    return select(eq(h & splati(1), splati(0)), u, -u) +
+           select(eq(h & splati(2), splati(0)), v, -v);
+}
+
+NOISE_INLINE vf dfade(vf t) {
+    return t * t * (t * (t * splat(30.0f) - splat(60.0f)) + splat(30.0f));
+}
+
+// grad() as the vector (gx, gy) it dots with (x, y); see grad_vec() in perlin.h.
+NOISE_INLINE void grad_vec(vi hash, vf &gx, vf &gy) {
+    vi h = hash & splati(15);
+    vf su = select(eq(h & splati(1), splati(0)), splat(1.0f), splat(-1.0f)),
+       sv = select(eq(h & splati(2), splati(0)), splat(1.0f), splat(-1.0f));
+    vm hLow = lt(h, splati(8));
+    gx = select(hLow, su, select(eq(h, splati(12)) | eq(h, splati(14)), sv, splat(0.0f)));
+    gy = select(hLow, select(lt(h, splati(4)), sv, splat(0.0f)), su);
+}
+
+// Same lattice, hashing and blending as perlin_noise() in perlin.h. With z
+// fixed at 0 the outer lerp(w, ...) is always its first argument, so only the
+// four corners of the z = 0 face are hashed.
+NOISE_INLINE vf perlin_eval(vf x, vf y, const uint8_t *p) {
+    vf fx = floor_(x), fy = floor_(y);
+    vi X = to_int(fx) & splati(255),
+       Y = to_int(fy) & splati(255);
+    x = x - fx;
+    y = y - fy;
+    vf u = fade(x),
+       v = fade(y);
+    vi A = gather(p, X) + Y,            AA = gather(p, A), AB = gather(p, A + splati(1)),
+       B = gather(p, X + splati(1)) + Y, BA = gather(p, B), BB = gather(p, B + splati(1));
+
+    vf one = splat(1.0f);
+    return lerp(v, lerp(u, grad(gather(p, AA), x,       y),
+                           grad(gather(p, BA), x - one, y)),
+                   lerp(u, grad(gather(p, AB), x,       y - one),
+                           grad(gather(p, BB), x - one, y - one)));
+}
+
+// perlin_eval() plus analytic d/dx, d/dy (perlin_noise_d() in perlin.h). The
+// corner dot products are gx * x + gy * y, which is exactly what grad() returns.
+NOISE_INLINE vf perlin_eval_d(vf x, vf y, const uint8_t *p, vf &dx, vf &dy) {
+    vf fx = floor_(x), fy = floor_(y);
+    vi X = to_int(fx) & splati(255),
+       Y = to_int(fy) & splati(255);
+    x = x - fx;
+    y = y - fy;
+    vf u = fade(x), du = dfade(x),
+       v = fade(y), dv = dfade(y);
+    vi A = gather(p, X) + Y,            AA = gather(p, A), AB = gather(p, A + splati(1)),
+       B = gather(p, X + splati(1)) + Y, BA = gather(p, B), BB = gather(p, B + splati(1));
+
+    vf one = splat(1.0f);
+    vf gx00, gy00, gx10, gy10, gx01, gy01, gx11, gy11;
+    grad_vec(gather(p, AA), gx00, gy00);
+    grad_vec(gather(p, BA), gx10, gy10);
+    grad_vec(gather(p, AB), gx01, gy01);
+    grad_vec(gather(p, BB), gx11, gy11);
+    vf n00 = gx00 * x         + gy00 * y,
+       n10 = gx10 * (x - one) + gy10 * y,
+       n01 = gx01 * x         + gy01 * (y - one),
+       n11 = gx11 * (x - one) + gy11 * (y - one);
+    vf nx0 = lerp(u, n00, n10),
+       nx1 = lerp(u, n01, n11);
+
+    dx = lerp(v, lerp(u, gx00, gx10), lerp(u, gx01, gx11)) + du * (lerp(v, n10, n11) - lerp(v, n00, n01));
+    dy = lerp(v, lerp(u, gy00, gy10), lerp(u, gy01, gy11)) + dv * (nx1 - nx0);
+    return lerp(v, nx0, nx1);
+}
+
+// The low 3 bits of hash as one of 8 gradients, (+-1, +-1), (+-1, 0) and (0, +-1).
+NOISE_INLINE void grad8(vi hash, vf &gx, vf &gy) {
+    vi h = hash & splati(7);
+    vf one = splat(1.0f), zero = splat(0.0f);
+    vf su = select(eq(h & splati(1), splati(0)), one, -one),
+       sv = select(eq(h & splati(2), splati(0)), one, -one);
+    gx = select(lt(h, splati(6)), su, zero);
+    gy = select(lt(h, splati(4)), sv, select(lt(h, splati(6)), zero, su));
+}
+
+// True 2D Perlin: one hash per corner (no z level) and grad8() gradients.
+NOISE_INLINE vf perlin2d_eval_d(vf x, vf y, const uint8_t *p, vf &dx, vf &dy) {
+    vf fx = floor_(x), fy = floor_(y);
+    vi X = to_int(fx) & splati(255),
+       Y = to_int(fy) & splati(255);
+    x = x - fx;
+    y = y - fy;
+    vf u = fade(x), du = dfade(x),
+       v = fade(y), dv = dfade(y);
+    vi A = gather(p, X) + Y,
+       B = gather(p, X + splati(1)) + Y;
+
+    vf one = splat(1.0f);
+    vf gx[4], gy[4];
+    vi hashes[4] = { gather(p, A), gather(p, B), gather(p, A + splati(1)), gather(p, B + splati(1)) };
+    for (int c = 0; c < 4; c++) grad8(hashes[c], gx[c], gy[c]);
+    vf n00 = gx[0] * x         + gy[0] * y,
+       n10 = gx[1] * (x - one) + gy[1] * y,
+       n01 = gx[2] * x         + gy[2] * (y - one),
+       n11 = gx[3] * (x - one) + gy[3] * (y - one);
+    vf nx0 = lerp(u, n00, n10),
+       nx1 = lerp(u, n01, n11);
+
+    dx = lerp(v, lerp(u, gx[0], gx[1]), lerp(u, gx[2], gx[3])) + du * (lerp(v, n10, n11) - lerp(v, n00, n01));
+    dy = lerp(v, lerp(u, gy[0], gy[1]), lerp(u, gy[2], gy[3])) + dv * (nx1 - nx0);
+    return lerp(v, nx0, nx1);
+}
+
+// OpenSimplex2 (2D, fast variant): simplex lattice, r^2 = 0.5 attenuation
+// (0.5 - d.d)^4, unit gradients picked through the seeded permutation table.
+// Three corners and six table lookups per sample instead of Perlin's four / ten.
+NOISE_INLINE vf opensimplex2_eval_d(vf x, vf y, const uint8_t *p, vf &dx, vf &dy) {
+    const float F2 = 0.36602540378f, G2 = 0.21132486540f, SCALE = 99.20689f;
+    vf one = splat(1.0f), zero = splat(0.0f);
+
+    vf s = (x + y) * splat(F2);
+    vf fi = floor_(x + s), fj = floor_(y + s);
+    vf t = (fi + fj) * splat(G2);
+    vf x0 = x - (fi - t), y0 = y - (fj - t);
+    vf i1 = select(lt(y0, x0), one, zero), j1 = one - i1;
+
+    vi ii = to_int(fi) & splati(255),
+       jj = to_int(fj) & splati(255);
+    vi hashes[3] = { gather(p, ii + gather(p, jj)),
+                     gather(p, ii + to_int(i1) + gather(p, jj + to_int(j1))),
+                     gather(p, ii + splati(1) + gather(p, jj + splati(1))) };
+    vf cx[3] = { x0, x0 - i1 + splat(G2), x0 - one + splat(2.0f * G2) },
+       cy[3] = { y0, y0 - j1 + splat(G2), y0 - one + splat(2.0f * G2) };
+
+    vf value = zero;
+    dx = zero;
+    dy = zero;
+    for (int c = 0; c < 3; c++) {
+        vi h = hashes[c] & splati(15);
+        vf gx = gather(OS2_GRAD_X, h), gy = gather(OS2_GRAD_Y, h);
+        vf a = max_(splat(0.5f) - cx[c] * cx[c] - cy[c] * cy[c], zero);
+        vf a2 = a * a, a4 = a2 * a2, gd = gx * cx[c] + gy * cy[c];
+        vf k = splat(-8.0f) * a2 * a * gd;
+        value = value + a4 * gd;
+        dx = dx + a4 * gx + k * cx[c];
+        dy = dy + a4 * gy + k * cy[c];
+    }
+    dx = dx * splat(SCALE);
+    dy = dy * splat(SCALE);
+    return value * splat(SCALE);
+}
+
+// Value noise: a hashed value in [-1, 1] per lattice corner, blended with fade().
+NOISE_INLINE vf value_eval_d(vf x, vf y, const uint8_t *p, vf &dx, vf &dy) {
+    vf fx = floor_(x), fy = floor_(y);
+    vi X = to_int(fx) & splati(255),
+       Y = to_int(fy) & splati(255);
+    x = x - fx;
+    y = y - fy;
+    vf u = fade(x), du = dfade(x),
+       v = fade(y), dv = dfade(y);
+    vi A = gather(p, X) + Y,
+       B = gather(p, X + splati(1)) + Y;
+
+    vf toUnit = splat(2.0f / 255.0f), one = splat(1.0f);
+    vf c00 = to_float(gather(p, A)) * toUnit - one,
+       c10 = to_float(gather(p, B)) * toUnit - one,
+       c01 = to_float(gather(p, A + splati(1))) * toUnit - one,
+       c11 = to_float(gather(p, B + splati(1))) * toUnit - one;
+    vf nx0 = lerp(u, c00, c10),
+       nx1 = lerp(u, c01, c11);
+
+    dx = du * (lerp(v, c10, c11) - lerp(v, c00, c01));
+    dy = dv * (nx1 - nx0);
+    return lerp(v, nx0, nx1);
+}
+
+// Table-free gradient noise: corner hashes mix the full 32-bit lattice
+// coordinates (xxHash primes, murmur3 finalizer) instead of walking the
+// & 255 permutation table, so the field only repeats after 2^32 cells and
+// every step is plain integer SIMD, no gathers. The seed is the first four
+// bytes of p, so each world's table still gives a different field.
+NOISE_INLINE vi lattice_hash(vi h) {
+    h = (h ^ shr<16>(h)) * splati((int32_t)0x85EBCA6Bu);
+    h = (h ^ shr<13>(h)) * splati((int32_t)0xC2B2AE35u);
+    return h ^ shr<16>(h);
+}
+
+NOISE_INLINE vf hash_eval_d(vf x, vf y, const uint8_t *p, vf &dx, vf &dy) {
+    vf fx = floor_(x), fy = floor_(y);
+    const vi primeX = splati((int32_t)0x9E3779B1u), primeY = splati((int32_t)0x85EBCA77u);
+    vi seed = splati((int32_t)(p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24));
+    vi X0 = to_int(fx) * primeX ^ seed, X1 = (to_int(fx) + splati(1)) * primeX ^ seed,
+       Y0 = to_int(fy) * primeY,        Y1 = Y0 + primeY;
+    x = x - fx;
+    y = y - fy;
+    vf u = fade(x), du = dfade(x),
+       v = fade(y), dv = dfade(y);
+
+    vf one = splat(1.0f);
+    vf gx[4], gy[4];
+    vi hashes[4] = { lattice_hash(X0 ^ Y0), lattice_hash(X1 ^ Y0), lattice_hash(X0 ^ Y1), lattice_hash(X1 ^ Y1) };
+    for (int c = 0; c < 4; c++) grad8(hashes[c], gx[c], gy[c]);
+    vf n00 = gx[0] * x         + gy[0] * y,
+       n10 = gx[1] * (x - one) + gy[1] * y,
+       n01 = gx[2] * x         + gy[2] * (y - one),
+       n11 = gx[3] * (x - one) + gy[3] * (y - one);
+    vf nx0 = lerp(u, n00, n10),
+       nx1 = lerp(u, n01, n11);
+
+    dx = lerp(v, lerp(u, gx[0], gx[1]), lerp(u, gx[2], gx[3])) + du * (lerp(v, n10, n11) - lerp(v, n00, n01));
+    dy = lerp(v, lerp(u, gy[0], gy[1]), lerp(u, gy[2], gy[3])) + dv * (nx1 - nx0);
+    return lerp(v, nx0, nx1);
+}
+
+// Backend policies for the row loops below. The value-only eval() of the
+// newer backends reuses eval_d(); the unused derivative math is dropped after inlining.
+struct Perlin3DNoise {
+    static NOISE_INLINE vf eval(vf x, vf y, const uint8_t *p) { return perlin_eval(x, y, p); }
+    static NOISE_INLINE vf eval_d(vf x, vf y, const uint8_t *p, vf &dx, vf &dy) { return perlin_eval_d(x, y, p, dx, dy); }
+};
+struct Perlin2DNoise {
+    static NOISE_INLINE vf eval(vf x, vf y, const uint8_t *p) { vf dx, dy; return perlin2d_eval_d(x, y, p, dx, dy); }
+    static NOISE_INLINE vf eval_d(vf x, vf y, const uint8_t *p, vf &dx, vf &dy) { return perlin2d_eval_d(x, y, p, dx, dy); }
+};
+struct OpenSimplex2Noise {
+    static NOISE_INLINE vf eval(vf x, vf y, const uint8_t *p) { vf dx, dy; return opensimplex2_eval_d(x, y, p, dx, dy); }
+    static NOISE_INLINE vf eval_d(vf x, vf y, const uint8_t *p, vf &dx, vf &dy) { return opensimplex2_eval_d(x, y, p, dx, dy); }
+};
+struct ValueNoise {
+    static NOISE_INLINE vf eval(vf x, vf y, const uint8_t *p) { vf dx, dy; return value_eval_d(x, y, p, dx, dy); }
+    static NOISE_INLINE vf eval_d(vf x, vf y, const uint8_t *p, vf &dx, vf &dy) { return value_eval_d(x, y, p, dx, dy); }
+};
+struct HashNoise {
+    static NOISE_INLINE vf eval(vf x, vf y, const uint8_t *p) { vf dx, dy; return hash_eval_d(x, y, p, dx, dy); }
+    static NOISE_INLINE vf eval_d(vf x, vf y, const uint8_t *p, vf &dx, vf &dy) { return hash_eval_d(x, y, p, dx, dy); }
+};
+
+// y coordinates for lanes i .. i + WIDTH: a row shares one y (yStride 0),
+// a point list has one per sample (yStride 1).
+NOISE_INLINE vf load_y(const float *ys, int yStride, int i) { return yStride ? load(ys + i) : splat(ys[0]); }
+
+// Ragged tail from i: padded stack copies so the last samples run as one full batch.
+NOISE_INLINE void load_tail(const float *xs, const float *ys, int yStride, int i, int n, vf &x, vf &y) {
+    float tx[WIDTH], ty[WIDTH];
+    for (int k = 0; k < WIDTH; k++) {
+        tx[k] = (i + k < n) ? xs[i + k] : 0.0f;
+        ty[k] = yStride ? ((i + k < n) ? ys[i + k] : 0.0f) : ys[0];
+    }
+    x = load(tx);
+    y = load(ty);
+}
+
+NOISE_INLINE void store_tail(float *out, int i, int n, vf a) {
+    float t[WIDTH];
+    store(t, a);
+    for (int k = 0; i + k < n; k++) out[i + k] = t[k];
+}
+
+// out[i] = noise(xs[i], ys[i * yStride]); outDx / outDy get the partial derivatives when non-null.
+template <class Noise>
+inline void noise_row(const float *xs, const float *ys, int yStride, float *out, float *outDx, float *outDy,
+                      int n, const uint8_t *p) {
+    int i = 0;
+    if (outDx) {
+        for (; i + WIDTH <= n; i += WIDTH) {
+            vf dx, dy;
+            store(out + i, Noise::eval_d(load(xs + i), load_y(ys, yStride, i), p, dx, dy));
+            store(outDx + i, dx);
+            store(outDy + i, dy);
+        }
+    } else {
+        for (; i + WIDTH <= n; i += WIDTH)
+            store(out + i, Noise::eval(load(xs + i), load_y(ys, yStride, i), p));
+    }
+
+    if (i < n) {
+        vf x, y;
+        load_tail(xs, ys, yStride, i, n, x, y);
+        if (outDx) {
+            vf dx, dy;
+            store_tail(out, i, n, Noise::eval_d(x, y, p, dx, dy));
+            store_tail(outDx, i, n, dx);
+            store_tail(outDy, i, n, dy);
+        } else {
+            store_tail(out, i, n, Noise::eval(x, y, p));
+        }
+    }
+}
+
+inline void backend_row(NoiseBackend backend, const float *xs, const float *ys, int yStride,
+                        float *out, float *outDx, float *outDy, int n, const uint8_t *p) {
+    switch (backend) {
+    case NoiseBackend::PERLIN2D:     noise_row<Perlin2DNoise>(xs, ys, yStride, out, outDx, outDy, n, p);     return;
+    case NoiseBackend::OPENSIMPLEX2: noise_row<OpenSimplex2Noise>(xs, ys, yStride, out, outDx, outDy, n, p); return;
+    case NoiseBackend::VALUE:        noise_row<ValueNoise>(xs, ys, yStride, out, outDx, outDy, n, p);        return;
+    case NoiseBackend::HASH:         noise_row<HashNoise>(xs, ys, yStride, out, outDx, outDy, n, p);         return;
+    default:                         noise_row<Perlin3DNoise>(xs, ys, yStride, out, outDx, outDy, n, p);     return;
+    }
+}
+
+inline void perlin_row(const float *xs, float y, float *out, int n, const uint8_t *p) {
+    noise_row<Perlin3DNoise>(xs, &y, 0, out, nullptr, nullptr, n, p);
+}
+
+// ----------------- 3D -----------------
+// grad() from perlin.h with a real z.
+NOISE_INLINE vf grad3(vi hash, vf x, vf y, vf z) {
+    vi h = hash & splati(15);
+    vf u = select(lt(h, splati(8)), x, y);
+    vf v = select(lt(h, splati(4)), y, select(eq(h, splati(12)) | eq(h, splati(14)), x, z));
+    return select(eq(h & splati(1), splati(0)), u, -u) +
+           select(eq(h & splati(2), splati(0)), v, -v);
+}
+
+// perlin_noise() over all 8 corners of the cube, for volumetric density.
+NOISE_INLINE vf perlin3_eval(vf x, vf y, vf z, const uint8_t *p) {
+    vf fx = floor_(x), fy = floor_(y), fz = floor_(z);
+    vi X = to_int(fx) & splati(255),
+       Y = to_int(fy) & splati(255),
+       Z = to_int(fz) & splati(255);
+    x = x - fx;
+    y = y - fy;
+    z = z - fz;
+    vf u = fade(x),
+       v = fade(y),
+       w = fade(z);
+    vi one_i = splati(1);
+    vi A = gather(p, X) + Y,        AA = gather(p, A) + Z, AB = gather(p, A + one_i) + Z,
+       B = gather(p, X + one_i) + Y, BA = gather(p, B) + Z, BB = gather(p, B + one_i) + Z;
+
+    vf one = splat(1.0f);
+    return lerp(w, lerp(v, lerp(u, grad3(gather(p, AA), x,       y,       z),
+                                   grad3(gather(p, BA), x - one, y,       z)),
+                           lerp(u, grad3(gather(p, AB), x,       y - one, z),
+                                   grad3(gather(p, BB), x - one, y - one, z))),
+                   lerp(v, lerp(u, grad3(gather(p, AA + one_i), x,       y,       z - one),
+                                   grad3(gather(p, BA + one_i), x - one, y,       z - one)),
+                           lerp(u, grad3(gather(p, AB + one_i), x,       y - one, z - one),
+                                   grad3(gather(p, BB + one_i), x - one, y - one, z - one))));
+}
+
+// out[i] = (fbm3(xs[i], y, z) + 1) / maxHeight over perlin3_eval, runtime octave count.
+inline void fbm3_row(const float *xs, float y, float z, float *out, int n, const uint8_t *p,
+                     int octaves, const float *amps, const float *freqs, float maxHeight) {
+    auto fbm3 = [&](vf x) {
+        vf acc = splat(0.0f), vy = splat(y), vz = splat(z);
+        for (int o = 0; o < octaves; o++) {
+            vf f = splat(freqs[o]);
+            acc = acc + perlin3_eval(x * f, vy * f, vz * f, p) * splat(amps[o]);
+        }
+        return (acc + splat(1.0f)) / splat(maxHeight);
+    };
+    int i = 0;
+    for (; i + WIDTH <= n; i += WIDTH) store(out + i, fbm3(load(xs + i)));
+
+    if (i < n) {
+        vf x, unused;
+        load_tail(xs, &y, 0, i, n, x, unused);
+        store_tail(out, i, n, fbm3(x));
+    }
+}
+
+// Bit i % 64 of bits[i / 64] is set where values[i] > 0, one compare and
+// movemask per WIDTH samples. bits must hold (n + 63) / 64 words.
+inline void sign_bits(const float *values, int n, uint64_t *bits) {
+    std::memset(bits, 0, sizeof(uint64_t) * ((n + 63) / 64));
+    const vf zero = splat(0.0f);
+    int i = 0;
+    for (; i + WIDTH <= n; i += WIDTH)
+        bits[i / 64] |= (uint64_t)movemask(lt(zero, load(values + i))) << (i % 64);
+    for (; i < n; i++)
+        if (values[i] > 0.0f) bits[i / 64] |= 1ull << (i % 64);
+}
+
+// fBm over Octaves octaves, fully unrolled. W supplies amp(i), freq(i) and
+// max_height(octaves): FbmStaticWeights folds them to immediates at compile
+// time, FbmRuntimeWeights reads them from a table computed once per chunk.
+// Octaves are summed in the same order as the original per-sample loop.
+template <int I, int Octaves, class W>
+struct fbm_octaves {
+    static NOISE_INLINE vf sum(vf acc, vf x, vf y, const uint8_t *p, const W &w) {
+        vf f = splat(w.freq(I));
+        acc = acc + perlin_eval(x * f, y * f, p) * splat(w.amp(I));
+        return fbm_octaves<I + 1, Octaves, W>::sum(acc, x, y, p, w);
+    }
+};
+
+template <int Octaves, class W>
+struct fbm_octaves<Octaves, Octaves, W> {
+    static NOISE_INLINE vf sum(vf acc, vf, vf, const uint8_t *, const W &) { return acc; }
+};
+
+// out[i] = (fbm(xs[i], ys[i * yStride]) + 1) / maxPossibleHeight, i.e. generate_noise_map's normalized value.
+template <int Octaves, class W>
+inline void fbm_row(const float *xs, const float *ys, int yStride, float *out, int n, const uint8_t *p, const W &w) {
+    const vf one = splat(1.0f), maxHeight = splat(w.max_height(Octaves));
+    int i = 0;
+    for (; i + WIDTH <= n; i += WIDTH) {
+        vf acc = fbm_octaves<0, Octaves, W>::sum(splat(0.0f), load(xs + i), load_y(ys, yStride, i), p, w);
+        store(out + i, (acc + one) / maxHeight);
+    }
+
+    if (i < n) {
+        vf x, y;
+        load_tail(xs, ys, yStride, i, n, x, y);
+        vf acc = fbm_octaves<0, Octaves, W>::sum(splat(0.0f), x, y, p, w);
+        store_tail(out, i, n, (acc + one) / maxHeight);
+    }
+}
+
+// fbm_octaves with the gradient carried along: d/dx of amp * perlin(x * freq) is amp * freq * perlin'.
+template <int I, int Octaves, class W>
+struct fbm_octaves_d {
+    static NOISE_INLINE vf sum(vf acc, vf &dx, vf &dy, vf x, vf y, const uint8_t *p, const W &w) {
+        vf f = splat(w.freq(I)), a = splat(w.amp(I)), ox, oy;
+        acc = acc + perlin_eval_d(x * f, y * f, p, ox, oy) * a;
+        vf af = splat(w.amp(I) * w.freq(I));
+        dx = dx + ox * af;
+        dy = dy + oy * af;
+        return fbm_octaves_d<I + 1, Octaves, W>::sum(acc, dx, dy, x, y, p, w);
+    }
+};
+
+template <int Octaves, class W>
+struct fbm_octaves_d<Octaves, Octaves, W> {
+    static NOISE_INLINE vf sum(vf acc, vf &, vf &, vf, vf, const uint8_t *, const W &) { return acc; }
+};
+
+// fbm_row() that also writes d(out)/dx and d(out)/dy with respect to xs / ys.
+template <int Octaves, class W>
+inline void fbm_row_d(const float *xs, const float *ys, int yStride, float *out, float *outDx, float *outDy, int n,
+                      const uint8_t *p, const W &w) {
+    const vf one = splat(1.0f), maxHeight = splat(w.max_height(Octaves));
+    int i = 0;
+    for (; i + WIDTH <= n; i += WIDTH) {
+        vf dx = splat(0.0f), dy = splat(0.0f);
+        vf acc = fbm_octaves_d<0, Octaves, W>::sum(splat(0.0f), dx, dy, load(xs + i), load_y(ys, yStride, i), p, w);
+        store(out + i, (acc + one) / maxHeight);
+        store(outDx + i, dx / maxHeight);
+        store(outDy + i, dy / maxHeight);
+    }
+
+    if (i < n) {
+        vf x, y, dx = splat(0.0f), dy = splat(0.0f);
+        load_tail(xs, ys, yStride, i, n, x, y);
+        vf acc = fbm_octaves_d<0, Octaves, W>::sum(splat(0.0f), dx, dy, x, y, p, w);
+        store_tail(out, i, n, (acc + one) / maxHeight);
+        store_tail(outDx, i, n, dx / maxHeight);
+        store_tail(outDy, i, n, dy / maxHeight);
+    }
+}
+
+// Runtime octave count -> one of the unrolled fbm_row<1..N> / fbm_row_d<1..N> instances.
+template <class W, int... I>
+inline void fbm_row_dispatch(std::integer_sequence<int, I...>, int octaves, const float *xs, const float *ys,
+                             int yStride, float *out, float *outDx, float *outDy, int n,
+                             const uint8_t *p, const W &w) {
+    using Fn = void (*)(const float *, const float *, int, float *, int, const uint8_t *, const W &);
+    using FnD = void (*)(const float *, const float *, int, float *, float *, float *, int, const uint8_t *, const W &);
+    static const Fn table[] = { &fbm_row<I + 1, W>... };
+    static const FnD tableD[] = { &fbm_row_d<I + 1, W>... };
+    if (outDx) tableD[octaves - 1](xs, ys, yStride, out, outDx, outDy, n, p, w);
+    else       table[octaves - 1](xs, ys, yStride, out, n, p, w);
+}
@@ -0,0 +1,699 @@
+#ifndef NOISE_SIMD_H
+#define NOISE_SIMD_H
+
+// Batched noise evaluation. The kernels in noise_kernels.inl are written once
+// against a tiny lane-wrapper API (vf / vi / vm) and compiled three times:
+// scalar, SSE4.1 and AVX2. The best path is picked at runtime, so the plain
+// g++ command in the README still works on any x86 or ARM machine.
+//
+// Accuracy: the batched kernels run in float while perlin_noise() runs in
+// double. On the same inputs the two agree to within NOISE_BATCH_TOLERANCE
+// (absolute); `atlas --bench` checks this on every path it times.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define NOISE_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define NOISE_SIMD_X86 0
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define NOISE_INLINE inline __attribute__((always_inline))
+#else
+#define NOISE_INLINE inline
+#endif
+
+const float NOISE_BATCH_TOLERANCE = 1e-5f;
+
+enum class SimdLevel { SCALAR = 0, SSE41 = 1, AVX2 = 2 };
+
+inline const char *simd_level_name(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::SSE41: return "sse4.1";
+    case SimdLevel::AVX2:  return "avx2";
+    default:               return "scalar";
+    }
+}
+
+// Batch noise backends. PERLIN3D is perlin_noise() from perlin.h (3D Perlin
+// at z = 0) and stays the default so existing worlds do not change. HASH is
+// table-free and does not repeat every 256 lattice cells like the others.
+enum class NoiseBackend { PERLIN3D = 0, PERLIN2D = 1, OPENSIMPLEX2 = 2, VALUE = 3, HASH = 4 };
+const int NOISE_BACKEND_COUNT = 5;
+
+inline const char *noise_backend_name(NoiseBackend backend) {
+    switch (backend) {
+    case NoiseBackend::PERLIN2D:     return "perlin2d";
+    case NoiseBackend::OPENSIMPLEX2: return "opensimplex2";
+    case NoiseBackend::VALUE:        return "value";
+    case NoiseBackend::HASH:         return "hash";
+    default:                         return "perlin3d";
+    }
+}
+
+inline bool parse_noise_backend(const std::string &name, NoiseBackend &backend) {
+    for (int i = 0; i < NOISE_BACKEND_COUNT; i++) {
+        if (name == noise_backend_name((NoiseBackend)i)) {
+            backend = (NoiseBackend)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Terrain shaping presets (noise_graph.inl): each one is a composed noise
+// graph compiled to its own fused height + slope loop.
+enum class TerrainPreset { CLASSIC = 0, MESAS = 1, RIDGES = 2, WARPED = 3 };
+const int TERRAIN_PRESET_COUNT = 4;
+
+inline const char *terrain_preset_name(TerrainPreset preset) {
+    switch (preset) {
+    case TerrainPreset::MESAS:  return "mesas";
+    case TerrainPreset::RIDGES: return "ridges";
+    case TerrainPreset::WARPED: return "warped";
+    default:                    return "classic";
+    }
+}
+
+inline bool parse_terrain_preset(const std::string &name, TerrainPreset &preset) {
+    for (int i = 0; i < TERRAIN_PRESET_COUNT; i++) {
+        if (name == terrain_preset_name((TerrainPreset)i)) {
+            preset = (TerrainPreset)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Runtime inputs of the terrain graphs. amps / freqs are per-octave tables
+// (FbmRuntimeWeights::amps / freqs); invMaxHeight normalizes the main fBm and
+// stays that of the full octave count when octaves is lowered for LOD.
+struct TerrainGraphParams {
+    int octaves;
+    const float *amps, *freqs;
+    float invMaxHeight;
+    float waterFloor;       // normalized height everything below is clamped to
+    float warpStrength;     // WARPED preset, in noise units
+};
+
+// OpenSimplex2 gradient set: 16 unit vectors, offset half a step from the axes.
+alignas(64) static const float OS2_GRAD_X[16] = {
+     0.98078528f,  0.83146961f,  0.55557023f,  0.19509032f, -0.19509032f, -0.55557023f, -0.83146961f, -0.98078528f,
+    -0.98078528f, -0.83146961f, -0.55557023f, -0.19509032f,  0.19509032f,  0.55557023f,  0.83146961f,  0.98078528f };
+alignas(64) static const float OS2_GRAD_Y[16] = {
+     0.19509032f,  0.55557023f,  0.83146961f,  0.98078528f,  0.98078528f,  0.83146961f,  0.55557023f,  0.19509032f,
+    -0.19509032f, -0.55557023f, -0.83146961f, -0.98078528f, -0.98078528f, -0.83146961f, -0.55557023f, -0.19509032f };
+
+// ----------------- scalar lanes (fallback, 1 wide) -----------------
+namespace noise_scalar {
+    const int WIDTH = 1;
+    struct vf { float v; };
+    struct vi { int32_t v; };
+    struct vm { bool v; };
+
+    NOISE_INLINE vf load(const float *p) { return { *p }; }
+    NOISE_INLINE void store(float *p, vf a) { *p = a.v; }
+    NOISE_INLINE vf splat(float a) { return { a }; }
+    NOISE_INLINE vi splati(int32_t a) { return { a }; }
+
+    NOISE_INLINE vf operator+(vf a, vf b) { return { a.v + b.v }; }
+    NOISE_INLINE vf operator-(vf a, vf b) { return { a.v - b.v }; }
+    NOISE_INLINE vf operator*(vf a, vf b) { return { a.v * b.v }; }
+    NOISE_INLINE vf operator/(vf a, vf b) { return { a.v / b.v }; }
+    NOISE_INLINE vf operator-(vf a) { return { -a.v }; }
+    NOISE_INLINE vi operator+(vi a, vi b) { return { a.v + b.v }; }
+    NOISE_INLINE vi operator&(vi a, vi b) { return { a.v & b.v }; }
+    NOISE_INLINE vi operator^(vi a, vi b) { return { a.v ^ b.v }; }
+    NOISE_INLINE vi operator*(vi a, vi b) { return { (int32_t)((uint32_t)a.v * (uint32_t)b.v) }; }
+    template <int N> NOISE_INLINE vi shr(vi a) { return { (int32_t)((uint32_t)a.v >> N) }; }
+    NOISE_INLINE vm operator|(vm a, vm b) { return { a.v || b.v }; }
+
+    NOISE_INLINE vf floor_(vf a) { return { std::floor(a.v) }; }
+    NOISE_INLINE vi to_int(vf a) { return { (int32_t)a.v }; }
+    NOISE_INLINE vf to_float(vi a) { return { (float)a.v }; }
+    NOISE_INLINE vf max_(vf a, vf b) { return { a.v > b.v ? a.v : b.v }; }
+    NOISE_INLINE vm lt(vf a, vf b) { return { a.v < b.v }; }
+    NOISE_INLINE vm lt(vi a, vi b) { return { a.v < b.v }; }
+    NOISE_INLINE vm eq(vi a, vi b) { return { a.v == b.v }; }
+    NOISE_INLINE vf select(vm m, vf a, vf b) { return m.v ? a : b; }
+    NOISE_INLINE uint32_t movemask(vm m) { return m.v ? 1u : 0u; }
+    NOISE_INLINE vi gather(const uint8_t *table, vi idx) { return { table[idx.v] }; }
+    NOISE_INLINE vf gather(const float *table, vi idx) { return { table[idx.v] }; }
+
+    #include "noise_kernels.inl"
+    #include "noise_graph.inl"
+}
+
+#if NOISE_SIMD_X86
+// ----------------- SSE4.1 lanes (4 wide) -----------------
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse4.1"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("sse4.1")
+#endif
+namespace noise_sse41 {
+    const int WIDTH = 4;
+    struct vf { __m128 v; };
+    struct vi { __m128i v; };
+    struct vm { __m128 v; };
+
+    NOISE_INLINE vf load(const float *p) { return { _mm_loadu_ps(p) }; }
+    NOISE_INLINE void store(float *p, vf a) { _mm_storeu_ps(p, a.v); }
+    NOISE_INLINE vf splat(float a) { return { _mm_set1_ps(a) }; }
+    NOISE_INLINE vi splati(int32_t a) { return { _mm_set1_epi32(a) }; }
+
+    NOISE_INLINE vf operator+(vf a, vf b) { return { _mm_add_ps(a.v, b.v) }; }
+    NOISE_INLINE vf operator-(vf a, vf b) { return { _mm_sub_ps(a.v, b.v) }; }
+    NOISE_INLINE vf operator*(vf a, vf b) { return { _mm_mul_ps(a.v, b.v) }; }
+    NOISE_INLINE vf operator/(vf a, vf b) { return { _mm_div_ps(a.v, b.v) }; }
+    NOISE_INLINE vf operator-(vf a) { return { _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)) }; }
+    NOISE_INLINE vi operator+(vi a, vi b) { return { _mm_add_epi32(a.v, b.v) }; }
+    NOISE_INLINE vi operator&(vi a, vi b) { return { _mm_and_si128(a.v, b.v) }; }
+    NOISE_INLINE vi operator^(vi a, vi b) { return { _mm_xor_si128(a.v, b.v) }; }
+    NOISE_INLINE vi operator*(vi a, vi b) { return { _mm_mullo_epi32(a.v, b.v) }; }
+    template <int N> NOISE_INLINE vi shr(vi a) { return { _mm_srli_epi32(a.v, N) }; }
+    NOISE_INLINE vm operator|(vm a, vm b) { return { _mm_or_ps(a.v, b.v) }; }
+
+    NOISE_INLINE vf floor_(vf a) { return { _mm_floor_ps(a.v) }; }
+    NOISE_INLINE vi to_int(vf a) { return { _mm_cvttps_epi32(a.v) }; }
+    NOISE_INLINE vf to_float(vi a) { return { _mm_cvtepi32_ps(a.v) }; }
+    NOISE_INLINE vf max_(vf a, vf b) { return { _mm_max_ps(a.v, b.v) }; }
+    NOISE_INLINE vm lt(vf a, vf b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+    NOISE_INLINE vm lt(vi a, vi b) { return { _mm_castsi128_ps(_mm_cmplt_epi32(a.v, b.v)) }; }
+    NOISE_INLINE vm eq(vi a, vi b) { return { _mm_castsi128_ps(_mm_cmpeq_epi32(a.v, b.v)) }; }
+    NOISE_INLINE vf select(vm m, vf a, vf b) { return { _mm_blendv_ps(b.v, a.v, m.v) }; }
+    NOISE_INLINE uint32_t movemask(vm m) { return (uint32_t)_mm_movemask_ps(m.v); }
+    NOISE_INLINE vi gather(const uint8_t *table, vi idx) {
+        // no hardware gather before AVX2
+        return { _mm_setr_epi32(table[_mm_extract_epi32(idx.v, 0)], table[_mm_extract_epi32(idx.v, 1)],
+                                table[_mm_extract_epi32(idx.v, 2)], table[_mm_extract_epi32(idx.v, 3)]) };
+    }
+    NOISE_INLINE vf gather(const float *table, vi idx) {
+        return { _mm_setr_ps(table[_mm_extract_epi32(idx.v, 0)], table[_mm_extract_epi32(idx.v, 1)],
+                             table[_mm_extract_epi32(idx.v, 2)], table[_mm_extract_epi32(idx.v, 3)]) };
+    }
+
+    #include "noise_kernels.inl"
+    #include "noise_graph.inl"
+}
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+// ----------------- AVX2 lanes (8 wide) -----------------
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2,fma"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+namespace noise_avx2 {
+    const int WIDTH = 8;
+    struct vf { __m256 v; };
+    struct vi { __m256i v; };
+    struct vm { __m256 v; };
+
+    NOISE_INLINE vf load(const float *p) { return { _mm256_loadu_ps(p) }; }
+    NOISE_INLINE void store(float *p, vf a) { _mm256_storeu_ps(p, a.v); }
+    NOISE_INLINE vf splat(float a) { return { _mm256_set1_ps(a) }; }
+    NOISE_INLINE vi splati(int32_t a) { return { _mm256_set1_epi32(a) }; }
+
+    NOISE_INLINE vf operator+(vf a, vf b) { return { _mm256_add_ps(a.v, b.v) }; }
+    NOISE_INLINE vf operator-(vf a, vf b) { return { _mm256_sub_ps(a.v, b.v) }; }
+    NOISE_INLINE vf operator*(vf a, vf b) { return { _mm256_mul_ps(a.v, b.v) }; }
+    NOISE_INLINE vf operator/(vf a, vf b) { return { _mm256_div_ps(a.v, b.v) }; }
+    NOISE_INLINE vf operator-(vf a) { return { _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)) }; }
+    NOISE_INLINE vi operator+(vi a, vi b) { return { _mm256_add_epi32(a.v, b.v) }; }
+    NOISE_INLINE vi operator&(vi a, vi b) { return { _mm256_and_si256(a.v, b.v) }; }
+    NOISE_INLINE vi operator^(vi a, vi b) { return { _mm256_xor_si256(a.v, b.v) }; }
+    NOISE_INLINE vi operator*(vi a, vi b) { return { _mm256_mullo_epi32(a.v, b.v) }; }
+    template <int N> NOISE_INLINE vi shr(vi a) { return { _mm256_srli_epi32(a.v, N) }; }
+    NOISE_INLINE vm operator|(vm a, vm b) { return { _mm256_or_ps(a.v, b.v) }; }
+
+    NOISE_INLINE vf floor_(vf a) { return { _mm256_floor_ps(a.v) }; }
+    NOISE_INLINE vi to_int(vf a) { return { _mm256_cvttps_epi32(a.v) }; }
+    NOISE_INLINE vf to_float(vi a) { return { _mm256_cvtepi32_ps(a.v) }; }
+    NOISE_INLINE vf max_(vf a, vf b) { return { _mm256_max_ps(a.v, b.v) }; }
+    NOISE_INLINE vm lt(vf a, vf b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+    NOISE_INLINE vm lt(vi a, vi b) { return { _mm256_castsi256_ps(_mm256_cmpgt_epi32(b.v, a.v)) }; }
+    NOISE_INLINE vm eq(vi a, vi b) { return { _mm256_castsi256_ps(_mm256_cmpeq_epi32(a.v, b.v)) }; }
+    NOISE_INLINE vf select(vm m, vf a, vf b) { return { _mm256_blendv_ps(b.v, a.v, m.v) }; }
+    NOISE_INLINE uint32_t movemask(vm m) { return (uint32_t)_mm256_movemask_ps(m.v); }
+    NOISE_INLINE vi gather(const uint8_t *table, vi idx) {
+        // 32-bit gather at byte granularity, keep the low byte (tables carry 3 bytes of slack)
+        return { _mm256_and_si256(_mm256_i32gather_epi32((const int *)table, idx.v, 1), _mm256_set1_epi32(0xFF)) };
+    }
+    NOISE_INLINE vf gather(const float *table, vi idx) { return { _mm256_i32gather_ps(table, idx.v, 4) }; }
+
+    #include "noise_kernels.inl"
+    #include "noise_graph.inl"
+}
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+#endif // NOISE_SIMD_X86
+
+// ----------------- runtime dispatch -----------------
+inline SimdLevel detect_simd_level() {
+#if NOISE_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse4.1")) return SimdLevel::SSE41;
+#endif
+    return SimdLevel::SCALAR;
+}
+
+// Highest level this CPU runs; requests above it fall back to the best available one.
+inline SimdLevel clamp_simd_level(SimdLevel level) {
+    static const SimdLevel best = detect_simd_level();
+    return (int)level > (int)best ? best : level;
+}
+
+// Evaluates perlin_noise(xs[i], y, p) for a whole row of n samples.
+// p is a NoiseContext::perm table.
+inline void perlin_noise_row(const float *xs, float y, float *out, int n, const uint8_t *p,
+                             SimdLevel level = SimdLevel::AVX2) {
+    switch (clamp_simd_level(level)) {
+#if NOISE_SIMD_X86
+    case SimdLevel::AVX2:  noise_avx2::perlin_row(xs, y, out, n, p);  return;
+    case SimdLevel::SSE41: noise_sse41::perlin_row(xs, y, out, n, p); return;
+#endif
+    default:               noise_scalar::perlin_row(xs, y, out, n, p); return;
+    }
+}
+
+// Evaluates one backend for a whole row; outDx / outDy (both or neither)
+// receive d/dx and d/dy. PERLIN3D matches perlin_noise_row().
+inline void noise_row(NoiseBackend backend, const float *xs, float y, float *out, float *outDx, float *outDy,
+                      int n, const uint8_t *p, SimdLevel level = SimdLevel::AVX2) {
+    switch (clamp_simd_level(level)) {
+#if NOISE_SIMD_X86
+    case SimdLevel::AVX2:  noise_avx2::backend_row(backend, xs, &y, 0, out, outDx, outDy, n, p);  return;
+    case SimdLevel::SSE41: noise_sse41::backend_row(backend, xs, &y, 0, out, outDx, outDy, n, p); return;
+#endif
+    default:               noise_scalar::backend_row(backend, xs, &y, 0, out, outDx, outDy, n, p); return;
+    }
+}
+
+// ----------------- fBm -----------------
+const int FBM_MAX_OCTAVES = 12;
+
+// Octave weights known at compile time. Params provides constexpr
+// persistence() and lacunarity(); the amplitudes, frequencies and the
+// normalization constant are then folded into the unrolled kernel.
+template <class Params>
+struct FbmStaticWeights {
+    static constexpr float amp(int i) {
+        float a = 1.0f;
+        for (int k = 0; k < i; k++) a *= Params::persistence();
+        return a;
+    }
+    static constexpr float freq(int i) {
+        float f = 1.0f;
+        for (int k = 0; k < i; k++) f *= Params::lacunarity();
+        return f;
+    }
+    static constexpr float max_height(int octaves) {
+        float h = 0.0f;
+        for (int k = 0; k < octaves; k++) h += amp(k);
+        return h;
+    }
+};
+
+// The defaults in main.cpp (persistence 0.5, lacunarity 2).
+struct FbmClassicParams {
+    static constexpr float persistence() { return 0.5f; }
+    static constexpr float lacunarity() { return 2.0f; }
+};
+
+// Octave weights for arbitrary runtime persistence / lacunarity, computed
+// with the same running products as the original loop.
+struct FbmRuntimeWeights {
+    float persistence, lacunarity;
+    float amps[FBM_MAX_OCTAVES], freqs[FBM_MAX_OCTAVES], maxHeights[FBM_MAX_OCTAVES + 1];
+
+    FbmRuntimeWeights(float _persistence, float _lacunarity)
+        : persistence(_persistence), lacunarity(_lacunarity) {
+        float a = 1.0f, f = 1.0f;
+        maxHeights[0] = 0.0f;
+        for (int i = 0; i < FBM_MAX_OCTAVES; i++) {
+            amps[i] = a;
+            freqs[i] = f;
+            maxHeights[i + 1] = maxHeights[i] + a;
+            a *= persistence;
+            f *= lacunarity;
+        }
+    }
+    float amp(int i) const { return amps[i]; }
+    float freq(int i) const { return freqs[i]; }
+    float max_height(int octaves) const { return maxHeights[octaves]; }
+};
+
+// Normalized fBm over n samples at (xs[i], ys[i * yStride]); outDx / outDy
+// (both or neither) receive the gradient with respect to xs / ys.
+template <class W>
+inline void fbm_noise_lanes(const float *xs, const float *ys, int yStride, float *out, float *outDx, float *outDy,
+                            int n, const uint8_t *p, int octaves, const W &w, SimdLevel level) {
+    octaves = octaves < 1 ? 1 : (octaves > FBM_MAX_OCTAVES ? FBM_MAX_OCTAVES : octaves);
+    const std::make_integer_sequence<int, FBM_MAX_OCTAVES> all;
+    switch (clamp_simd_level(level)) {
+#if NOISE_SIMD_X86
+    case SimdLevel::AVX2:  noise_avx2::fbm_row_dispatch(all, octaves, xs, ys, yStride, out, outDx, outDy, n, p, w);  return;
+    case SimdLevel::SSE41: noise_sse41::fbm_row_dispatch(all, octaves, xs, ys, yStride, out, outDx, outDy, n, p, w); return;
+#endif
+    default:               noise_scalar::fbm_row_dispatch(all, octaves, xs, ys, yStride, out, outDx, outDy, n, p, w); return;
+    }
+}
+
+// Calls fn with the constant-folded weights when the runtime parameters are the classic ones.
+template <class Fn>
+inline void with_fbm_weights(const FbmRuntimeWeights &w, Fn &&fn) {
+    if (w.persistence == FbmClassicParams::persistence() && w.lacunarity == FbmClassicParams::lacunarity())
+        fn(FbmStaticWeights<FbmClassicParams>());
+    else
+        fn(w);
+}
+
+// Normalized fBm for a row: out[i] = (sum_k amp_k * perlin(xs[i] * freq_k, y * freq_k) + 1) / maxPossibleHeight.
+// xs / y are the sample coordinates already divided by noiseScale; octaves is clamped to 1..FBM_MAX_OCTAVES.
+template <class W>
+inline void fbm_noise_row(const float *xs, float y, float *out, int n, const uint8_t *p,
+                          int octaves, const W &w, SimdLevel level = SimdLevel::AVX2) {
+    fbm_noise_lanes(xs, &y, 0, out, nullptr, nullptr, n, p, octaves, w, level);
+}
+
+inline void fbm_noise_row(const float *xs, float y, float *out, int n, const uint8_t *p,
+                          int octaves, const FbmRuntimeWeights &w, SimdLevel level = SimdLevel::AVX2) {
+    with_fbm_weights(w, [&](const auto &weights) {
+        fbm_noise_lanes(xs, &y, 0, out, nullptr, nullptr, n, p, octaves, weights, level);
+    });
+}
+
+// fbm_noise_row() plus the analytic gradient of the normalized value with
+// respect to xs / y (multiply by 1 / noiseScale for per-vertex slopes).
+template <class W>
+inline void fbm_noise_row_d(const float *xs, float y, float *out, float *outDx, float *outDy, int n,
+                            const uint8_t *p, int octaves, const W &w, SimdLevel level = SimdLevel::AVX2) {
+    fbm_noise_lanes(xs, &y, 0, out, outDx, outDy, n, p, octaves, w, level);
+}
+
+inline void fbm_noise_row_d(const float *xs, float y, float *out, float *outDx, float *outDy, int n,
+                            const uint8_t *p, int octaves, const FbmRuntimeWeights &w,
+                            SimdLevel level = SimdLevel::AVX2) {
+    with_fbm_weights(w, [&](const auto &weights) {
+        fbm_noise_lanes(xs, &y, 0, out, outDx, outDy, n, p, octaves, weights, level);
+    });
+}
+
+// Normalized fBm for any backend, gradient optional (outDx / outDy may be null).
+// PERLIN3D goes through the unrolled kernels above; the other backends run
+// one batch per octave over blocks of up to 256 samples on the stack.
+inline void fbm_noise_lanes(NoiseBackend backend, const float *xs, const float *ys, int yStride,
+                            float *out, float *outDx, float *outDy, int n, const uint8_t *p,
+                            int octaves, const FbmRuntimeWeights &w, SimdLevel level) {
+    if (backend == NoiseBackend::PERLIN3D) {
+        with_fbm_weights(w, [&](const auto &weights) {
+            fbm_noise_lanes(xs, ys, yStride, out, outDx, outDy, n, p, octaves, weights, level);
+        });
+        return;
+    }
+
+    octaves = octaves < 1 ? 1 : (octaves > FBM_MAX_OCTAVES ? FBM_MAX_OCTAVES : octaves);
+    const int BLOCK = 256;
+    float bx[BLOCK], by[BLOCK], bn[BLOCK], bdx[BLOCK], bdy[BLOCK];
+    for (int start = 0; start < n; start += BLOCK) {
+        int count = std::min(BLOCK, n - start);
+        float *o = out + start, *odx = outDx ? outDx + start : nullptr, *ody = outDy ? outDy + start : nullptr;
+        for (int i = 0; i < count; i++) {
+            o[i] = 0.0f;
+            if (odx) odx[i] = ody[i] = 0.0f;
+        }
+        for (int k = 0; k < octaves; k++) {
+            float amp = w.amp(k), freq = w.freq(k);
+            for (int i = 0; i < count; i++) {
+                bx[i] = xs[start + i] * freq;
+                by[i] = ys[yStride * (start + i)] * freq;
+            }
+            switch (clamp_simd_level(level)) {
+#if NOISE_SIMD_X86
+            case SimdLevel::AVX2:  noise_avx2::backend_row(backend, bx, by, 1, bn, odx ? bdx : nullptr, bdy, count, p);  break;
+            case SimdLevel::SSE41: noise_sse41::backend_row(backend, bx, by, 1, bn, odx ? bdx : nullptr, bdy, count, p); break;
+#endif
+            default:               noise_scalar::backend_row(backend, bx, by, 1, bn, odx ? bdx : nullptr, bdy, count, p); break;
+            }
+            for (int i = 0; i < count; i++) o[i] += bn[i] * amp;
+            if (odx) {
+                for (int i = 0; i < count; i++) {
+                    odx[i] += bdx[i] * amp * freq;
+                    ody[i] += bdy[i] * amp * freq;
+                }
+            }
+        }
+        float invMax = 1.0f / w.max_height(octaves);
+        for (int i = 0; i < count; i++) {
+            o[i] = (o[i] + 1.0f) * invMax;
+            if (odx) {
+                odx[i] *= invMax;
+                ody[i] *= invMax;
+            }
+        }
+    }
+}
+
+// One row of samples sharing y.
+inline void fbm_noise_row(NoiseBackend backend, const float *xs, float y, float *out, float *outDx, float *outDy,
+                          int n, const uint8_t *p, int octaves, const FbmRuntimeWeights &w,
+                          SimdLevel level = SimdLevel::AVX2) {
+    fbm_noise_lanes(backend, xs, &y, 0, out, outDx, outDy, n, p, octaves, w, level);
+}
+
+// Arbitrary sample points (xs[i], ys[i]), e.g. domain-warped coordinates.
+inline void fbm_noise_points(NoiseBackend backend, const float *xs, const float *ys, float *out,
+                             float *outDx, float *outDy, int n, const uint8_t *p, int octaves,
+                             const FbmRuntimeWeights &w, SimdLevel level = SimdLevel::AVX2) {
+    fbm_noise_lanes(backend, xs, ys, 1, out, outDx, outDy, n, p, octaves, w, level);
+}
+
+// ----------------- multifractals -----------------
+// FBM is the plain normalized sum above. RIDGED and HYBRID are Musgrave's
+// ridged and hybrid multifractals, where each octave is weighted by the
+// octaves before it, so they are evaluated octave by octave with per-sample state.
+enum class FractalMode { FBM = 0, RIDGED = 1, HYBRID = 2 };
+const int FRACTAL_MODE_COUNT = 3;
+
+inline const char *fractal_mode_name(FractalMode mode) {
+    switch (mode) {
+    case FractalMode::RIDGED: return "ridged";
+    case FractalMode::HYBRID: return "hybrid";
+    default:                  return "fbm";
+    }
+}
+
+inline bool parse_fractal_mode(const std::string &name, FractalMode &mode) {
+    for (int i = 0; i < FRACTAL_MODE_COUNT; i++) {
+        if (name == fractal_mode_name((FractalMode)i)) {
+            mode = (FractalMode)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const float RIDGED_OFFSET = 1.0f, RIDGED_GAIN = 2.0f;
+const float HYBRID_OFFSET = 0.7f;
+
+// Evaluates one backend at the points (xs[i], ys[i]).
+inline void noise_points(NoiseBackend backend, const float *xs, const float *ys, float *out, float *outDx,
+                         float *outDy, int n, const uint8_t *p, SimdLevel level = SimdLevel::AVX2) {
+    switch (clamp_simd_level(level)) {
+#if NOISE_SIMD_X86
+    case SimdLevel::AVX2:  noise_avx2::backend_row(backend, xs, ys, 1, out, outDx, outDy, n, p);  return;
+    case SimdLevel::SSE41: noise_sse41::backend_row(backend, xs, ys, 1, out, outDx, outDy, n, p); return;
+#endif
+    default:               noise_scalar::backend_row(backend, xs, ys, 1, out, outDx, outDy, n, p); return;
+    }
+}
+
+// Ridged / hybrid multifractal at n points, normalized to roughly [0, 1] like
+// fbm_noise_points(), gradient optional. Octaves run over the samples still
+// active, packed into one batch. After each octave canStop(lo, hi) gets the
+// range the sample's final value can still end up in; returning true keeps
+// the current value and drops the sample from the remaining octaves.
+// Returns the number of skipped sample-octaves.
+template <class StopFn>
+inline long multifractal_noise_points(FractalMode mode, NoiseBackend backend, const float *xs, const float *ys,
+                                      float *out, float *outDx, float *outDy, int n, const uint8_t *p,
+                                      int octaves, const FbmRuntimeWeights &w, StopFn &&canStop,
+                                      SimdLevel level = SimdLevel::AVX2) {
+    octaves = octaves < 1 ? 1 : (octaves > FBM_MAX_OCTAVES ? FBM_MAX_OCTAVES : octaves);
+    const bool ridged = mode == FractalMode::RIDGED;
+    const bool withGradient = outDx != nullptr;
+
+    // ridged: the largest value the sum can reach. hybrid: half of that bound,
+    // since the chained weights keep it far from reachable (values stay under ~0.9)
+    const float norm = ridged ? w.max_height(octaves) : 0.5f * (1.0f + HYBRID_OFFSET) * w.max_height(octaves);
+
+    std::vector<float> sum(n, 0.0f), weight(n, 1.0f), sumDx(n, 0.0f), sumDy(n, 0.0f), weightDx(n, 0.0f), weightDy(n, 0.0f);
+    std::vector<int> active(n);
+    for (int i = 0; i < n; i++) active[i] = i;
+    std::vector<float> px(n), py(n), v(n), vx(n), vy(n);
+
+    float ampSuffix[FBM_MAX_OCTAVES + 1];       // sum of amp(r) for r >= k
+    ampSuffix[octaves] = 0.0f;
+    for (int r = octaves - 1; r >= 0; r--) ampSuffix[r] = ampSuffix[r + 1] + w.amp(r);
+
+    long skipped = 0;
+    for (int k = 0; k < octaves && !active.empty(); k++) {
+        const int count = (int)active.size();
+        const float amp = w.amp(k), freq = w.freq(k);
+        for (int j = 0; j < count; j++) {
+            px[j] = xs[active[j]] * freq;
+            py[j] = ys[active[j]] * freq;
+        }
+        noise_points(backend, px.data(), py.data(), v.data(), withGradient ? vx.data() : nullptr, vy.data(),
+                     count, p, level);
+
+        int kept = 0;
+        for (int j = 0; j < count; j++) {
+            const int i = active[j];
+            float sig, sigDx = 0.0f, sigDy = 0.0f;
+            if (ridged) {
+                // signal = (offset - |v|)^2 * weight, weight = clamp(signal * gain, 0, 1)
+                float s = v[j] < 0.0f ? -1.0f : 1.0f;
+                float a = RIDGED_OFFSET - std::fabs(v[j]);
+                sig = a * a * weight[i];
+                if (withGradient) {
+                    sigDx = -2.0f * a * s * vx[j] * freq * weight[i] + a * a * weightDx[i];
+                    sigDy = -2.0f * a * s * vy[j] * freq * weight[i] + a * a * weightDy[i];
+                }
+                sum[i] += sig * amp;
+                float g = sig * RIDGED_GAIN;
+                bool clamped = g <= 0.0f || g >= 1.0f;
+                weight[i] = g < 0.0f ? 0.0f : (g > 1.0f ? 1.0f : g);
+                weightDx[i] = clamped ? 0.0f : sigDx * RIDGED_GAIN;
+                weightDy[i] = clamped ? 0.0f : sigDy * RIDGED_GAIN;
+            } else {
+                // result += min(weight, 1) * signal, weight *= signal, signal = (v + offset) * amp
+                float signal = (v[j] + HYBRID_OFFSET) * amp;
+                float signalDx = withGradient ? vx[j] * freq * amp : 0.0f;
+                float signalDy = withGradient ? vy[j] * freq * amp : 0.0f;
+                if (k == 0) {
+                    sig = signal;
+                    sigDx = signalDx;
+                    sigDy = signalDy;
+                    weight[i] = signal;
+                    weightDx[i] = signalDx;
+                    weightDy[i] = signalDy;
+                } else {
+                    if (weight[i] > 1.0f) {
+                        weight[i] = 1.0f;
+                        weightDx[i] = weightDy[i] = 0.0f;
+                    }
+                    sig = weight[i] * signal;
+                    sigDx = weightDx[i] * signal + weight[i] * signalDx;
+                    sigDy = weightDy[i] * signal + weight[i] * signalDy;
+                    weight[i] = sig;
+                    weightDx[i] = sigDx;
+                    weightDy[i] = sigDy;
+                }
+                sum[i] += sig;
+            }
+            sumDx[i] += ridged ? sigDx * amp : sigDx;
+            sumDy[i] += ridged ? sigDy * amp : sigDy;
+
+            if (k + 1 == octaves) {
+                active[kept++] = i;
+                continue;
+            }
+
+            // bound what octaves k + 1 .. octaves - 1 can still add: the weight can at most
+            // grow by gain (ridged) or shrink by (1 + offset) * amp (hybrid) per octave
+            float rest = 0.0f, m = std::min(std::fabs(weight[i]), 1.0f);
+            for (int r = k + 1; r < octaves; r++) {
+                if (ridged) {
+                    if (m >= 1.0f) {
+                        rest += ampSuffix[r];
+                        break;
+                    }
+                    rest += w.amp(r) * m;
+                    m = std::min(m * RIDGED_GAIN, 1.0f);
+                } else {
+                    rest += m * (1.0f + HYBRID_OFFSET) * w.amp(r);
+                    m *= (1.0f + HYBRID_OFFSET) * w.amp(r);
+                }
+            }
+            float value = sum[i] / norm, spread = rest / norm;
+            float lo = ridged ? value : value - spread;
+            if (canStop(lo, value + spread)) skipped += octaves - 1 - k;
+            else active[kept++] = i;
+        }
+        active.resize(kept);
+    }
+
+    for (int i = 0; i < n; i++) {
+        out[i] = sum[i] / norm;
+        if (withGradient) {
+            outDx[i] = sumDx[i] / norm;
+            outDy[i] = sumDy[i] / norm;
+        }
+    }
+    return skipped;
+}
+
+// ----------------- volumes -----------------
+// Normalized 3D fBm ((sum + 1) / maxHeight) at (xs[i], y, z) for a row of n samples.
+inline void fbm3_noise_row(const float *xs, float y, float z, float *out, int n, const uint8_t *p, int octaves,
+                           const FbmRuntimeWeights &w, SimdLevel level = SimdLevel::AVX2) {
+    switch (clamp_simd_level(level)) {
+#if NOISE_SIMD_X86
+    case SimdLevel::AVX2:  noise_avx2::fbm3_row(xs, y, z, out, n, p, octaves, w.amps, w.freqs, w.max_height(octaves));  return;
+    case SimdLevel::SSE41: noise_sse41::fbm3_row(xs, y, z, out, n, p, octaves, w.amps, w.freqs, w.max_height(octaves)); return;
+#endif
+    default:               noise_scalar::fbm3_row(xs, y, z, out, n, p, octaves, w.amps, w.freqs, w.max_height(octaves)); return;
+    }
+}
+
+// Packs values[i] > 0 into bits (see sign_bits() in noise_kernels.inl).
+inline void density_sign_bits(const float *values, int n, uint64_t *bits, SimdLevel level = SimdLevel::AVX2) {
+    switch (clamp_simd_level(level)) {
+#if NOISE_SIMD_X86
+    case SimdLevel::AVX2:  noise_avx2::sign_bits(values, n, bits);  return;
+    case SimdLevel::SSE41: noise_sse41::sign_bits(values, n, bits); return;
+#endif
+    default:               noise_scalar::sign_bits(values, n, bits); return;
+    }
+}
+
+// ----------------- terrain graphs -----------------
+// Normalized terrain height of a preset at (xs[i], ys[i * yStride]) with its
+// slope per unit of sample coordinate (outDx / outDy optional), in one fused pass.
+inline void terrain_graph_lanes(TerrainPreset preset, NoiseBackend backend, const float *xs, const float *ys,
+                                int yStride, float *out, float *outDx, float *outDy, int n, const uint8_t *p,
+                                const TerrainGraphParams &gp, SimdLevel level = SimdLevel::AVX2) {
+    switch (clamp_simd_level(level)) {
+#if NOISE_SIMD_X86
+    case SimdLevel::AVX2:
+        noise_avx2::terrain_graph_lanes(preset, backend, xs, ys, yStride, out, outDx, outDy, n, p, gp);   return;
+    case SimdLevel::SSE41:
+        noise_sse41::terrain_graph_lanes(preset, backend, xs, ys, yStride, out, outDx, outDy, n, p, gp);  return;
+#endif
+    default:
+        noise_scalar::terrain_graph_lanes(preset, backend, xs, ys, yStride, out, outDx, outDy, n, p, gp); return;
+    }
+}
+
+#endif
@@ -1,61 +1,221 @@
-double fade(double t) { return t * t * t * (t * (t * 6 - 15) + 10); };
-    
-double lerp(double t, double a, double b) { return a + t * (b - a); }
-    
-double grad(int hash, double x, double y, double z) {
-   int h = hash & 15;                      // CONVERT LO 4 BITS OF HASH CODE
-   double u = h<8 ? x : y,                 // INTO 12 GRADIENT DIRECTIONS.
-          v = h<4 ? y : h==12||h==14 ? x : z;
-   return ((h&1) == 0 ? u : -u) + ((h&2) == 0 ? v : -v);
-}
-    
-double perlin_noise(float x, float y, std::vector<int> &p) {
-    double z = 0; // 112550190 : change z to constant to get 2D noise
-    
-    int X = (int)floor(x) & 255,                  // FIND UNIT CUBE THAT
-        Y = (int)floor(y) & 255,                  // CONTAINS POINT.
-        Z = (int)floor(z) & 255;
-    x -= floor(x);                                // FIND RELATIVE X,Y,Z
-    y -= floor(y);                                // OF POINT IN CUBE.
-    z -= floor(z);
-    double u = fade(x),                                // COMPUTE FADE CURVES
-           v = fade(y),                                // FOR EACH OF X,Y,Z.
-           w = fade(z);
-    int A = p[X  ]+Y, AA = p[A]+Z, AB = p[A+1]+Z,      // HASH COORDINATES OF
-        B = p[X+1]+Y, BA = p[B]+Z, BB = p[B+1]+Z;      // THE 8 CUBE CORNERS,
-
-    return lerp(w, lerp(v, lerp(u, grad(p[AA  ], x  , y  , z   ),  // AND ADD
-                                   grad(p[BA  ], x-1, y  , z   )), // BLENDED
-                           lerp(u, grad(p[AB  ], x  , y-1, z   ),  // RESULTS
-                                   grad(p[BB  ], x-1, y-1, z   ))),// FROM  8
-                   lerp(v, lerp(u, grad(p[AA+1], x  , y  , z-1 ),  // CORNERS
-                                   grad(p[BA+1], x-1, y  , z-1 )), // OF CUBE
-                           lerp(u, grad(p[AB+1], x  , y-1, z-1 ),
-                                   grad(p[BB+1], x-1, y-1, z-1 ))));
-}
-
-std::vector<int> get_permutation_vector () {
-    std::vector<int> p;
-
-    std::vector<int> permutation = { 151,160,137,91,90,15,
-    131,13,201,95,96,53,194,233,7,225,140,36,103,30,69,142,8,99,37,240,21,10,23,
-    190, 6,148,247,120,234,75,0,26,197,62,94,252,219,203,117,35,11,32,57,177,33,
-    88,237,149,56,87,174,20,125,136,171,168, 68,175,74,165,71,134,139,48,27,166,
-    77,146,158,231,83,111,229,122,60,211,133,230,220,105,92,41,55,46,245,40,244,
-    102,143,54, 65,25,63,161, 1,216,80,73,209,76,132,187,208, 89,18,169,200,196,
-    135,130,116,188,159,86,164,100,109,198,173,186, 3,64,52,217,226,250,124,123,
-    5,202,38,147,118,126,255,82,85,212,207,206,59,227,47,16,58,17,182,189,28,42,
-    223,183,170,213,119,248,152, 2,44,154,163, 70,221,153,101,155,167, 43,172,9,
-    129,22,39,253, 19,98,108,110,79,113,224,232,178,185, 112,104,218,246,97,228,
-    251,34,242,193,238,210,144,12,191,179,162,241, 81,51,145,235,249,14,239,107,
-    49,192,214, 31,181,199,106,157,184, 84,204,176,115,121,50,45,127, 4,150,254,
-    138,236,205,93,222,114,67,29,24,72,243,141,128,195,78,66,215,61,156,180
-    };
-
-    for (int j = 0; j < 2; j++)
-        for (int i=0; i < 256; i++) {
-            p.push_back(permutation[i]);
-        }
-    
-    return p;
-}
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+
+double fade(double t) { return t * t * t * (t * (t * 6 - 15) + 10); };
+    
+double lerp(double t, double a, double b) { return a + t * (b - a); }
+    
+double grad(int hash, double x, double y, double z) {
+   int h = hash & 15;                      // CONVERT LO 4 BITS OF HASH CODE
+   double u = h<8 ? x : y,                 // INTO 12 GRADIENT DIRECTIONS.
+          v = h<4 ? y : h==12||h==14 ? x : z;
+   return ((h&1) == 0 ? u : -u) + ((h&2) == 0 ? v : -v);
+}
+    
+double perlin_noise(float x, float y, const uint8_t *p) {
+    double z = 0; // 112550190 : change z to constant to get 2D noise
+    
+    int X = (int)floor(x) & 255,                  // FIND UNIT CUBE THAT
+        Y = (int)floor(y) & 255,                  // CONTAINS POINT.
+        Z = (int)floor(z) & 255;
+    x -= floor(x);                                // FIND RELATIVE X,Y,Z
+    y -= floor(y);                                // OF POINT IN CUBE.
+    z -= floor(z);
+    double u = fade(x),                                // COMPUTE FADE CURVES
+           v = fade(y),                                // FOR EACH OF X,Y,Z.
+           w = fade(z);
+    int A = p[X  ]+Y, AA = p[A]+Z, AB = p[A+1]+Z,      // HASH COORDINATES OF
+        B = p[X+1]+Y, BA = p[B]+Z, BB = p[B+1]+Z;      // THE 8 CUBE CORNERS,
+
+    return lerp(w, lerp(v, lerp(u, grad(p[AA  ], x  , y  , z   ),  // AND ADD
+                                   grad(p[BA  ], x-1, y  , z   )), // BLENDED
+                           lerp(u, grad(p[AB  ], x  , y-1, z   ),  // RESULTS
+                                   grad(p[BB  ], x-1, y-1, z   ))),// FROM  8
+                   lerp(v, lerp(u, grad(p[AA+1], x  , y  , z-1 ),  // CORNERS
+                                   grad(p[BA+1], x-1, y  , z-1 )), // OF CUBE
+                           lerp(u, grad(p[AB+1], x  , y-1, z-1 ),
+                                   grad(p[BB+1], x-1, y-1, z-1 ))));
+}
+
+double dfade(double t) { return 30 * t * t * (t * (t - 2) + 1); }
+
+// grad() with z == 0, as the gradient vector it dots with (x, y).
+void grad_vec(int hash, double &gx, double &gy) {
+   int h = hash & 15;
+   double su = (h&1) == 0 ? 1 : -1,
+          sv = (h&2) == 0 ? 1 : -1;
+   gx = h<8 ? su : h==12||h==14 ? sv : 0;
+   gy = h<8 ? (h<4 ? sv : 0) : su;
+}
+
+// perlin_noise() plus its analytic partial derivatives d/dx and d/dy.
+double perlin_noise_d(float x, float y, const uint8_t *p, double &dx, double &dy) {
+    int X = (int)floor(x) & 255,
+        Y = (int)floor(y) & 255;
+    double fx = x - floor(x),
+           fy = y - floor(y);
+    double u = fade(fx), du = dfade(fx),
+           v = fade(fy), dv = dfade(fy);
+    int A = p[X  ]+Y, AA = p[A], AB = p[A+1],
+        B = p[X+1]+Y, BA = p[B], BB = p[B+1];
+
+    double gx00, gy00, gx10, gy10, gx01, gy01, gx11, gy11;
+    grad_vec(p[AA], gx00, gy00);
+    grad_vec(p[BA], gx10, gy10);
+    grad_vec(p[AB], gx01, gy01);
+    grad_vec(p[BB], gx11, gy11);
+    double n00 = gx00 * fx     + gy00 * fy,
+           n10 = gx10 * (fx-1) + gy10 * fy,
+           n01 = gx01 * fx     + gy01 * (fy-1),
+           n11 = gx11 * (fx-1) + gy11 * (fy-1);
+
+    dx = lerp(v, lerp(u, gx00, gx10), lerp(u, gx01, gx11)) + du * (lerp(v, n10, n11) - lerp(v, n00, n01));
+    dy = lerp(v, lerp(u, gy00, gy10), lerp(u, gy01, gy11)) + dv * (lerp(u, n01, n11) - lerp(u, n00, n10));
+    return lerp(v, lerp(u, n00, n10), lerp(u, n01, n11));
+}
+
+// Ken Perlin's reference permutation, used as-is for seed 0 so the default
+// world looks the same as before seeding existed.
+static const uint8_t PERLIN_PERMUTATION[256] = { 151,160,137,91,90,15,
+    131,13,201,95,96,53,194,233,7,225,140,36,103,30,69,142,8,99,37,240,21,10,23,
+    190, 6,148,247,120,234,75,0,26,197,62,94,252,219,203,117,35,11,32,57,177,33,
+    88,237,149,56,87,174,20,125,136,171,168, 68,175,74,165,71,134,139,48,27,166,
+    77,146,158,231,83,111,229,122,60,211,133,230,220,105,92,41,55,46,245,40,244,
+    102,143,54, 65,25,63,161, 1,216,80,73,209,76,132,187,208, 89,18,169,200,196,
+    135,130,116,188,159,86,164,100,109,198,173,186, 3,64,52,217,226,250,124,123,
+    5,202,38,147,118,126,255,82,85,212,207,206,59,227,47,16,58,17,182,189,28,42,
+    223,183,170,213,119,248,152, 2,44,154,163, 70,221,153,101,155,167, 43,172,9,
+    129,22,39,253, 19,98,108,110,79,113,224,232,178,185, 112,104,218,246,97,228,
+    251,34,242,193,238,210,144,12,191,179,162,241, 81,51,145,235,249,14,239,107,
+    49,192,214, 31,181,199,106,157,184, 84,204,176,115,121,50,45,127, 4,150,254,
+    138,236,205,93,222,114,67,29,24,72,243,141,128,195,78,66,215,61,156,180
+    };
+
+// Per-world permutation table, built once per seed and shared read-only by
+// every chunk and generation thread. The doubled 512-entry table is uint8 and
+// 64-byte aligned, so all of it stays in 8 L1 cache lines.
+struct NoiseContext {
+    uint32_t seed;
+    const uint8_t *perm;            // 512 entries (+3 bytes slack for 32-bit SIMD gathers)
+
+    explicit NoiseContext(uint32_t _seed) : seed(_seed) {
+        uint8_t *table = storage + ((64 - (uintptr_t)storage % 64) % 64);
+
+        uint8_t shuffled[256];
+        std::memcpy(shuffled, PERLIN_PERMUTATION, 256);
+        if (seed != 0) {
+            // Fisher-Yates on raw mt19937 output (std::shuffle is not portable
+            // across standard libraries, and the same seed must give the same world everywhere)
+            std::mt19937 rng(seed);
+            for (int i = 255; i > 0; i--) std::swap(shuffled[i], shuffled[rng() % (uint32_t)(i + 1)]);
+        }
+        for (int i = 0; i < 512; i++) table[i] = shuffled[i & 255];
+        std::memset(table + 512, 0, 4);
+        perm = table;
+    }
+    NoiseContext(const NoiseContext &) = delete;
+    NoiseContext &operator=(const NoiseContext &) = delete;
+
+private:
+    uint8_t storage[64 + 512 + 4];
+};
+
+// Returns the shared context for a seed, building it on first use.
+inline std::shared_ptr<const NoiseContext> get_noise_context(uint32_t seed) {
+    static std::mutex mutex;
+    static std::map<uint32_t, std::shared_ptr<const NoiseContext>> cache;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<const NoiseContext> &ctx = cache[seed];
+    if (!ctx) ctx = std::make_shared<NoiseContext>(seed);
+    return ctx;
+}
+
+// ----------------- fixed point (Q16.16) -----------------
+// Integer-only Perlin noise and fBm. Every step is an integer add, multiply or
+// shift (right shifts of negative values are arithmetic on every gcc / clang
+// target we build for), so the output is bit-identical across compilers,
+// optimization flags and CPUs, unlike the double path above.
+const int32_t FIXED_ONE = 1 << 16;
+
+inline int64_t fixed_mul(int64_t a, int64_t b) { return (a * b) >> 16; }
+
+inline int64_t fade_fixed(int64_t t) {
+    return fixed_mul(fixed_mul(fixed_mul(t, t), t), fixed_mul(t, 6 * t - 15 * FIXED_ONE) + 10 * FIXED_ONE);
+}
+
+inline int64_t lerp_fixed(int64_t t, int64_t a, int64_t b) { return a + fixed_mul(t, b - a); }
+
+// grad() with z == 0.
+inline int64_t grad_fixed(int hash, int64_t x, int64_t y) {
+    int h = hash & 15;
+    int64_t u = h<8 ? x : y,
+            v = h<4 ? y : h==12||h==14 ? x : 0;
+    return ((h&1) == 0 ? u : -u) + ((h&2) == 0 ? v : -v);
+}
+
+// perlin_noise() on Q16.16 coordinates, returning a Q16.16 value.
+inline int32_t perlin_noise_fixed(int32_t x, int32_t y, const uint8_t *p) {
+    int X = (x >> 16) & 255,
+        Y = (y >> 16) & 255;
+    int64_t fx = x & (FIXED_ONE - 1),
+            fy = y & (FIXED_ONE - 1);
+    int64_t u = fade_fixed(fx),
+            v = fade_fixed(fy);
+    int A = p[X  ]+Y, AA = p[A], AB = p[A+1],
+        B = p[X+1]+Y, BA = p[B], BB = p[B+1];
+
+    return (int32_t)lerp_fixed(v, lerp_fixed(u, grad_fixed(p[AA], fx            , fy            ),
+                                                grad_fixed(p[BA], fx - FIXED_ONE, fy            )),
+                                  lerp_fixed(u, grad_fixed(p[AB], fx            , fy - FIXED_ONE),
+                                                grad_fixed(p[BB], fx - FIXED_ONE, fy - FIXED_ONE)));
+}
+
+// Q16.16 octave amplitudes and frequencies. They are built with plain float
+// multiplies (exact IEEE operations, no libm) and rounded once, so every build
+// derives the same integers from the same persistence and lacunarity.
+struct FixedFbmWeights {
+    int octaves;
+    int64_t amps[12], freqs[12], maxHeight;
+
+    FixedFbmWeights(int _octaves, float persistence, float lacunarity) : octaves(_octaves), maxHeight(0) {
+        float amp = 1.0f, freq = 1.0f;
+        for (int i = 0; i < octaves; i++) {
+            amps[i] = std::lround(amp * FIXED_ONE);
+            freqs[i] = std::lround(freq * FIXED_ONE);
+            maxHeight += amps[i];
+            amp *= persistence;
+            freq *= lacunarity;
+        }
+    }
+};
+
+// fBm of perlin_noise_fixed normalized like the float path, (sum + 1) / maxHeight, in Q16.16.
+inline int32_t fbm_noise_fixed(int32_t x, int32_t y, const uint8_t *p, const FixedFbmWeights &w) {
+    int64_t sum = 0;
+    for (int i = 0; i < w.octaves; i++) {
+        // coordinates wrap every 65536 units, a multiple of the 256-unit lattice period
+        int32_t xi = (int32_t)(uint32_t)fixed_mul(x, w.freqs[i]),
+                yi = (int32_t)(uint32_t)fixed_mul(y, w.freqs[i]);
+        sum += fixed_mul(perlin_noise_fixed(xi, yi, p), w.amps[i]);
+    }
+    return (int32_t)((sum + FIXED_ONE) * FIXED_ONE / w.maxHeight);
+}
+
+// 64-bit FNV-1a over Q16.16 values, byte by byte in little-endian order so the
+// hash does not depend on the host's byte order.
+inline uint64_t fixed_content_hash(const int32_t *values, size_t n, uint64_t hash = 0xcbf29ce484222325ull) {
+    for (size_t i = 0; i < n; i++) {
+        uint32_t v = (uint32_t)values[i];
+        for (int b = 0; b < 4; b++) {
+            hash ^= (v >> (8 * b)) & 0xff;
+            hash *= 0x100000001b3ull;
+        }
+    }
+    return hash;
+}
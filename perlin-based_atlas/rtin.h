@@ -0,0 +1,130 @@
+#ifndef RTIN_H
+#define RTIN_H
+
+// Right-triangulated irregular network mesher (the Martini scheme) for a
+// square height grid of 2^k + 1 samples a side. The grid is covered by a
+// binary tree of right isosceles triangles: the two halves of the square,
+// each split at the midpoint of its hypotenuse, and so on down to single
+// half-quads. Every triangle is kept if replacing it by its two children
+// would change the surface by no more than the allowed error, and is split
+// otherwise.
+//
+// rtin_errors stores, per grid vertex, a bound on how far the triangles whose
+// hypotenuse midpoint it is lie from the grid samples they cover. A triangle's
+// plane and its two children's differ by a tent that is zero at its corners
+// and peaks at the midpoint, so its error is at most the midpoint error plus
+// the larger child error (Martini itself takes the max of the two, which is
+// not a bound). Errors grow towards the root, so a triangle is split whenever
+// anything below it needs to be, and since the two triangles sharing a
+// hypotenuse test the same midpoint they split together: the mesh never has
+// T-junctions.
+//
+// The triangles and per-vertex errors depend only on the grid size and the
+// heights, so meshing different chunks in parallel needs no locking: share
+// one RtinTile and give each thread its own error array.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+struct RtinTile {
+    int gridSize = 0;
+    std::vector<uint16_t> coords;   // ax, ay, bx, by (hypotenuse ends) per triangle, smallest last
+};
+
+inline bool rtin_grid_size_ok(int gridSize) {
+    return gridSize >= 3 && ((gridSize - 1) & (gridSize - 2)) == 0;
+}
+
+inline void rtin_build_tile(int gridSize, RtinTile &tile) {
+    const int tileSize = gridSize - 1;
+    const int nTriangles = tileSize * tileSize * 2 - 2;
+    tile.gridSize = gridSize;
+    tile.coords.resize((size_t)nTriangles * 4);
+    for (int i = 0; i < nTriangles; i++) {
+        // the triangle's id spells its path from the root: 2 or 3, then one bit per split
+        int id = i + 2;
+        int ax = 0, ay = 0, bx = 0, by = 0, cx = 0, cy = 0;
+        if (id & 1) bx = by = cx = tileSize;
+        else ax = ay = cy = tileSize;
+        while ((id >>= 1) > 1) {
+            int mx = (ax + bx) >> 1, my = (ay + by) >> 1;
+            if (id & 1) {   // left child
+                bx = ax; by = ay;
+                ax = cx; ay = cy;
+            } else {        // right child
+                ax = bx; ay = by;
+                bx = cx; by = cy;
+            }
+            cx = mx; cy = my;
+        }
+        tile.coords[4 * i + 0] = (uint16_t)ax;
+        tile.coords[4 * i + 1] = (uint16_t)ay;
+        tile.coords[4 * i + 2] = (uint16_t)bx;
+        tile.coords[4 * i + 3] = (uint16_t)by;
+    }
+}
+
+// Per-vertex split errors of one height grid: height of vertex (x, y) is
+// heights[(x + y * gridSize) * stride]. With lockBorder the border vertices
+// get an infinite error, so border edges always come out at full resolution
+// and match whatever the neighbouring grid chose on its side.
+inline void rtin_errors(const RtinTile &tile, const float *heights, int stride, bool lockBorder,
+                        std::vector<float> &errors) {
+    const int size = tile.gridSize, tileSize = size - 1;
+    const int nTriangles = (int)tile.coords.size() / 4, nParents = nTriangles - tileSize * tileSize;
+    auto height = [&](int x, int y) { return heights[(size_t)(x + y * size) * stride]; };
+
+    errors.assign((size_t)size * size, 0.0f);
+    if (lockBorder) {
+        for (int i = 0; i < size; i++) {
+            errors[i] = errors[i + (size_t)tileSize * size] = INFINITY;
+            errors[(size_t)i * size] = errors[tileSize + (size_t)i * size] = INFINITY;
+        }
+    }
+
+    for (int i = nTriangles - 1; i >= 0; i--) {
+        const int ax = tile.coords[4 * i + 0], ay = tile.coords[4 * i + 1];
+        const int bx = tile.coords[4 * i + 2], by = tile.coords[4 * i + 3];
+        const int mx = (ax + bx) >> 1, my = (ay + by) >> 1;
+        const int cx = mx + my - ay, cy = my + ax - mx;
+        const size_t middle = (size_t)mx + (size_t)my * size;
+
+        float error = std::fabs(0.5f * (height(ax, ay) + height(bx, by)) - height(mx, my));
+        if (i < nParents) {
+            size_t left = (size_t)((ax + cx) >> 1) + (size_t)((ay + cy) >> 1) * size;
+            size_t right = (size_t)((bx + cx) >> 1) + (size_t)((by + cy) >> 1) * size;
+            error += std::max(errors[left], errors[right]);
+        }
+        errors[middle] = std::max(errors[middle], error);
+    }
+}
+
+// Triangles of the mesh within maxError, as vertex indices x + y * gridSize,
+// wound like the full grid's triangles.
+inline void rtin_mesh(const RtinTile &tile, const std::vector<float> &errors, float maxError,
+                      std::vector<int> &indices) {
+    const int size = tile.gridSize, tileSize = size - 1;
+    indices.clear();
+
+    struct Triangle { int ax, ay, bx, by, cx, cy; };
+    std::vector<Triangle> stack;
+    stack.push_back({ tileSize, tileSize, 0, 0, 0, tileSize });
+    stack.push_back({ 0, 0, tileSize, tileSize, tileSize, 0 });
+    while (!stack.empty()) {
+        Triangle t = stack.back();
+        stack.pop_back();
+        const int mx = (t.ax + t.bx) >> 1, my = (t.ay + t.by) >> 1;
+        if (std::abs(t.ax - t.cx) + std::abs(t.ay - t.cy) > 1 && errors[(size_t)mx + (size_t)my * size] > maxError) {
+            stack.push_back({ t.bx, t.by, t.cx, t.cy, mx, my });
+            stack.push_back({ t.cx, t.cy, t.ax, t.ay, mx, my });
+        } else {
+            indices.push_back(t.ax + t.ay * size);
+            indices.push_back(t.cx + t.cy * size);
+            indices.push_back(t.bx + t.by * size);
+        }
+    }
+}
+
+#endif
@@ -1,34 +1,149 @@
-#version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
-layout (location = 2) in vec3 aColor;
-layout (location = 3) in vec3 aOffset;
-
-out vec3 vWorldPos;
-out vec3 vNormal;
-out vec3 vBaseColor;
-out vec2 vSeedXZ;     // for stable random per instance
-out float vLocalY;    // for canopy mask
-
-uniform mat4 u_model;
-uniform mat4 u_view;
-uniform mat4 u_projection;
-
-void main() {
-    // instancing position
-    vec3 localPos = aPos + aOffset;
-    vec4 worldPos4 = u_model * vec4(localPos, 1.0);
-    vWorldPos = worldPos4.xyz;
-
-    // correct normal with scaling
-    mat3 normalMat = transpose(inverse(mat3(u_model)));
-    vNormal = normalize(normalMat * aNormal);
-
-    vBaseColor = aColor;
-
-    // stable seed (do NOT use world pos because u_model changes per chunk)
-    vSeedXZ = aOffset.xz;
-    vLocalY = aPos.y;
-
-    gl_Position = u_projection * u_view * worldPos4;
-}
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec3 aColor;
+layout (location = 3) in vec3 aOffset;
+
+out vec3 vWorldPos;
+out vec3 vNormal;
+out vec3 vBaseColor;
+out vec2 vSeedXZ;     // for stable random per instance
+out float vLocalY;    // for canopy mask
+out vec2 vGridXZ;
+flat out vec3 vFlatColor;
+flat out vec3 vFaceNormalLo;
+flat out vec3 vFaceNormalHi;
+flat out vec2 vFlatOrigin;
+
+uniform mat4 u_model;
+uniform mat4 u_view;
+uniform mat4 u_projection;
+
+// Terrain chunks are packed (see upload_map_chunk): 1 = grid chunk, aPos.x is
+// the unorm16 height and x / z come from gl_VertexID; 2 = volume chunk, aPos
+// is the unorm16 position. Both carry an octahedral normal in aNormal.xy
+// (bytes, -127..127) and an RGBA8 color. 0 = plain float attributes (plants).
+uniform int u_terrainFormat;
+uniform int u_gridWidth;
+uniform int u_gridHeight;
+uniform vec3 u_terrainExtent;   // chunk-local box the unorm16 coordinates span
+
+// CDLOD (see cdlod_select): a grid chunk node drawn at step u_lodStep (0 = full
+// detail, no morph) slides its odd vertices onto the next level's grid between
+// u_morphRange.x and .y from the camera. The target vertex is fetched from the
+// chunk's own buffers: u_heightTexels is the vertex VBO as RG16 (height,
+// normal bytes), u_colorTexels the color VBO.
+uniform int u_lodStep;
+uniform vec2 u_morphRange;
+uniform vec3 u_viewPos;
+uniform samplerBuffer u_heightTexels;
+uniform samplerBuffer u_colorTexels;
+
+// Flat (low-poly) shading, isFlat: a triangle takes its color and face normal
+// from its provoking (last) vertex, passed flat, so no vertex is duplicated.
+// In the grid index orders (see generate_indices) every vertex provokes two
+// triangles, one on either side of it, so a grid vertex works out both face
+// normals from its neighbours and the fragment shader picks one by side:
+// u_flatPattern 1 = triangle lists, sides split by the anti-diagonal through
+// the vertex; 2 = strips, split by its row. 0 = meshes with their own index
+// lists, which the fragment shader flat-shades from position derivatives.
+uniform bool isFlat;
+uniform int u_flatPattern;
+
+vec3 oct_decode(vec2 e) {
+    vec3 n = vec3(e.x, 1.0 - abs(e.x) - abs(e.y), e.y);
+    if (n.y < 0.0)
+        n.xz = (1.0 - abs(n.zx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.z >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
+vec3 texel_normal(float g) {
+    uint bits = uint(g * 65535.0 + 0.5);
+    vec2 e = vec2(float(int(bits << 24) >> 24), float(int(bits << 16) >> 24));
+    return oct_decode(clamp(e / 127.0, -1.0, 1.0));
+}
+
+// odd along x or z at this step, except on the chunk border, which every level shares
+ivec2 morph_offset(ivec2 g) {
+    return ivec2(g.x % (2 * u_lodStep) == u_lodStep && g.x != u_gridWidth - 1 ? u_lodStep : 0,
+                 g.y % (2 * u_lodStep) == u_lodStep && g.y != u_gridHeight - 1 ? u_lodStep : 0);
+}
+
+float morph_factor(vec3 pos) {
+    float dist = distance((u_model * vec4(pos, 1.0)).xyz, u_viewPos);
+    return clamp((dist - u_morphRange.x) / (u_morphRange.y - u_morphRange.x), 0.0, 1.0);
+}
+
+vec3 grid_texel(ivec2 g) {
+    return vec3(float(g.x), texelFetch(u_heightTexels, g.x + g.y * u_gridWidth).r * u_terrainExtent.y, float(g.y));
+}
+
+// grid vertex g where this draw puts it, morph included
+vec3 grid_vertex(ivec2 g) {
+    g = clamp(g, ivec2(0), ivec2(u_gridWidth - 1, u_gridHeight - 1));
+    vec3 pos = grid_texel(g);
+    if (u_lodStep > 0) {
+        ivec2 d = morph_offset(g);
+        float k = morph_factor(pos);
+        if (k > 0.0 && d != ivec2(0)) pos = mix(pos, grid_texel(g - d), k);
+    }
+    return pos;
+}
+
+vec3 face_normal(vec3 a, vec3 b, vec3 c) {
+    vec3 n = cross(b - a, c - a);
+    return n.y < 0.0 ? -n : n;     // height-field faces point up
+}
+
+void main() {
+    vec3 pos = aPos;
+    vec3 normal = aNormal;
+    vec3 faceLo = vec3(0.0, 1.0, 0.0), faceHi = faceLo;
+    vBaseColor = aColor;
+    if (u_terrainFormat == 1) {
+        pos = vec3(float(gl_VertexID % u_gridWidth), aPos.x * u_terrainExtent.y, float(gl_VertexID / u_gridWidth));
+        normal = oct_decode(clamp(aNormal.xy / 127.0, -1.0, 1.0));
+        ivec2 g = ivec2(gl_VertexID % u_gridWidth, gl_VertexID / u_gridWidth);
+        if (u_lodStep > 0) {
+            ivec2 d = morph_offset(g);
+            float k = morph_factor(pos);
+            if (k > 0.0 && d != ivec2(0)) {
+                int target = (g.x - d.x) + (g.y - d.y) * u_gridWidth;
+                vec2 hn = texelFetch(u_heightTexels, target).rg;
+                pos = mix(pos, vec3(vec2(g - d).x, hn.r * u_terrainExtent.y, vec2(g - d).y), k);
+                normal = normalize(mix(normal, texel_normal(hn.g), k));
+                vBaseColor = mix(aColor, texelFetch(u_colorTexels, target).rgb, k);
+            }
+        }
+        if (isFlat && u_flatPattern != 0) {
+            int s = max(u_lodStep, 1);
+            faceLo = face_normal(grid_vertex(g - ivec2(s, 0)), grid_vertex(g - ivec2(s)), pos);
+            faceHi = u_flatPattern == 1
+                ? face_normal(grid_vertex(g + ivec2(s, 0)), grid_vertex(g + ivec2(s)), pos)
+                : face_normal(grid_vertex(g - ivec2(s, 0)), grid_vertex(g + ivec2(0, s)), pos);
+        }
+    } else if (u_terrainFormat == 2) {
+        pos = aPos * u_terrainExtent;
+        normal = oct_decode(clamp(aNormal.xy / 127.0, -1.0, 1.0));
+    }
+
+    // instancing position
+    vec3 localPos = pos + aOffset;
+    vec4 worldPos4 = u_model * vec4(localPos, 1.0);
+    vWorldPos = worldPos4.xyz;
+
+    // correct normal with scaling
+    mat3 normalMat = transpose(inverse(mat3(u_model)));
+    vNormal = normalize(normalMat * normal);
+    vFaceNormalLo = normalize(normalMat * faceLo);
+    vFaceNormalHi = normalize(normalMat * faceHi);
+    vFlatColor = vBaseColor;
+    vGridXZ = pos.xz;
+    vFlatOrigin = pos.xz;
+
+    // stable seed (do NOT use world pos because u_model changes per chunk)
+    vSeedXZ = aOffset.xz;
+    vLocalY = pos.y;
+
+    gl_Position = u_projection * u_view * worldPos4;
+}
@@ -0,0 +1,135 @@
+#ifndef SURFACE_NETS_H
+#define SURFACE_NETS_H
+
+// Surface Nets mesher for a chunk's density grid (density > 0 is solid).
+// Every cell the surface passes through gets one vertex, at the mean of the
+// cell's edge crossings, and every grid edge that crosses the surface gets one
+// quad joining the four cells around it. Vertices are therefore shared by
+// construction and there is nothing to weld afterwards.
+//
+// Cells are classified 64 at a time: each sample row is packed into sign bits
+// with SIMD compares (density_sign_bits), and a cell is on the surface when its
+// 8 corner bits are neither all set nor all clear, which is a handful of word
+// operations per 64 cells. Only those cells are visited.
+//
+// Layout: density[x + nx * (z + nz * y)], samples `step` apart. A quad is only
+// emitted when all four of its cells lie inside the grid, so a grid that
+// overlaps its +x / +z neighbour by one cell meets it with no gap and no
+// duplicated faces.
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "noise_simd.h"
+
+struct SurfaceMesh {
+    std::vector<float> positions;   // x, y, z per vertex
+    std::vector<float> normals;     // unit, pointing from solid into empty space
+    std::vector<int> indices;       // triangles
+};
+
+inline void surface_nets(const float *density, int nx, int ny, int nz, float step, SurfaceMesh &mesh,
+                         SimdLevel level = SimdLevel::AVX2) {
+    mesh.positions.clear();
+    mesh.normals.clear();
+    mesh.indices.clear();
+    const int ncx = nx - 1, ncy = ny - 1, ncz = nz - 1;
+    if (ncx < 1 || ncy < 1 || ncz < 1) return;
+
+    // sign bits of every sample row
+    const int words = (nx + 63) / 64;
+    std::vector<uint64_t> bits((size_t)ny * nz * words);
+    for (int y = 0; y < ny; y++)
+        for (int z = 0; z < nz; z++) {
+            int row = z + nz * y;
+            density_sign_bits(density + (size_t)nx * row, nx, &bits[(size_t)row * words], level);
+        }
+
+    // corner c = dx + 2 dy + 4 dz sits at this sample offset
+    const int strideY = nx * nz, strideZ = nx;
+    int cornerOffset[8];
+    for (int c = 0; c < 8; c++) cornerOffset[c] = (c & 1) + ((c >> 1) & 1) * strideY + ((c >> 2) & 1) * strideZ;
+
+    std::vector<int> cellVertex((size_t)ncx * ncy * ncz, -1);
+    auto cell_index = [&](int x, int y, int z) { return x + ncx * (z + ncz * y); };
+
+    for (int cy = 0; cy < ncy; cy++) {
+        for (int cz = 0; cz < ncz; cz++) {
+            const uint64_t *rows[4] = {
+                &bits[(size_t)(cz + nz * cy) * words],     &bits[(size_t)(cz + nz * (cy + 1)) * words],
+                &bits[(size_t)(cz + 1 + nz * cy) * words], &bits[(size_t)(cz + 1 + nz * (cy + 1)) * words] };
+
+            for (int word = 0; word * 64 < ncx; word++) {
+                uint64_t all = ~0ull, any = 0;
+                for (const uint64_t *r : rows) {
+                    uint64_t lo = r[word], hi = (r[word] >> 1) | (word + 1 < words ? r[word + 1] << 63 : 0);
+                    all &= lo & hi;
+                    any |= lo | hi;
+                }
+                uint64_t mixed = any & ~all;
+                if (ncx - word * 64 < 64) mixed &= (1ull << (ncx - word * 64)) - 1;
+
+                for (; mixed; mixed &= mixed - 1) {
+                    const int cx = word * 64 + __builtin_ctzll(mixed);
+                    const float *base = density + cx + (size_t)nx * (cz + nz * cy);
+                    float v[8];
+                    for (int c = 0; c < 8; c++) v[c] = base[cornerOffset[c]];
+
+                    // mean of the edge crossings
+                    float px = 0.0f, py = 0.0f, pz = 0.0f;
+                    int crossings = 0;
+                    for (int a = 0; a < 8; a++) {
+                        for (int axis = 1; axis < 8; axis <<= 1) {
+                            if (a & axis) continue;
+                            int b = a | axis;
+                            if ((v[a] > 0.0f) == (v[b] > 0.0f)) continue;
+                            float t = v[a] / (v[a] - v[b]);
+                            px += (a & 1) + (axis == 1 ? t : 0.0f);
+                            py += ((a >> 1) & 1) + (axis == 2 ? t : 0.0f);
+                            pz += ((a >> 2) & 1) + (axis == 4 ? t : 0.0f);
+                            crossings++;
+                        }
+                    }
+
+                    // density gradient over the cell (mean of the four forward differences per axis)
+                    float gx = (v[1] - v[0]) + (v[3] - v[2]) + (v[5] - v[4]) + (v[7] - v[6]);
+                    float gy = (v[2] - v[0]) + (v[3] - v[1]) + (v[6] - v[4]) + (v[7] - v[5]);
+                    float gz = (v[4] - v[0]) + (v[5] - v[1]) + (v[6] - v[2]) + (v[7] - v[3]);
+                    float len = std::sqrt(gx * gx + gy * gy + gz * gz);
+                    float inv = len > 0.0f ? -1.0f / len : 0.0f;
+
+                    const int vertex = (int)(mesh.positions.size() / 3);
+                    cellVertex[cell_index(cx, cy, cz)] = vertex;
+                    mesh.positions.insert(mesh.positions.end(), { (cx + px / crossings) * step,
+                                                                  (cy + py / crossings) * step,
+                                                                  (cz + pz / crossings) * step });
+                    mesh.normals.insert(mesh.normals.end(), { gx * inv, gy * inv, gz * inv });
+
+                    // the three edges leaving corner 0; their other cells come earlier in this loop order
+                    const int cell[3] = { cx, cy, cz };
+                    for (int d = 0; d < 3; d++) {
+                        int u = (d + 1) % 3, w = (d + 2) % 3;
+                        if (cell[u] == 0 || cell[w] == 0) continue;
+                        bool solid0 = v[0] > 0.0f;
+                        if (solid0 == (v[1 << d] > 0.0f)) continue;
+
+                        int cu[3] = { cx, cy, cz }, cw[3] = { cx, cy, cz }, cuw[3] = { cx, cy, cz };
+                        cu[u]--;
+                        cw[w]--;
+                        cuw[u]--;
+                        cuw[w]--;
+                        int a = vertex,
+                            b = cellVertex[cell_index(cu[0], cu[1], cu[2])],
+                            c = cellVertex[cell_index(cuw[0], cuw[1], cuw[2])],
+                            e = cellVertex[cell_index(cw[0], cw[1], cw[2])];
+                        if (solid0) mesh.indices.insert(mesh.indices.end(), { a, b, c, a, c, e });
+                        else        mesh.indices.insert(mesh.indices.end(), { a, c, b, a, e, c });
+                    }
+                }
+            }
+        }
+    }
+}
+
+#endif
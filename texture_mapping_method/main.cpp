@@ -4,6 +4,14 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <climits>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
@@ -24,8 +32,17 @@ const GLint WIDTH = 1920, HEIGHT = 1080;
 float meshHeight = 160.0f;       // 地形高度
 float WATER_HEIGHT = 11.2f;      // 水面高度
 int chunk_render_distance = 8;  // 視距 (因為有優化，可以開遠一點)
-int xMapChunks = 20;
-int yMapChunks = 20;
+
+// --- 區塊串流 ---
+// 世界沒有邊界 (heightmap 鏡像延伸出去)：xMapChunks x yMapChunks 個區塊槽是跟著相機移動的
+// 環形視窗，區塊 (x, y) 放在槽 (x mod xMapChunks, y mod yMapChunks)。視窗是視距兩側再多
+// STREAM_HYSTERESIS 個區塊，離開視距的區塊要再走那麼遠才會被新區塊佔走槽位，來回走不會一直重建。
+// 每格最多建 STREAM_CHUNKS_PER_FRAME 個新區塊 (MESH 模式的網格也算在內)，槽的 VAO / VBO 都重複使用，顯存固定。
+const int STREAM_HYSTERESIS = 3;
+const int STREAM_CHUNKS_PER_FRAME = 2;
+const glm::ivec2 NO_CHUNK(INT_MIN, INT_MIN);
+int xMapChunks = 2 * chunk_render_distance + STREAM_HYSTERESIS + 1;
+int yMapChunks = 2 * chunk_render_distance + STREAM_HYSTERESIS + 1;
 int chunkWidth = 127;
 int chunkHeight = 127;
 
@@ -57,8 +74,51 @@ GLuint sandTex, grassTex, gravelTex, mossTex, rockTex, snowTex;
 
 std::vector<int> treeInstanceCounts(xMapChunks * yMapChunks, 0);
 std::vector<int> flowerInstanceCounts(xMapChunks * yMapChunks, 0);
+std::vector<GLuint> treeOffsetVBOs(xMapChunks * yMapChunks, 0);
+std::vector<GLuint> flowerOffsetVBOs(xMapChunks * yMapChunks, 0);
+std::vector<glm::ivec2> slotChunk(xMapChunks * yMapChunks, NO_CHUNK);      // 槽目前放的區塊
+std::vector<glm::ivec2> slotMeshChunk(xMapChunks * yMapChunks, NO_CHUNK);  // 槽的網格 (MESH 模式) 是哪個區塊的
+std::vector<GLuint> mapChunkVBOs(xMapChunks * yMapChunks, 0);
 int treeVCount = 0, flowerVCount = 0;
 
+// 所有地形區塊的三角形索引都一樣：只產生一次，並共用一份 uint16 索引緩衝
+// (127 x 127 = 16129 個頂點，16 位元放得下)，綁到每個區塊的 VAO 上
+std::vector<int> gridIndices;
+GLuint gridEBO = 0;
+
+// 壓縮地形頂點：16 位元高度 + 八面體編碼法線 (2 bytes)，共 4 bytes。
+// x / z 與 UV 在 shader 裡由 gl_VertexID 推出；地形顏色固定為白色，所以不再上傳顏色
+struct PackedTerrainVertex { uint16_t height; int8_t normal[2]; };
+
+// --- 幾何 clipmap ---
+// 以相機為中心的 CLIP_LEVELS 層固定網格，第 l 層格距 2^l 個 heightmap 取樣點。每層都是
+// (CLIP_N + 1)^2 個頂點，位置由 gl_VertexID 推出，高度從環形 (toroidal) 更新的紋理陣列讀取：
+// 取樣點 p 存在第 l 張的 (p mod CLIP_TEX)，相機移動時只重算新移進範圍的行 / 列。
+// 每層的原點對齊到下一層的格點，所以細一層剛好蓋住粗一層中間 CLIP_N / 2 見方的洞，
+// 洞的位置只有 4 種 (見 update_clipmap)，索引全部事先產生。地形成本與世界大小無關。
+const int CLIP_N = 252;          // 每層格數，需為 4 的倍數；253^2 個頂點用 uint16 索引放得下
+const int CLIP_LEVELS = 4;       // 最外層半徑約 CLIP_N * 2^(CLIP_LEVELS - 2) = 1008，和原本的視距相當
+const int CLIP_TEX = 256;        // 環形紋理大小，需 >= CLIP_N + 3 (網格外再多一圈給法線用)
+struct ClipLevel { int originX, originZ; bool valid; };   // 網格左上角，單位為這層的格距
+ClipLevel clipLevels[CLIP_LEVELS];
+GLuint clipVAO = 0, clipEBO = 0, clipHeightTex = 0;
+GLsizei clipFullCount = 0, clipRingCount = 0;
+size_t clipUploadedSamples = 0;  // 累計重算的高度取樣數
+bool cKeyPressed = false;
+
+// --- VTF (vertex texture fetch) 地形 ---
+// 整張 heightmap 平滑、拉伸後的高度 (R16，同 PackedTerrainVertex 的量化) 與八面體編碼法線
+// (RG8_SNORM) 各一張紋理。區塊只差在取樣起點，所以全部共用一個沒有頂點屬性、只綁了
+// gridEBO 的 VAO，shader 依 gl_VertexID 取樣。超出圖片的部分跟 get_mirrored_coord 一樣鏡像。
+// 同一份高度 / 法線也留在 CPU 上擺放植被，不必再為每個區塊建網格。
+GLuint terrainHeightTex = 0, terrainNormalTex = 0, vtfVAO = 0;
+std::vector<float> terrainHeights, terrainNormalY;
+
+// 地形繪製方式 (C 鍵輪替)：clipmap、VTF 區塊、各自有 VBO 的區塊 (第一次切到時才建網格)
+enum class TerrainMode { CLIPMAP = 0, VTF = 1, MESH = 2 };
+TerrainMode terrainMode = TerrainMode::CLIPMAP;
+const char *terrainModeNames[] = { "clipmap", "vtf chunks", "mesh chunks" };
+
 GLFWwindow *window;
 Camera camera(glm::vec3(originX, 60.0f, originY));
 
@@ -85,23 +145,34 @@ void render(std::vector<GLuint> &map_chunks, Shader &shader, glm::mat4 &view, gl
 void load_heightmap_image(const char* path);
 unsigned int loadTexture(const char* path);
 int load_model(GLuint &VAO, std::string filename);
-void setup_instancing(std::vector<GLuint> &plant_chunk, std::string plant_type, std::vector<plant> &plants, std::string filename, int &vCount);
+void upload_slot_instances(int slot, std::vector<GLuint> &plant_chunk, std::vector<GLuint> &offsetVBOs,
+                           std::vector<int> &counts, const std::vector<float> &offsets, const std::string &filename, int &vCount);
 void generate_map_chunk(GLuint &VAO, int xOffset, int yOffset, std::vector<plant> &plants);
 void generate_water_chunk(GLuint &VAO, int &indexCount);
 
 std::vector<int> generate_indices();
 std::vector<float> generate_noise_map(int xOffset, int yOffset);
 std::vector<float> generate_vertices(const std::vector<float> &noise_map);
-std::vector<float> generate_normals(const std::vector<int> &indices, const std::vector<float> &vertices);
+std::vector<float> generate_height_apron(const std::vector<float> &vertices, int xOffset, int yOffset);
+std::vector<float> generate_normals(const std::vector<float> &apron);
 std::vector<float> generate_biome(const std::vector<float> &vertices, const std::vector<float> &normals, std::vector<plant> &plants, int xOffset, int yOffset);
+void maybe_place_plant(float x, float h, float z, float normalY, int xOffset, int yOffset, std::vector<plant> &plants);
 void initMinimap();
 void drawMinimap(Shader &shader);
 void applyTimeOfDay(Shader &shader);
 void drawFullMap(Shader &shader);
+void init_clipmap();
+void init_terrain_textures();
+void place_chunk_plants(int xOffset, int yOffset, std::vector<plant> &plants);
+void bind_grid_index_buffer();
+int chunk_slot(int x, int y);
+glm::ivec2 camera_chunk();
+void stream_chunks(std::vector<GLuint> &map_chunks, std::vector<GLuint> &tree_chunks, std::vector<GLuint> &flower_chunks, int budget);
+void update_clipmap(const glm::vec3 &camPos);
+void draw_clipmap(Shader &shader);
 
 // --- 主程式 ---
 int main() {
-    srand(static_cast<unsigned int>(time(NULL)));
     if (init() != 0) return -1;
 
     // 1. 載入資源
@@ -129,28 +200,36 @@ int main() {
 
     // 3. 生成地形
     std::cout << "Generating Terrain..." << std::endl;
-    std::vector<GLuint> map_chunks(xMapChunks * yMapChunks);
-    std::vector<plant> plants;
-    
-    for (int y = 0; y < yMapChunks; y++)
-        for (int x = 0; x < xMapChunks; x++) {
-            generate_map_chunk(map_chunks[x + y*xMapChunks], x, y, plants);
-        }
+    std::vector<GLuint> map_chunks(xMapChunks * yMapChunks, 0);   // MESH 模式才建立
+    init_terrain_textures();
 
-    // 4. 生成植被 (Instancing)
+    // 4. 生成植被 (Instancing)：視距內的區塊一次建好，之後由 stream_chunks 隨相機補上
     std::cout << "Generating Vegetation..." << std::endl;
     std::vector<GLuint> tree_chunks(xMapChunks * yMapChunks, 0);
     std::vector<GLuint> flower_chunks(xMapChunks * yMapChunks, 0);
-       
-    setup_instancing(tree_chunks, "tree", plants, "obj/CommonTree_1.obj", treeVCount);
-    setup_instancing(flower_chunks, "flower", plants, "obj/Flowers.obj", flowerVCount);
+    stream_chunks(map_chunks, tree_chunks, flower_chunks, INT_MAX);
 
     // 5. 生成水面
     GLuint waterVAO;
     int waterIndicesCount;
     generate_water_chunk(waterVAO, waterIndicesCount);
 
-    int nIndices = chunkWidth * chunkHeight * 6;
+    init_clipmap();
+    update_clipmap(camera.Position);
+
+    int nIndices = (int)gridIndices.size();
+    // 地形頂點顯存：原本每頂點 位置+UV 20 + 法線 12 + 顏色 12 bytes，且多一列頂點
+    size_t oldBytes = (size_t)chunkWidth * (chunkHeight + 1) * 44, newBytes = (size_t)chunkWidth * chunkHeight * sizeof(PackedTerrainVertex);
+    std::cout << "[Info] Terrain vertex VRAM: " << oldBytes * map_chunks.size() / 1e6 << " MB -> "
+              << newBytes * map_chunks.size() / 1e6 << " MB (" << oldBytes / 1024 << " KB -> " << newBytes / 1024
+              << " KB fetched per drawn chunk)" << std::endl;
+    std::cout << "[Info] VTF terrain: " << terrainHeights.size() * 4 / 1e6 << " MB of height / normal textures for every "
+              << "chunk, no per-chunk meshes" << std::endl;
+    long chunkTriangles = (long)(2 * chunk_render_distance + 1) * (2 * chunk_render_distance + 1) * nIndices / 3;
+    long clipTriangles = (long)(clipFullCount + (CLIP_LEVELS - 1) * clipRingCount) / 3;
+    std::cout << "[Info] Clipmap: " << CLIP_LEVELS << " levels x " << (CLIP_N + 1) << "^2 vertices, " << clipTriangles
+              << " triangles per frame (chunks in view distance: up to " << chunkTriangles << "), "
+              << clipUploadedSamples << " height samples at start" << std::endl;
     std::cout << "Initialization Complete." << std::endl;
 
     // --- Render Loop ---
@@ -160,6 +239,7 @@ int main() {
         lastFrame = currentFrame;
 
         processInput(window, objectShader);
+        if (terrainMode == TerrainMode::CLIPMAP) update_clipmap(camera.Position);
         glClearColor(gSkyColor.r, gSkyColor.g, gSkyColor.b, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -193,9 +273,11 @@ int main() {
 }
 
 // --- 地形相關函式 ---
+// 以 2 * maxVal 為週期的鏡像，每次翻轉都重複邊緣 (同 GL_MIRRORED_REPEAT)；負座標也照週期算，
+// 不然 -1 會對到 1 而不是 0，世界邊緣的平滑高度就和其他週期的接縫不一致
 int get_mirrored_coord(int coord, int maxVal) {
     int cycle = 2 * maxVal;
-    int val = std::abs(coord) % cycle;
+    int val = (coord % cycle + cycle) % cycle;
     if (val >= maxVal) val = cycle - 1 - val;
     return val;
 }
@@ -230,16 +312,18 @@ std::vector<float> generate_noise_map(int xOffset, int yOffset) {
     return noiseValues;
 }
 
+// 高度非線性拉伸
+float terrain_height(float rawVal) {
+    rawVal = std::max(0.0f, rawVal - 0.08f);
+    return std::pow(rawVal, 2.0f) * meshHeight;
+}
+
 std::vector<float> generate_vertices(const std::vector<float> &noise_map) {
     std::vector<float> v;
     for (int y = 0; y < chunkHeight + 1; y++) {
         for (int x = 0; x < chunkWidth; x++) {
             v.push_back((float)x);
-            // 高度非線性拉伸
-            float rawVal = noise_map[x + y*chunkWidth];
-            rawVal = std::max(0.0f, rawVal - 0.08f);
-            float h = std::pow(rawVal, 2.0f) * meshHeight;
-            v.push_back(h);
+            v.push_back(terrain_height(noise_map[x + y*chunkWidth]));
             v.push_back((float)y);
             // UV 座標
             v.push_back((float)x / (float)chunkWidth);
@@ -258,39 +342,102 @@ std::vector<float> generate_biome(const std::vector<float> &vertices, const std:
         float normalY = normals[(i/5)*3 + 1]; // 法線 Y 分量
         
         colors.push_back(1.0f); colors.push_back(1.0f); colors.push_back(1.0f);
+        maybe_place_plant(vertices[i], h, vertices[i + 2], normalY, xOffset, yOffset, plants);
+    }
+    return colors;
+}
 
-        // 1. 高度 > 11.4: 高於水面
-        // 2. h < 70.0: 低於林木線 (避免長在雪山上)
-        // 3. normalY > 0.6: 僅在平緩處生長
-        if (h > 11.4f && h < 70.0f && normalY > 0.6f) {
+// 植被的骰子：由區塊座標與區塊內頂點座標算出的 splitmix64，不用全域 rand()。
+// 同一個頂點不管在哪一格、第幾次串流進來都擲出同樣的結果，區塊被回收再建時植被也不變
+static uint64_t plant_roll(int xOffset, int yOffset, int x, int y) {
+    uint64_t z = ((uint64_t)(uint32_t)xOffset << 32 | (uint32_t)yOffset) * 0x9E3779B97F4A7C15ull +
+                 ((uint64_t)(uint32_t)x << 32 | (uint32_t)y);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
 
-            // 機率控制 (目前約 0.5% 機率，可依需求微調)
-            if ((rand() % 100000) < 15) { 
-                std::string type = (rand() % 10 < 4) ? "tree" : "flower";
-                plants.emplace_back(type, vertices[i], h, vertices[i+2], xOffset, yOffset);
-            }
+// 植被生成條件，generate_biome 與 place_chunk_plants 共用
+void maybe_place_plant(float x, float h, float z, float normalY, int xOffset, int yOffset, std::vector<plant> &plants) {
+    // 1. 高度 > 11.4: 高於水面
+    // 2. h < 70.0: 低於林木線 (避免長在雪山上)
+    // 3. normalY > 0.6: 僅在平緩處生長
+    if (h > 11.4f && h < 70.0f && normalY > 0.6f) {
+
+        // 機率控制 (目前約 0.5% 機率，可依需求微調)
+        uint64_t roll = plant_roll(xOffset, yOffset, (int)x, (int)z);
+        if ((roll % 100000) < 15) {
+            std::string type = (roll / 100000 % 10 < 4) ? "tree" : "flower";
+            plants.emplace_back(type, x, h, z, xOffset, yOffset);
         }
     }
-    return colors;
 }
 
-std::vector<float> generate_normals(const std::vector<int> &indices, const std::vector<float> &vertices) {
-    std::vector<float> normals;
-    std::vector<glm::vec3> tempNormals(vertices.size() / 5, glm::vec3(0.0f));
-    
-    for (int i = 0; i < indices.size(); i += 3) {
-        int i1 = indices[i], i2 = indices[i+1], i3 = indices[i+2];
-        glm::vec3 v1(vertices[i1*5], vertices[i1*5+1], vertices[i1*5+2]);
-        glm::vec3 v2(vertices[i2*5], vertices[i2*5+1], vertices[i2*5+2]);
-        glm::vec3 v3(vertices[i3*5], vertices[i3*5+1], vertices[i3*5+2]);
-        
-        // 計算面法線
-        glm::vec3 norm = glm::cross(v2 - v1, v3 - v1);
-        tempNormals[i1] += norm; tempNormals[i2] += norm; tempNormals[i3] += norm;
+// 含一圈鄰居 (apron) 的高度場：generate_vertices 的 chunkWidth x (chunkHeight + 1) 個頂點，
+// 四周再各多一個頂點，從相鄰區塊的位置取 heightmap。寬 chunkWidth + 2，高 chunkHeight + 3，
+// 頂點 (x, y) 存在 [(x + 1) + (y + 1) * (chunkWidth + 2)]。
+std::vector<float> generate_height_apron(const std::vector<float> &vertices, int xOffset, int yOffset) {
+    const int aw = chunkWidth + 2, ah = chunkHeight + 3;
+    std::vector<float> apron(aw * ah);
+    for (int y = -1; y <= chunkHeight + 1; y++) {
+        for (int x = -1; x <= chunkWidth; x++) {
+            float h;
+            if (x >= 0 && x < chunkWidth && y >= 0 && y <= chunkHeight)
+                h = vertices[(x + y * chunkWidth) * 5 + 1];
+            else if (heightMapData)
+                h = terrain_height(get_smooth_height(x + xOffset * (chunkWidth - 1), y + yOffset * (chunkHeight - 1)));
+            else
+                h = terrain_height(0.0f);
+            apron[(x + 1) + (y + 1) * aw] = h;
+        }
     }
-    for (auto& n : tempNormals) {
-        n = glm::normalize(n);
-        normals.push_back(n.x); normals.push_back(n.y); normals.push_back(n.z);
+    return apron;
+}
+
+// 中央差分法線：n = normalize(h左 - h右, 2, h前 - h後)。
+// 邊界頂點的鄰居取自 apron，所以接縫兩側的法線完全一樣，不會有光照接縫。
+// 一次算 4 個頂點 (SSE2 / NEON)，剩下的用純量補完。
+std::vector<float> generate_normals(const std::vector<float> &apron) {
+    const int aw = chunkWidth + 2, rows = chunkHeight + 1;
+    std::vector<float> normals(chunkWidth * rows * 3);
+    for (int y = 0; y < rows; y++) {
+        const float *back = &apron[y * aw + 1], *mid = &apron[(y + 1) * aw + 1], *front = &apron[(y + 2) * aw + 1];
+        float *out = &normals[y * chunkWidth * 3];
+        int x = 0;
+#if defined(__SSE2__) || (defined(__ARM_NEON) && defined(__aarch64__))
+        for (; x + 4 <= chunkWidth; x += 4) {
+            float nx[4], ny[4], nz[4];
+#if defined(__SSE2__)
+            __m128 dx = _mm_sub_ps(_mm_loadu_ps(mid + x - 1), _mm_loadu_ps(mid + x + 1));
+            __m128 dz = _mm_sub_ps(_mm_loadu_ps(back + x), _mm_loadu_ps(front + x));
+            __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz)), _mm_set1_ps(4.0f)));
+            __m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), len);
+            _mm_storeu_ps(nx, _mm_mul_ps(dx, inv));
+            _mm_storeu_ps(ny, _mm_add_ps(inv, inv));
+            _mm_storeu_ps(nz, _mm_mul_ps(dz, inv));
+#else
+            float32x4_t dx = vsubq_f32(vld1q_f32(mid + x - 1), vld1q_f32(mid + x + 1));
+            float32x4_t dz = vsubq_f32(vld1q_f32(back + x), vld1q_f32(front + x));
+            float32x4_t len = vsqrtq_f32(vaddq_f32(vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dz, dz)), vdupq_n_f32(4.0f)));
+            float32x4_t inv = vdivq_f32(vdupq_n_f32(1.0f), len);
+            vst1q_f32(nx, vmulq_f32(dx, inv));
+            vst1q_f32(ny, vaddq_f32(inv, inv));
+            vst1q_f32(nz, vmulq_f32(dz, inv));
+#endif
+            for (int k = 0; k < 4; k++) {
+                out[(x + k) * 3 + 0] = nx[k];
+                out[(x + k) * 3 + 1] = ny[k];
+                out[(x + k) * 3 + 2] = nz[k];
+            }
+        }
+#endif
+        for (; x < chunkWidth; x++) {
+            float dx = mid[x - 1] - mid[x + 1], dz = back[x] - front[x];
+            float inv = 1.0f / std::sqrt(dx * dx + dz * dz + 4.0f);
+            out[x * 3 + 0] = dx * inv;
+            out[x * 3 + 1] = 2.0f * inv;
+            out[x * 3 + 2] = dz * inv;
+        }
     }
     return normals;
 }
@@ -341,30 +488,50 @@ void render(std::vector<GLuint> &map_chunks, Shader &shader, glm::mat4 &view, gl
     glActiveTexture(GL_TEXTURE4); glBindTexture(GL_TEXTURE_2D, rockTex);  shader.setInt("rockTex", 4);
     glActiveTexture(GL_TEXTURE5); glBindTexture(GL_TEXTURE_2D, snowTex);  shader.setInt("snowTex", 5);
 
-    // 計算當前相機所在的區塊座標
-    int gridPosX = (int)(camera.Position.x - originX) / chunkWidth + xMapChunks / 2;
-    int gridPosY = (int)(camera.Position.z - originY) / chunkHeight + yMapChunks / 2;
+    // 計算當前相機所在的區塊座標，補上視距內還沒建的區塊
+    glm::ivec2 gridPos = camera_chunk();
+    stream_chunks(map_chunks, tree_chunks, flower_chunks, STREAM_CHUNKS_PER_FRAME);
     float chunkRadius = chunkWidth * 0.8f; 
+    shader.setInt("u_gridWidth", chunkWidth);
+    shader.setVec3("u_gridSize", glm::vec3((float)chunkWidth, meshHeight, (float)chunkHeight));
+    if (terrainMode == TerrainMode::CLIPMAP) draw_clipmap(shader);
+
+    if (terrainMode == TerrainMode::VTF) {
+        glActiveTexture(GL_TEXTURE8); glBindTexture(GL_TEXTURE_2D, terrainHeightTex); shader.setInt("u_heightTex", 8);
+        glActiveTexture(GL_TEXTURE9); glBindTexture(GL_TEXTURE_2D, terrainNormalTex); shader.setInt("u_normalTex", 9);
+    }
 
     // --- Pass 1: 地形與植被 ---
-    for (int y = 0; y < yMapChunks; y++) {
-        for (int x = 0; x < xMapChunks; x++) {
-            // 視距過濾
-            if (std::abs(gridPosX - x) > chunk_render_distance || std::abs(y - gridPosY) > chunk_render_distance) continue;
+    for (int y = gridPos.y - chunk_render_distance; y <= gridPos.y + chunk_render_distance; y++) {
+        for (int x = gridPos.x - chunk_render_distance; x <= gridPos.x + chunk_render_distance; x++) {
+            // 還沒串流進來的區塊先不畫
+            int idx = chunk_slot(x, y);
+            if (slotChunk[idx] != glm::ivec2(x, y)) continue;
 
             // 計算區塊中心點用於剔除檢查
             float cX = -chunkWidth / 2.0f + (chunkWidth - 1) * x + chunkWidth/2.0f;
             float cZ = -chunkHeight / 2.0f + (chunkHeight - 1) * y + chunkHeight/2.0f;
             if (!is_chunk_visible(glm::vec3(cX, 0, cZ), camera.Position, camera.Front, chunkRadius)) continue;
 
-            int idx = x + y * xMapChunks;
             model = glm::translate(glm::mat4(1.0f), glm::vec3(-chunkWidth / 2.0f + (chunkWidth - 1) * x, 0.0f, -chunkHeight / 2.0f + (chunkHeight - 1) * y));
             shader.setMat4("u_model", model);
             
-            // 繪製地形
-            shader.setBool("u_isTerrain", true);
-            glBindVertexArray(map_chunks[idx]);
-            glDrawElements(GL_TRIANGLES, nIndices, GL_UNSIGNED_INT, 0);
+            // 繪製地形 (clipmap 模式已經一次畫完)
+            if (terrainMode == TerrainMode::VTF) {
+                shader.setBool("u_isTerrain", true);
+                shader.setBool("u_vtfTerrain", true);
+                glUniform2i(glGetUniformLocation(shader.ID, "u_chunkSample"), x * (chunkWidth - 1), y * (chunkHeight - 1));
+                glBindVertexArray(vtfVAO);
+                glDrawElements(GL_TRIANGLES, nIndices, GL_UNSIGNED_SHORT, 0);
+                shader.setBool("u_vtfTerrain", false);
+            } else if (terrainMode == TerrainMode::MESH && slotMeshChunk[idx] == glm::ivec2(x, y)) {
+                // 網格由 stream_chunks 分幀建立，還沒建好的區塊先只畫植被
+                shader.setBool("u_isTerrain", true);
+                shader.setBool("u_packedTerrain", true);
+                glBindVertexArray(map_chunks[idx]);
+                glDrawElements(GL_TRIANGLES, nIndices, GL_UNSIGNED_SHORT, 0);
+                shader.setBool("u_packedTerrain", false);
+            }
             
             // 繪製樹木
             if (glIsVertexArray(tree_chunks[idx]) && treeInstanceCounts[idx] > 0) {
@@ -397,8 +564,10 @@ void render(std::vector<GLuint> &map_chunks, Shader &shader, glm::mat4 &view, gl
     glEnable(GL_POLYGON_OFFSET_FILL);
     glPolygonOffset(-1.0f, -1.0f);
     
+    // 水面跟著相機所在的區塊平移，永遠蓋住整個視窗
     shader.setBool("u_isTerrain", true);
-    shader.setMat4("u_model", glm::mat4(1.0f)); 
+    shader.setMat4("u_model", glm::translate(glm::mat4(1.0f),
+        glm::vec3((gridPos.x - xMapChunks / 2) * (chunkWidth - 1.0f), 0.0f, (gridPos.y - yMapChunks / 2) * (chunkHeight - 1.0f))));
     glBindVertexArray(waterVAO);
     glDrawElements(GL_TRIANGLES, waterIndices, GL_UNSIGNED_INT, 0);
 
@@ -512,52 +681,84 @@ void generate_water_chunk(GLuint &VAO, int &indexCount) {
 }
 
 // ... Instancing setup ...
-void setup_instancing(std::vector<GLuint> &plant_chunk, std::string plant_type, std::vector<plant> &plants, std::string filename, int &vCount) {
-    GLuint baseVAO;
-    vCount = load_model(baseVAO, filename); 
-    if (vCount == 0) {
-        std::cout << "[Error] Failed to load model: " << filename << std::endl;
-        return;
-    }
-
-    // 2. 準備各區塊的資料
-    std::vector<std::vector<float>> chunkInstances(xMapChunks * yMapChunks);
-    int totalPlants = 0;
-    for (const auto& p : plants) {
-        if (p.type == plant_type) {
-            int idx = p.xOffset + p.yOffset * xMapChunks;
-            // 這裡存入相對於區塊原點的座標
-            chunkInstances[idx].push_back(p.xpos); 
-            chunkInstances[idx].push_back(p.ypos);
-            chunkInstances[idx].push_back(p.zpos);
-            totalPlants++;
+// 一個槽的植被 instance：槽的 VAO 第一次有植物時才載入模型，之後換區塊只重新上傳 offset
+void upload_slot_instances(int slot, std::vector<GLuint> &plant_chunk, std::vector<GLuint> &offsetVBOs,
+                           std::vector<int> &counts, const std::vector<float> &offsets, const std::string &filename, int &vCount) {
+    counts[slot] = (int)(offsets.size() / 3);
+    if (offsets.empty() && plant_chunk[slot] == 0) return;
+
+    if (plant_chunk[slot] == 0) {
+        // 每個槽自己的 VAO (這裡為了簡單，模型對每個槽各 load 一次)
+        int n = load_model(plant_chunk[slot], filename);
+        if (n == 0) {
+            std::cout << "[Error] Failed to load model: " << filename << std::endl;
+            counts[slot] = 0;
+            return;
         }
-    }
-    std::cout << "[Debug] Type: " << plant_type << " Total Generated: " << totalPlants << std::endl;
-
-    // 3. 為每個有植物的區塊配置 Instance Buffer
-    for (int i = 0; i < xMapChunks * yMapChunks; i++) {
-        if (chunkInstances[i].empty()) continue;
-
-        if (plant_type == "tree") treeInstanceCounts[i] = chunkInstances[i].size() / 3;
-        else flowerInstanceCounts[i] = chunkInstances[i].size() / 3;
-
-        // 建立該區塊專用的 VAO，但共用模型 VBO
-        glGenVertexArrays(1, &plant_chunk[i]);
-        glBindVertexArray(plant_chunk[i]);
-
-        // 重新綁定 load_model 生成的頂點 VBO (這裡為了簡單，我們重新 load 一次但僅限於該區塊)
-        load_model(plant_chunk[i], filename); 
+        vCount = n;
 
         // 增加 Offset VBO
-        GLuint offsetVBO;
-        glGenBuffers(1, &offsetVBO);
-        glBindBuffer(GL_ARRAY_BUFFER, offsetVBO);
-        glBufferData(GL_ARRAY_BUFFER, chunkInstances[i].size() * sizeof(float), chunkInstances[i].data(), GL_STATIC_DRAW);
-
+        glGenBuffers(1, &offsetVBOs[slot]);
+        glBindBuffer(GL_ARRAY_BUFFER, offsetVBOs[slot]);
         glEnableVertexAttribArray(3); // layout 3
         glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
         glVertexAttribDivisor(3, 1); // 關鍵：每繪製一個實例才更新一次屬性
+        glBindVertexArray(0);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, offsetVBOs[slot]);
+    glBufferData(GL_ARRAY_BUFFER, offsets.size() * sizeof(float), offsets.empty() ? nullptr : offsets.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+int chunk_slot(int x, int y) {
+    int sx = x % xMapChunks, sy = y % yMapChunks;
+    return (sx < 0 ? sx + xMapChunks : sx) + (sy < 0 ? sy + yMapChunks : sy) * xMapChunks;
+}
+
+// 區塊 (x, y) 涵蓋從 -chunkWidth / 2 + (chunkWidth - 1) * x 起的 chunkWidth - 1 格
+glm::ivec2 camera_chunk() {
+    return glm::ivec2((int)std::floor((camera.Position.x + chunkWidth / 2.0f) / (chunkWidth - 1)),
+                      (int)std::floor((camera.Position.z + chunkHeight / 2.0f) / (chunkHeight - 1)));
+}
+
+// 視距內還沒放進槽的區塊由近到遠 (一圈一圈) 建立，最多 budget 個：擺植被、上傳到槽的 instance
+// buffer，槽原本的區塊就此丟掉。MESH 模式下區塊的網格也在這裡建 (一起算一個)，已經在槽裡
+// 但還沒有網格的區塊 (剛切到 MESH 模式) 也一樣照預算補建
+void stream_chunks(std::vector<GLuint> &map_chunks, std::vector<GLuint> &tree_chunks, std::vector<GLuint> &flower_chunks, int budget) {
+    const glm::ivec2 center = camera_chunk();
+    int built = 0;
+    for (int ring = 0; ring <= chunk_render_distance && built < budget; ring++) {
+        for (int y = center.y - ring; y <= center.y + ring && built < budget; y++) {
+            for (int x = center.x - ring; x <= center.x + ring && built < budget; x++) {
+                if (std::max(std::abs(x - center.x), std::abs(y - center.y)) != ring) continue;
+                int slot = chunk_slot(x, y);
+                const bool needMesh = terrainMode == TerrainMode::MESH && slotMeshChunk[slot] != glm::ivec2(x, y);
+                if (needMesh) {
+                    // 植被已經由 place_chunk_plants 擺好，這裡的丟掉
+                    std::vector<plant> unused;
+                    generate_map_chunk(map_chunks[slot], x, y, unused);
+                    slotMeshChunk[slot] = glm::ivec2(x, y);
+                }
+                if (slotChunk[slot] == glm::ivec2(x, y)) {
+                    if (needMesh) built++;
+                    continue;
+                }
+
+                std::vector<plant> plants;
+                place_chunk_plants(x, y, plants);
+                std::vector<float> trees, flowers;
+                for (const auto& p : plants) {
+                    // 這裡存入相對於區塊原點的座標
+                    std::vector<float> &offsets = p.type == "tree" ? trees : flowers;
+                    offsets.insert(offsets.end(), { p.xpos, p.ypos, p.zpos });
+                }
+                upload_slot_instances(slot, tree_chunks, treeOffsetVBOs, treeInstanceCounts, trees, "obj/CommonTree_1.obj", treeVCount);
+                upload_slot_instances(slot, flower_chunks, flowerOffsetVBOs, flowerInstanceCounts, flowers, "obj/Flowers.obj", flowerVCount);
+                slotChunk[slot] = glm::ivec2(x, y);
+                built++;
+            }
+        }
     }
 }
 
@@ -584,50 +785,260 @@ unsigned int loadTexture(const char* path) {
     return textureID;
 }
 
+// 八面體編碼 (以 +y 為中心，地形法線大多朝上)，每個分量 8 位元
+void oct_encode(const glm::vec3 &n, int8_t out[2]) {
+    float s = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    if (!(s > 0.0f)) { out[0] = out[1] = 0; return; }
+    glm::vec2 e(n.x / s, n.z / s);
+    if (n.y < 0.0f)
+        e = glm::vec2((1.0f - std::fabs(e.y)) * (e.x >= 0.0f ? 1.0f : -1.0f),
+                      (1.0f - std::fabs(e.x)) * (e.y >= 0.0f ? 1.0f : -1.0f));
+    out[0] = (int8_t)std::lround(glm::clamp(e.x, -1.0f, 1.0f) * 127.0f);
+    out[1] = (int8_t)std::lround(glm::clamp(e.y, -1.0f, 1.0f) * 127.0f);
+}
+
 void generate_map_chunk(GLuint &VAO, int xOffset, int yOffset, std::vector<plant> &plants) {
-    std::vector<int> indices = generate_indices();
     std::vector<float> noise_map = generate_noise_map(xOffset, yOffset);
     
     // 這裡調用修改後的 generate_vertices，它現在回傳 [x, y, z, u, v]
     std::vector<float> vertices = generate_vertices(noise_map); 
-    std::vector<float> normals = generate_normals(indices, vertices);
-    std::vector<float> colors = generate_biome(vertices, normals, plants, xOffset, yOffset);
+    std::vector<float> normals = generate_normals(generate_height_apron(vertices, xOffset, yOffset));
 
-    GLuint VBO[3], EBO; // 需要三個 VBO：一個給頂點+UV，一個給法線，一個給顏色
-    glGenBuffers(3, VBO);
-    glGenBuffers(1, &EBO);
-    glGenVertexArrays(1, &VAO);
+    generate_biome(vertices, normals, plants, xOffset, yOffset);
+
+    // 只有前 chunkHeight 列會被索引用到
+    std::vector<PackedTerrainVertex> packed(chunkWidth * chunkHeight);
+    for (size_t i = 0; i < packed.size(); i++) {
+        float h = std::max(0.0f, std::min(vertices[i * 5 + 1] / meshHeight, 1.0f));
+        packed[i].height = (uint16_t)std::lround(h * 65535.0f);
+        oct_encode(glm::vec3(normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2]), packed[i].normal);
+    }
+
+    // 槽已經有 VAO / VBO (串流換了區塊) 就沿用，只重新上傳資料
+    GLuint &VBO = mapChunkVBOs[chunk_slot(xOffset, yOffset)];
+    if (!VBO) glGenBuffers(1, &VBO);
+    if (!VAO) glGenVertexArrays(1, &VAO);
     
     glBindVertexArray(VAO);
     
-    // VBO[0]: 位置 + UV
-    glBindBuffer(GL_ARRAY_BUFFER, VBO[0]);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(PackedTerrainVertex), packed.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 1, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedTerrainVertex), (void*)offsetof(PackedTerrainVertex, height));
     glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(4);
-
-    // VBO[1]: 法線
-    glBindBuffer(GL_ARRAY_BUFFER, VBO[1]);
-    glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(float), normals.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glVertexAttribPointer(1, 2, GL_BYTE, GL_FALSE, sizeof(PackedTerrainVertex), (void*)offsetof(PackedTerrainVertex, normal));
     glEnableVertexAttribArray(1);
-
-    // VBO[2]: 顏色 (對應 layout location = 2)
-    glBindBuffer(GL_ARRAY_BUFFER, VBO[2]);
-    glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(float), colors.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(2);
     
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(int), indices.data(), GL_STATIC_DRAW);
+    bind_grid_index_buffer();
     
     glBindVertexArray(0);
 }
 
+// 共用索引緩衝：第一次呼叫時建立並上傳，之後只綁定到目前的 VAO
+void bind_grid_index_buffer() {
+    if (gridEBO == 0) {
+        if (gridIndices.empty()) gridIndices = generate_indices();
+        std::vector<unsigned short> narrow(gridIndices.begin(), gridIndices.end());
+        glGenBuffers(1, &gridEBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gridEBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, narrow.size() * sizeof(unsigned short), narrow.data(), GL_STATIC_DRAW);
+    } else {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gridEBO);
+    }
+}
+
+// 整張 heightmap 的高度 / 法線紋理 (見 terrainHeightTex)。法線同 generate_normals 的中央差分，
+// 鄰居用鏡像座標，所以鏡像過去的區塊只要把法線的 x / z 反號 (shader 裡做) 就和 CPU 算的一樣
+void init_terrain_textures() {
+    const int w = heightMapData ? hmWidth : 1, h = heightMapData ? hmHeight : 1;
+    terrainHeights.resize((size_t)w * h);
+    terrainNormalY.resize((size_t)w * h);
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+            terrainHeights[x + y * w] = terrain_height(heightMapData ? get_smooth_height(x, y) : 0.0f);
+
+    std::vector<uint16_t> packedHeights((size_t)w * h);
+    std::vector<int8_t> packedNormals((size_t)w * h * 2);
+    auto height = [&](int x, int y) { return terrainHeights[get_mirrored_coord(x, w) + get_mirrored_coord(y, h) * w]; };
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            size_t i = x + (size_t)y * w;
+            glm::vec3 n = glm::normalize(glm::vec3(height(x - 1, y) - height(x + 1, y), 2.0f, height(x, y - 1) - height(x, y + 1)));
+            terrainNormalY[i] = n.y;
+            oct_encode(n, &packedNormals[i * 2]);
+            float hn = std::max(0.0f, std::min(terrainHeights[i] / meshHeight, 1.0f));
+            packedHeights[i] = (uint16_t)std::lround(hn * 65535.0f);
+        }
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glGenTextures(1, &terrainHeightTex);
+    glBindTexture(GL_TEXTURE_2D, terrainHeightTex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R16, w, h, 0, GL_RED, GL_UNSIGNED_SHORT, packedHeights.data());
+    glGenTextures(1, &terrainNormalTex);
+    glBindTexture(GL_TEXTURE_2D, terrainNormalTex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8_SNORM, w, h, 0, GL_RG, GL_BYTE, packedNormals.data());
+    for (GLuint tex : { terrainHeightTex, terrainNormalTex }) {
+        glBindTexture(GL_TEXTURE_2D, tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // 所有區塊共用：沒有頂點屬性，只有索引
+    glGenVertexArrays(1, &vtfVAO);
+    glBindVertexArray(vtfVAO);
+    bind_grid_index_buffer();
+    glBindVertexArray(0);
+}
+
+// 直接從 terrainHeights / terrainNormalY 擺放一個區塊的植被，頂點順序與條件同 generate_biome
+void place_chunk_plants(int xOffset, int yOffset, std::vector<plant> &plants) {
+    const int w = heightMapData ? hmWidth : 1, h = heightMapData ? hmHeight : 1;
+    for (int y = 0; y < chunkHeight + 1; y++) {
+        for (int x = 0; x < chunkWidth; x++) {
+            size_t i = get_mirrored_coord(x + xOffset * (chunkWidth - 1), w) +
+                       (size_t)get_mirrored_coord(y + yOffset * (chunkHeight - 1), h) * w;
+            maybe_place_plant((float)x, terrainHeights[i], (float)y, terrainNormalY[i], xOffset, yOffset, plants);
+        }
+    }
+}
+
+// clipmap 一層的索引 (頂點 x + z * (CLIP_N + 1))，三角形順序同 generate_indices。
+// holeX < 0 是完整網格 (最細一層)，否則挖掉 [holeX, holeX + CLIP_N / 2) x [holeZ, ...) 的格子
+static std::vector<unsigned short> clip_grid_indices(int holeX, int holeZ) {
+    const int v = CLIP_N + 1, hole = CLIP_N / 2;
+    std::vector<unsigned short> indices;
+    for (int z = 0; z < CLIP_N; z++) {
+        for (int x = 0; x < CLIP_N; x++) {
+            if (holeX >= 0 && x >= holeX && x < holeX + hole && z >= holeZ && z < holeZ + hole) continue;
+            int pos = x + z * v;
+            indices.insert(indices.end(), { (unsigned short)pos, (unsigned short)(pos + v), (unsigned short)(pos + v + 1),
+                                            (unsigned short)pos, (unsigned short)(pos + v + 1), (unsigned short)(pos + 1) });
+        }
+    }
+    return indices;
+}
+
+// 第 l 層的高度取樣：heightmap 取樣點 (x, z) * 2^l，和區塊地形用同一個高度函式
+static float clip_sample_height(int level, int x, int z) {
+    if (!heightMapData) return terrain_height(0.0f);
+    return terrain_height(get_smooth_height(x << level, z << level));
+}
+
+// 把第 level 層座標的矩形 [x0, x0 + w) x [z0, z0 + h) 算好寫進環形紋理，跨過紋理邊界時拆成最多 4 塊
+static void upload_clip_rect(int level, int x0, int z0, int w, int h) {
+    if (w <= 0 || h <= 0) return;
+    std::vector<float> heights;
+    for (int bz = z0; bz < z0 + h;) {
+        int tz = ((bz % CLIP_TEX) + CLIP_TEX) % CLIP_TEX, ph = std::min(z0 + h - bz, CLIP_TEX - tz);
+        for (int bx = x0; bx < x0 + w;) {
+            int tx = ((bx % CLIP_TEX) + CLIP_TEX) % CLIP_TEX, pw = std::min(x0 + w - bx, CLIP_TEX - tx);
+            heights.resize((size_t)pw * ph);
+            for (int z = 0; z < ph; z++)
+                for (int x = 0; x < pw; x++)
+                    heights[x + z * pw] = clip_sample_height(level, bx + x, bz + z);
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, tx, tz, level, pw, ph, 1, GL_RED, GL_FLOAT, heights.data());
+            clipUploadedSamples += heights.size();
+            bx += pw;
+        }
+        bz += ph;
+    }
+}
+
+void init_clipmap() {
+    glGenTextures(1, &clipHeightTex);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, clipHeightTex);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R32F, CLIP_TEX, CLIP_TEX, CLIP_LEVELS, 0, GL_RED, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
+
+    // 一份索引緩衝：完整網格 + 4 種洞位置的環
+    std::vector<unsigned short> indices = clip_grid_indices(-1, -1);
+    clipFullCount = (GLsizei)indices.size();
+    for (int i = 0; i < 4; i++) {
+        std::vector<unsigned short> ring = clip_grid_indices(CLIP_N / 4 + (i & 1), CLIP_N / 4 + (i >> 1));
+        clipRingCount = (GLsizei)ring.size();
+        indices.insert(indices.end(), ring.begin(), ring.end());
+    }
+
+    // 頂點全部由 gl_VertexID 推出，VAO 不需要任何屬性
+    glGenVertexArrays(1, &clipVAO);
+    glBindVertexArray(clipVAO);
+    glGenBuffers(1, &clipEBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, clipEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), indices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+
+    for (ClipLevel &level : clipLevels) level.valid = false;
+}
+
+// 每層原點 = 相機往回半層、向下對齊到粗一層的格距 (2 格)。相鄰兩層的原點差
+// (單位為粗一層的格距) 因此只會是 CLIP_N / 4 或 CLIP_N / 4 + 1，也就是 4 種洞的位置。
+// 移動後只有進入範圍 (網格外再多一圈) 的行 / 列要重算；移太遠就整張重算。
+void update_clipmap(const glm::vec3 &camPos) {
+    // 區塊地形的取樣點 i 在世界座標 i - chunkWidth / 2
+    float camX = camPos.x + chunkWidth / 2.0f, camZ = camPos.z + chunkHeight / 2.0f;
+    glBindTexture(GL_TEXTURE_2D_ARRAY, clipHeightTex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    for (int l = 0; l < CLIP_LEVELS; l++) {
+        float s = (float)(1 << l);
+        int ox = 2 * (int)std::floor((camX / s - CLIP_N / 2) / 2.0f);
+        int oz = 2 * (int)std::floor((camZ / s - CLIP_N / 2) / 2.0f);
+        ClipLevel &level = clipLevels[l];
+        const int span = CLIP_N + 3;   // 覆蓋 [origin - 1, origin + CLIP_N + 1]
+        if (level.valid && ox == level.originX && oz == level.originZ) continue;
+
+        int dx = ox - level.originX, dz = oz - level.originZ;
+        if (!level.valid || std::abs(dx) >= span || std::abs(dz) >= span) {
+            upload_clip_rect(l, ox - 1, oz - 1, span, span);
+        } else {
+            // 新進入的列 (x 方向)，整個新的 z 範圍
+            if (dx > 0) upload_clip_rect(l, level.originX - 1 + span, oz - 1, dx, span);
+            else if (dx < 0) upload_clip_rect(l, ox - 1, oz - 1, -dx, span);
+            // 新進入的行 (z 方向)，扣掉上面已經寫過的列
+            int x0 = dx > 0 ? ox - 1 : ox - 1 - dx, w = span - std::abs(dx);
+            if (dz > 0) upload_clip_rect(l, x0, level.originZ - 1 + span, w, dz);
+            else if (dz < 0) upload_clip_rect(l, x0, oz - 1, w, -dz);
+        }
+        level.originX = ox;
+        level.originZ = oz;
+        level.valid = true;
+    }
+}
+
+void draw_clipmap(Shader &shader) {
+    glActiveTexture(GL_TEXTURE7);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, clipHeightTex);
+    shader.setInt("u_clipHeights", 7);
+    shader.setInt("u_clipN", CLIP_N);
+    shader.setBool("u_isTerrain", true);
+    shader.setBool("u_clipmap", true);
+    // 取樣點 i 的世界座標
+    shader.setVec2("u_clipWorldOffset", glm::vec2(-chunkWidth / 2.0f, -chunkHeight / 2.0f));
+    glBindVertexArray(clipVAO);
+    for (int l = 0; l < CLIP_LEVELS; l++) {
+        shader.setInt("u_clipLevel", l);
+        shader.setInt("u_clipSpacing", 1 << l);
+        glUniform2i(glGetUniformLocation(shader.ID, "u_clipOrigin"), clipLevels[l].originX, clipLevels[l].originZ);
+        // 最外層沒有更粗的一層可以接，不需要過渡帶
+        shader.setFloat("u_clipMorphWidth", l + 1 < CLIP_LEVELS ? CLIP_N / 10.0f : 0.0f);
+        if (l == 0) {
+            glDrawElements(GL_TRIANGLES, clipFullCount, GL_UNSIGNED_SHORT, 0);
+        } else {
+            // 細一層原點相對這層的位置 (這層的格距)，減去 CLIP_N / 4 就是洞的種類
+            int hx = clipLevels[l - 1].originX / 2 - clipLevels[l].originX - CLIP_N / 4;
+            int hz = clipLevels[l - 1].originZ / 2 - clipLevels[l].originZ - CLIP_N / 4;
+            size_t first = (size_t)clipFullCount + (size_t)(hx + 2 * hz) * clipRingCount;
+            glDrawElements(GL_TRIANGLES, clipRingCount, GL_UNSIGNED_SHORT, (void*)(first * sizeof(unsigned short)));
+        }
+    }
+    shader.setBool("u_clipmap", false);
+    glBindVertexArray(0);
+    glActiveTexture(GL_TEXTURE0);
+}
+
 void initMinimap() {
     glGenTextures(1, &minimapTexture);
     glBindTexture(GL_TEXTURE_2D, minimapTexture);
@@ -900,6 +1311,17 @@ void processInput(GLFWwindow *window, Shader &shader) {
         gTimeOfDay = TimeOfDay::DAWN;
         applyTimeOfDay(shader);
     }
+    // C 鍵：輪替地形繪製方式 (clipmap -> VTF 區塊 -> 網格區塊)
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS) {
+        if (!cKeyPressed) {
+            terrainMode = (TerrainMode)(((int)terrainMode + 1) % 3);
+            if (terrainMode == TerrainMode::CLIPMAP) update_clipmap(camera.Position);
+            std::cout << "[Info] Terrain: " << terrainModeNames[(int)terrainMode] << std::endl;
+            cKeyPressed = true;
+        }
+    } else {
+        cKeyPressed = false;
+    }
     if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS) {
         if (!mKeyPressed) {
             showFullMap = !showFullMap;
@@ -18,6 +18,50 @@ uniform float u_plantScale;// 植被縮放控制
 // [新增] UI 模式開關
 uniform bool u_isUI;
 
+// 壓縮地形頂點 (見 main.cpp 的 generate_map_chunk)：aPos.x 是 16 位元正規化高度，
+// x / z 由 gl_VertexID 推出，aNormal.xy 是八面體編碼的法線 (-127 ~ 127)，UV 由 x / z 算出
+uniform bool u_packedTerrain;
+uniform int u_gridWidth;
+uniform vec3 u_gridSize;       // (chunkWidth, 高度範圍, chunkHeight)
+
+// VTF 地形 (見 main.cpp 的 init_terrain_textures)：同樣的網格但沒有頂點屬性，高度 / 法線從
+// 整張 heightmap 的紋理讀取，取樣點 u_chunkSample + (x, z) 依 get_mirrored_coord 鏡像
+uniform bool u_vtfTerrain;
+uniform sampler2D u_heightTex;   // R16：高度 / 高度範圍
+uniform sampler2D u_normalTex;   // RG8_SNORM：八面體編碼法線
+uniform ivec2 u_chunkSample;     // 區塊第一個頂點的取樣座標
+
+// 取樣座標 c 鏡像到 [0, size)，flip = 這一段是否翻轉 (法線的分量要反號)。
+// 串流的區塊可以在負座標，GLSL 的 % 遇到負數沒有定義，所以用 floor 取週期
+int mirror_coord(int c, int size, out float flip) {
+    int v = c - 2 * size * int(floor(float(c) / float(2 * size)));
+    flip = v >= size ? -1.0 : 1.0;
+    return v >= size ? 2 * size - 1 - v : v;
+}
+
+// 幾何 clipmap (見 main.cpp 的 update_clipmap / draw_clipmap)：一層 (u_clipN + 1)^2 個頂點，
+// 位置由 gl_VertexID 推出，高度從環形紋理陣列第 u_clipLevel 張讀取 (取樣點 p 在 p mod 紋理大小)
+uniform bool u_clipmap;
+uniform sampler2DArray u_clipHeights;
+uniform int u_clipN;
+uniform int u_clipLevel;
+uniform int u_clipSpacing;       // 這層的格距 (heightmap 取樣點)
+uniform ivec2 u_clipOrigin;      // 網格左上角，單位為這層的格距
+uniform float u_clipMorphWidth;  // 外圈過渡帶寬度 (格)，0 = 不過渡
+uniform vec2 u_clipWorldOffset;  // 取樣點 i 的世界座標為 i + offset
+
+float clip_height(ivec2 p) {
+    ivec2 size = textureSize(u_clipHeights, 0).xy;
+    return texelFetch(u_clipHeights, ivec3(p & (size - 1), u_clipLevel), 0).r;
+}
+
+vec3 oct_decode(vec2 e) {
+    vec3 n = vec3(e.x, 1.0 - abs(e.x) - abs(e.y), e.y);
+    if (n.y < 0.0)
+        n.xz = (1.0 - abs(n.zx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.z >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
 void main() {
     if (u_isUI) {
         // UI 模式：直接輸出座標 (假設 aPos 已經是在螢幕座標範圍 -1~1 內)
@@ -32,6 +76,54 @@ void main() {
         Normal = vec3(0.0, 1.0, 0.0);
         Color = vec3(1.0);
     } 
+    else if (u_packedTerrain || u_vtfTerrain) {
+        ivec2 g = ivec2(gl_VertexID % u_gridWidth, gl_VertexID / u_gridWidth);
+        float h = aPos.x;
+        vec3 normal;
+        if (u_vtfTerrain) {
+            ivec2 size = textureSize(u_heightTex, 0);
+            vec2 flip;
+            ivec2 t = ivec2(mirror_coord(u_chunkSample.x + g.x, size.x, flip.x),
+                            mirror_coord(u_chunkSample.y + g.y, size.y, flip.y));
+            h = texelFetch(u_heightTex, t, 0).r;
+            normal = oct_decode(texelFetch(u_normalTex, t, 0).rg) * vec3(flip.x, 1.0, flip.y);
+        } else {
+            normal = oct_decode(clamp(aNormal.xy / 127.0, -1.0, 1.0));
+        }
+        vec3 localPos = vec3(float(g.x), h * u_gridSize.y, float(g.y));
+
+        FragPos = vec3(u_model * vec4(localPos, 1.0));
+        Normal = mat3(transpose(inverse(u_model))) * normal;
+        Color = vec3(1.0);
+        TexCoords = localPos.xz / u_gridSize.xz;
+
+        gl_Position = u_projection * u_view * vec4(FragPos, 1.0);
+    }
+    else if (u_clipmap) {
+        ivec2 g = ivec2(gl_VertexID % (u_clipN + 1), gl_VertexID / (u_clipN + 1));
+        ivec2 p = u_clipOrigin + g;
+        float h = clip_height(p);
+
+        // 外圈過渡帶：奇數頂點的高度漸漸變成粗一層 (兩旁偶數頂點的連線) 的高度，
+        // 到邊界上完全一樣，所以和粗一層之間不會有裂縫。原點是偶數，p 的奇偶就是相對粗一層的奇偶
+        if (u_clipMorphWidth > 0.0) {
+            int edge = min(min(g.x, g.y), min(u_clipN - g.x, u_clipN - g.y));
+            float alpha = clamp(1.0 - float(edge) / u_clipMorphWidth, 0.0, 1.0);
+            ivec2 odd = p & 1;
+            if (alpha > 0.0 && odd != ivec2(0))
+                h = mix(h, 0.5 * (clip_height(p - odd) + clip_height(p + odd)), alpha);
+        }
+
+        float s = float(u_clipSpacing);
+        vec2 xz = vec2(p) * s + u_clipWorldOffset;
+        FragPos = vec3(xz.x, h, xz.y);
+        Normal = normalize(vec3(clip_height(p - ivec2(1, 0)) - clip_height(p + ivec2(1, 0)), 2.0 * s,
+                                clip_height(p - ivec2(0, 1)) - clip_height(p + ivec2(0, 1))));
+        Color = vec3(1.0);
+        TexCoords = FragPos.xz / u_gridSize.xz;
+
+        gl_Position = u_projection * u_view * vec4(FragPos, 1.0);
+    }
     else {
         // --- 原本的地形/植被邏輯 ---
         vec3 scaledPos = aPos * u_plantScale;